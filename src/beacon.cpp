@@ -8,8 +8,60 @@
 
 //#define DEBUG 1
 
+#include <climits>
+#include <algorithm>
 #include "beacon.h"
 
+
+bool communicationDatabase::check( const Bounds &bounds ){
+
+	auto entries = _arity2entries.find( bounds.size() );
+	if ( entries == _arity2entries.end() ) return false;
+	if ( bounds.empty() ) return not (entries -> second).empty();
+
+	std::vector< int > value;
+	if ( exactValue( bounds, value ) ) return _entry2position.count( value ) > 0;
+
+	std::vector< int > prefix;
+	return searchRange< std::map< std::vector< int >, unsigned long > >( entries -> second, bounds, prefix, 0, NULL );
+}
+
+
+std::vector< std::vector< int > > communicationDatabase::findAll( const Bounds &bounds ){
+
+	std::vector< std::vector< int > > out;
+
+	auto entries = _arity2entries.find( bounds.size() );
+	if ( entries == _arity2entries.end() ) return out;
+
+	std::vector< int > value;
+	if ( not bounds.empty() and exactValue( bounds, value ) ){
+
+		if ( _entry2position.count( value ) > 0 ) out.push_back( value );
+		return out;
+	}
+
+	std::vector< std::pair< unsigned long, const std::vector< int > * > > matches;
+	if ( bounds.empty() ){
+
+		for ( auto e = (entries -> second).begin(); e != (entries -> second).end(); e++ ) matches.push_back( std::make_pair( e -> second, &(e -> first) ) );
+	}
+	else{
+
+		std::vector< int > prefix;
+		std::vector< std::map< std::vector< int >, unsigned long >::const_iterator > inRange;
+		searchRange( entries -> second, bounds, prefix, 0, &inRange );
+		for ( auto e = inRange.begin(); e < inRange.end(); e++ ) matches.push_back( std::make_pair( (*e) -> second, &((*e) -> first) ) );
+	}
+
+	//report matches in the order they were launched
+	std::sort( matches.begin(), matches.end() );
+	for ( auto m = matches.begin(); m < matches.end(); m++ ) out.push_back( *(m -> second) );
+	return out;
+}
+
+
+/*BEACON CHANNEL-----------------------------------------------------------------------------------------------------------------------------------------------------*/
 BeaconChannel::BeaconChannel( std::vector< std::string > name, GlobalVariables &globalVars ){
 
 	_channelName = name;
@@ -17,45 +69,132 @@ BeaconChannel::BeaconChannel( std::vector< std::string > name, GlobalVariables &
 }
 
 
-std::vector< std::string > BeaconChannel::getChannelName(void){ return _channelName;}
+Bounds BeaconChannel::evaluateBounds( MessageReceiveBlock *mrb, ParameterValues &param2value, VariableFrame &localVariables ){
+//evaluate the set expression for each dimension of a receive to sorted, disjoint bounds
+
+	const std::vector< Bytecode > &setExpressions = mrb -> getSetExpression();
+	Bounds bounds;
+	for ( unsigned int i = 0; i < setExpressions.size(); i++ ){
+
+		if ( mrb -> usesSets() ) bounds.push_back( condenseToDisjoint( evalRPN_set( setExpressions[i], param2value, _globalVars, localVariables ) ) );
+		else{
+
+			//there's only one value that the beacon can check
+			Numerical n = evalRPN_numerical( setExpressions[i], param2value, _globalVars, localVariables );
+			if (not n.isInt()) throw SyntaxError(setExpressions[i].rpn()[0], "Set expressions must evaluate to ints, not floats.");
+			bounds.push_back( std::vector< std::pair<int, int> >( 1, std::make_pair( n.getInt(), n.getInt() ) ) );
+		}
+	}
+	return bounds;
+}
+
+
+void BeaconChannel::subscribe( std::shared_ptr<Candidate> cand, const std::shared_ptr< const Bounds > &bounds, bool active, bool evaluated ){
+
+	std::list< std::shared_ptr<BeaconSubscription> > &subscriptions = _subscriptions[cand -> processInSystem];
+
+	std::shared_ptr<BeaconSubscription> s = std::make_shared<BeaconSubscription>();
+	s -> candidate = cand;
+	s -> bounds = bounds;
+	s -> evaluated = evaluated;
+	s -> active = active;
+	s -> order = _subscriptionOrder++;
+	s -> position = subscriptions.insert( subscriptions.end(), s );
+
+	if ( evaluated ) s -> filing = _subscriptionIndex.insert( s.get(), *bounds );
+	else{
+
+		std::list< BeaconSubscription * > &waiting = _unevaluated[ static_cast< MessageReceiveBlock * >( cand -> actionCandidate ) -> getSetExpression().size() ];
+		s -> filedUnevaluated = waiting.insert( waiting.end(), s.get() );
+	}
+}
+
+
+void BeaconChannel::unfile( BeaconSubscription *s ){
+
+	if ( s -> evaluated ) _subscriptionIndex.erase( s -> filing );
+	else _unevaluated[ static_cast< MessageReceiveBlock * >( s -> candidate -> actionCandidate ) -> getSetExpression().size() ].erase( s -> filedUnevaluated );
+}
+
+
+void BeaconChannel::reorder( BeaconSubscription *s ){
+//move a subscription to the back of the active or potential receives, keeping its process's subscriptions in order
+
+	std::list< std::shared_ptr<BeaconSubscription> > &subscriptions = _subscriptions[s -> candidate -> processInSystem];
+	subscriptions.splice( subscriptions.end(), subscriptions, s -> position );
+	s -> order = _subscriptionOrder++;
+}
+
+
+void BeaconChannel::unsubscribe( BeaconSubscription *s ){
+
+	unfile( s );
+	_subscriptions[s -> candidate -> processInSystem].erase( s -> position );
+}
+
+
+void BeaconChannel::activateMatches( MessageReceiveBlock *mrb, SystemProcess *sp, ParameterValues &param2value, const std::shared_ptr< const ParallelContinuation > &parallelContinuations, const std::shared_ptr< const Bounds > &bounds, const std::vector< std::vector< int > > &matchingParameters, TransitionScheduler &scheduler ){
+//build a candidate for each possible beacon receive on this parameter set
+
+	for ( auto mp = matchingParameters.begin(); mp < matchingParameters.end(); mp++ ){
 
+		//if we have binding variables, we're allowed to use it in the rate evaluation
+		VariableFrame augmentedLocalVars = sp -> localVariables;
+		std::vector<Numerical> newRangeEval;
+		if ( mrb -> bindsVariable() ){
 
-void BeaconChannel::addCandidate( Block *b, SystemProcess *sp, std::list< SystemProcess > parallelProcesses, ParameterValues &currentParameters, int &candidatesLeft, double &rateSum ){
-//returns a bool of whether the candidate was added (if false, it has been added to potential receives)
+			const std::vector< unsigned int > &bindingSlots = mrb -> getBindingSlots();
+			for ( unsigned int i = 0; i < bindingSlots.size(); i++ ){
+
+				Numerical n;
+				n.setInt((*mp)[i]);
+				newRangeEval.push_back(n);
+				augmentedLocalVars.updateValue( bindingSlots[i], n );
+			}
+		}
+
+		Numerical rate = evalRPN_numerical( mrb -> getRate(), param2value, _globalVars, augmentedLocalVars );
+		if ( rate.doubleCast() <= 0 ) throw BadRate( mrb -> getToken() );
+		std::shared_ptr<Candidate> cand( new Candidate(mrb, param2value, augmentedLocalVars, sp, parallelContinuations) );
+		cand -> rate = rate.doubleCast() * sp -> count;
+		cand -> rangeEvaluation = newRangeEval;
+		subscribe( cand, bounds, true, true );
+		scheduler.add( cand, this );
+	}
+}
+
+
+void BeaconChannel::addCandidate( Block *b, SystemProcess *sp, const std::shared_ptr< const ParallelContinuation > &parallelContinuations, ParameterValues &currentParameters, TransitionScheduler &scheduler ){
 
 #if DEBUG
 std::cout << std::endl;
 _database.printContents();
 #endif
 
-	if ( b -> identify() == "MessageReceive" ){
+	if ( b -> kind() == BLOCK_MESSAGE_RECEIVE ){
 
-		MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >( b );
+		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( b );
 
 		if ( mrb -> isCheck() ){
 
 			//build the candidate
-			std::shared_ptr<Candidate> cand( new Candidate( mrb, currentParameters, sp -> localVariables, sp, parallelProcesses) );
+			std::shared_ptr<Candidate> cand( new Candidate( mrb, currentParameters, sp -> localVariables, sp, parallelContinuations) );
 			Numerical rate = evalRPN_numerical( b -> getRate(), currentParameters, _globalVars, sp -> localVariables );
 			if ( rate.doubleCast() <= 0 ) throw BadRate( b -> getToken() );
-			cand -> rate = rate.doubleCast();
+			cand -> rate = rate.doubleCast() * sp -> count;
 
-			std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
-			bool canReceive;
-			if (mrb -> usesSets()){
-				canReceive = _database.check( setExpressions, currentParameters, _globalVars, sp -> localVariables );
-			}
-			else{
-				canReceive = _database.check_quick( setExpressions, currentParameters, _globalVars, sp -> localVariables );
-			}
+			//set expressions are only evaluated once there are beacons they could match, as they might not be valid before then
+			bool evaluated = _database.hasArity( mrb -> getSetExpression().size() );
+			std::shared_ptr< const Bounds > bounds;
+			if ( evaluated ) bounds = std::make_shared< const Bounds >( evaluateBounds( mrb, currentParameters, sp -> localVariables ) );
+			bool canReceive = evaluated and _database.check( *bounds );
 
 			if ( not canReceive ){//only do a beacon check if you can't receive
 
-				_activeBeaconReceiveCands[sp].push_back( cand );
-				candidatesLeft++;
-				rateSum += rate.doubleCast();
+				subscribe( cand, bounds, true, evaluated );
+				scheduler.add( cand, this );
 			}
-			else _potentialBeaconReceiveCands[sp].push_back( cand );
+			else subscribe( cand, bounds, false, evaluated );
 
 #if DEBUG
 std::cout << ">>>>>>>>>>>>Adding candidate: Beacon check ";
@@ -67,48 +206,21 @@ std::cout << ">>>>>>>>>>>>Can receive? " << canReceive << std::endl;
 		}
 		else if ( not mrb -> isHandshake() ){ //beacon receive
 
-			std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
+			bool evaluated = _database.hasArity( mrb -> getSetExpression().size() );
+			std::shared_ptr< const Bounds > bounds;
 			std::vector< std::vector< int > > matchingParameters;
-			if (mrb -> usesSets()){
-				matchingParameters = _database.findAll( setExpressions, currentParameters, _globalVars, sp -> localVariables );
-			}
-			else{
-				matchingParameters = _database.findAll_trivial( setExpressions, currentParameters, _globalVars, sp -> localVariables );
-			}
+			if ( evaluated ){
 
-			//build a candidate for each possible beacon receive on this parameter set
-			for ( auto mp = matchingParameters.begin(); mp < matchingParameters.end(); mp++ ){
-
-				//if we have binding variables, we're allowed to use it in the rate evaluation
-				std::map< std::string, Numerical > augmentedLocalVars = sp -> localVariables;
-				std::vector<Numerical> newRangeEval;
-				if ( mrb -> bindsVariable() ){
-
-					std::vector< std::string > bindingVarNames = mrb -> getBindingVariable();
-					for ( unsigned int i = 0; i < bindingVarNames.size(); i++ ){
-
-						Numerical n;
-						n.setInt((*mp)[i]);
-						newRangeEval.push_back(n);
-						augmentedLocalVars[ bindingVarNames[i] ] = n;
-					}
-				}
-
-				Numerical rate = evalRPN_numerical( mrb -> getRate(), currentParameters, _globalVars, augmentedLocalVars );
-				if ( rate.doubleCast() <= 0 ) throw BadRate( b -> getToken() );
-				std::shared_ptr<Candidate> cand( new Candidate(mrb, currentParameters, augmentedLocalVars, sp, parallelProcesses) );
-				cand -> rate = rate.doubleCast();
-				cand -> rangeEvaluation = newRangeEval;
-				_activeBeaconReceiveCands[sp].push_back( cand );
-				candidatesLeft++;
-				rateSum += rate.doubleCast();
+				bounds = std::make_shared< const Bounds >( evaluateBounds( mrb, currentParameters, sp -> localVariables ) );
+				matchingParameters = _database.findAll( *bounds );
 			}
+			activateMatches( mrb, sp, currentParameters, parallelContinuations, bounds, matchingParameters, scheduler );
 
-			//if the mrb can't receive and isn't already in the potential receives, add it to the potential receives
+			//if the mrb can't receive, it waits in the potential receives until a matching beacon is launched
 			if ( matchingParameters.size() == 0){
 
-				std::shared_ptr<Candidate> cand( new Candidate(mrb, currentParameters, sp -> localVariables, sp, parallelProcesses) );
-				_potentialBeaconReceiveCands[sp].push_back( cand );
+				std::shared_ptr<Candidate> cand( new Candidate(mrb, currentParameters, sp -> localVariables, sp, parallelContinuations) );
+				subscribe( cand, bounds, false, evaluated );
 			}
 
 #if DEBUG
@@ -128,17 +240,17 @@ Token *t = b -> getToken();
 std::cout << t -> value() << std::endl;
 #endif
 
-		assert( b -> identify() == "MessageSend" );
-		MessageSendBlock *msb = dynamic_cast< MessageSendBlock * >( b );
+		assert( b -> kind() == BLOCK_MESSAGE_SEND );
+		MessageSendBlock *msb = static_cast< MessageSendBlock * >( b );
 		Numerical rate = evalRPN_numerical( msb -> getRate(), currentParameters, _globalVars, sp -> localVariables );
 		if ( rate.doubleCast() <= 0 ) throw BadRate( b -> getToken() );
 
-		std::shared_ptr< Candidate > cand( new Candidate( msb, currentParameters, sp -> localVariables, sp, parallelProcesses) );
+		std::shared_ptr< Candidate > cand( new Candidate( msb, currentParameters, sp -> localVariables, sp, parallelContinuations) );
 
-		cand -> rate = rate.doubleCast();
+		cand -> rate = rate.doubleCast() * sp -> count;
 
 		//evaluate the expression
-		std::vector< std::vector< Token * > > parameterExpressions = msb -> getParameterExpression();
+		const std::vector< Bytecode > &parameterExpressions = msb -> getParameterExpression();
 		std::vector<Numerical> param;
 		for ( auto exp = parameterExpressions.begin(); exp < parameterExpressions.end(); exp++ ){
 
@@ -148,29 +260,23 @@ std::cout << t -> value() << std::endl;
 		cand -> rangeEvaluation = param;
 
 		_sendCands[sp].push_back( cand );
-		candidatesLeft++;
-		rateSum += rate.doubleCast();
+		scheduler.add( cand, this );
 	}
 }
 
 
-void BeaconChannel::cleanSPFromChannel( SystemProcess *sp, int &candidatesLeft, double &rateSum ){
-
-	//erase from potential receives
-	if ( _potentialBeaconReceiveCands.find(sp) != _potentialBeaconReceiveCands.end() ){
+void BeaconChannel::cleanSPFromChannel( SystemProcess *sp, TransitionScheduler &scheduler ){
 
-		_potentialBeaconReceiveCands.erase(_potentialBeaconReceiveCands.find(sp));
-	}
-
-	//erase from active receives
-	if ( _activeBeaconReceiveCands.find(sp) != _activeBeaconReceiveCands.end() ){
+	//erase from receives, taking the active ones out of the scheduler in the order they became active
+	auto subscriptions = _subscriptions.find( sp );
+	if ( subscriptions != _subscriptions.end() ){
 
-		for ( auto cand = _activeBeaconReceiveCands[sp].begin(); cand != _activeBeaconReceiveCands[sp].end(); cand++ ){
+		for ( auto s = (subscriptions -> second).begin(); s != (subscriptions -> second).end(); s++ ){
 
-			candidatesLeft--;
-			rateSum -= (*cand) -> rate;
+			unfile( s -> get() );
+			if ( (*s) -> active ) scheduler.remove( *((*s) -> candidate) );
 		}
-		_activeBeaconReceiveCands.erase( _activeBeaconReceiveCands.find(sp) );
+		_subscriptions.erase( subscriptions );
 	}
 
 	//erase from sends
@@ -178,46 +284,66 @@ void BeaconChannel::cleanSPFromChannel( SystemProcess *sp, int &candidatesLeft,
 
 		for ( auto cand = _sendCands[sp].begin(); cand != _sendCands[sp].end(); cand++ ){
 
-			candidatesLeft--;
-			rateSum -= (*cand) -> rate;
+			scheduler.remove( **cand );
 		}
 		_sendCands.erase( _sendCands.find(sp) );
 	}
 }
 
 
-void BeaconChannel::updateBeaconCandidates(int &candidatesLeft, double &rateSum){
+static bool sweepOrder( const BeaconSubscription *a, const BeaconSubscription *b ){
+//the order a sweep over every process's receives, and then over each process's receives in the order they were added, visits them in
+
+	SystemProcess *spA = (a -> candidate) -> processInSystem;
+	SystemProcess *spB = (b -> candidate) -> processInSystem;
+	if ( spA != spB ) return SystemProcessOrder()( spA, spB );
+	return a -> order < b -> order;
+}
+
+
+void BeaconChannel::updateBeaconCandidates( TransitionScheduler &scheduler ){
+//a launch or kill can only change whether receives and checks on that beacon's value can fire, so only those are revisited
 
 #if DEBUG
 std::cout << "Updating candidates (first)...." << std::endl;
 _database.printContents();
 #endif
 
-	//move any actives that have become inactive to potential
-	for ( auto candPair = _activeBeaconReceiveCands.begin(); candPair != _activeBeaconReceiveCands.end(); candPair++ ){
+	if ( not _databaseChanged ) return;
+	_databaseChanged = false;
 
-		for ( auto cand = (candPair -> second).begin(); cand != (candPair -> second).end();){
+	//receives that were waiting for the first beacon with this many parameters can evaluate their set expressions now
+	auto waiting = _unevaluated.find( _changedEntry.size() );
+	if ( waiting != _unevaluated.end() ){
 
-			MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >( (*cand) -> actionCandidate );
-			std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
-			SystemProcess *sp = (*cand) -> processInSystem;
+		std::vector< BeaconSubscription * > toEvaluate( (waiting -> second).begin(), (waiting -> second).end() );
+		_unevaluated.erase( waiting );
+		std::sort( toEvaluate.begin(), toEvaluate.end(), sweepOrder );
+		for ( auto s = toEvaluate.begin(); s < toEvaluate.end(); s++ ){
 
-			bool canReceive;
-			if (mrb -> usesSets()){
-				canReceive = _database.check( setExpressions, sp -> parameterValues, _globalVars, sp -> localVariables );
-			}
-			else{
-				canReceive = _database.check_quick( setExpressions, sp -> parameterValues, _globalVars, sp -> localVariables );
-			}
+			Candidate &cand = *((*s) -> candidate);
+			(*s) -> bounds = std::make_shared< const Bounds >( evaluateBounds( static_cast< MessageReceiveBlock * >( cand.actionCandidate ), cand.parameterValues, cand.localVariables ) );
+			(*s) -> evaluated = true;
+			(*s) -> filing = _subscriptionIndex.insert( *s, *((*s) -> bounds) );
+		}
+	}
 
-			if ( (not canReceive and not mrb -> isCheck()) or (canReceive and mrb -> isCheck()) ){
+	std::vector< BeaconSubscription * > affected = _subscriptionIndex.stab( _changedEntry );
+	std::sort( affected.begin(), affected.end(), sweepOrder );
 
-				candidatesLeft--;
-				rateSum -= (*cand) -> rate;
-				_potentialBeaconReceiveCands[candPair -> first].push_back(*cand);
-				cand = (candPair -> second).erase(cand);
-			}
-			else cand++;
+	//move any actives that have become inactive to potential
+	for ( auto s = affected.begin(); s < affected.end(); s++ ){
+
+		if ( not (*s) -> active ) continue;
+
+		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( (*s) -> candidate -> actionCandidate );
+		bool canReceive = _database.check( *((*s) -> bounds) );
+
+		if ( (not canReceive and not mrb -> isCheck()) or (canReceive and mrb -> isCheck()) ){
+
+			scheduler.remove( *((*s) -> candidate) );
+			(*s) -> active = false;
+			reorder( *s );
 		}
 	}
 
@@ -227,73 +353,33 @@ _database.printContents();
 #endif
 
 	//move any potentials to active if they can now receive
-	for ( auto candPair = _potentialBeaconReceiveCands.begin(); candPair != _potentialBeaconReceiveCands.end(); candPair++ ){
+	std::sort( affected.begin(), affected.end(), sweepOrder );
+	for ( auto s = affected.begin(); s < affected.end(); s++ ){
 
+		if ( (*s) -> active ) continue;
 
-		for ( auto cand = (candPair -> second).begin(); cand != (candPair -> second).end();){
+		std::shared_ptr<Candidate> cand = (*s) -> candidate;
+		SystemProcess *sp = cand -> processInSystem;
+		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( cand -> actionCandidate );
 
-			SystemProcess *sp = (*cand) -> processInSystem;
-			MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >( (*cand) -> actionCandidate );
-			std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
+		if ( mrb -> isCheck() ){
 
-			bool canReceive;
-			if (mrb -> usesSets()){
-				canReceive = _database.check( setExpressions, sp -> parameterValues, _globalVars, sp -> localVariables );
-			}
-			else{
-				canReceive = _database.check_quick( setExpressions, sp -> parameterValues, _globalVars, sp -> localVariables );
-			}
+			if ( _database.check( *((*s) -> bounds) ) ) continue;
 
-			if (mrb -> isCheck() and not canReceive){
+			Numerical rate = evalRPN_numerical( mrb -> getRate(), cand -> parameterValues, _globalVars, cand -> localVariables );
+			if ( rate.doubleCast() <= 0 ) throw BadRate( mrb -> getToken() );
+			cand -> rate = rate.doubleCast() * sp -> count;
+			(*s) -> active = true;
+			reorder( *s );
+			scheduler.add( cand, this );
+		}
+		else{
 
-				_activeBeaconReceiveCands[sp].push_back(*cand);
-				Numerical rate = evalRPN_numerical( mrb -> getRate(), sp -> parameterValues, _globalVars, sp -> localVariables );
-				if ( rate.doubleCast() <= 0 ) throw BadRate( mrb -> getToken() );
-				candidatesLeft++;
-				rateSum += rate.doubleCast();
-				cand = (candPair -> second).erase(cand);
-			}
-			else if (not mrb -> isCheck()){
-
-				std::vector< std::vector< int > > matchingParameters;
-				if (mrb -> usesSets()){
-					matchingParameters = _database.findAll( setExpressions, sp -> parameterValues, _globalVars, sp -> localVariables );
-				}
-				else{
-					matchingParameters = _database.findAll_trivial( setExpressions, sp -> parameterValues, _globalVars, sp -> localVariables );
-				}
-
-				//build a candidate for each possible beacon receive on this parameter set
-				for ( auto mp = matchingParameters.begin(); mp < matchingParameters.end(); mp++ ){
-
-					//if we have binding variables, we're allowed to use it in the rate evaluation
-					std::map< std::string, Numerical > augmentedLocalVars = sp -> localVariables;
-					std::vector<Numerical> newRangeEval;
-					if ( mrb -> bindsVariable() ){
-
-						std::vector< std::string > bindingVarNames = mrb -> getBindingVariable();
-						for ( unsigned int i = 0; i < bindingVarNames.size(); i++ ){
-
-							Numerical n;
-							n.setInt((*mp)[i]);
-							newRangeEval.push_back(n);
-							augmentedLocalVars[ bindingVarNames[i] ] = n;
-						}
-					}
-
-					Numerical rate = evalRPN_numerical( mrb -> getRate(), sp -> parameterValues, _globalVars, augmentedLocalVars );
-					if ( rate.doubleCast() <= 0 ) throw BadRate( mrb -> getToken() );
-					std::shared_ptr<Candidate> newCand( new Candidate(mrb, sp -> parameterValues, augmentedLocalVars, sp, (*cand) -> parallelProcesses) );
-					newCand -> rate = rate.doubleCast();
-					newCand -> rangeEvaluation = newRangeEval;
-					_activeBeaconReceiveCands[sp].push_back( newCand );
-					candidatesLeft++;
-					rateSum += rate.doubleCast();
-				}
-				if (matchingParameters.size() > 0) cand = (candPair -> second).erase(cand);
-				else cand++;
-			}
-			else cand++;
+			std::vector< std::vector< int > > matchingParameters = _database.findAll( *((*s) -> bounds) );
+			if ( matchingParameters.empty() ) continue;
+
+			activateMatches( mrb, sp, cand -> parameterValues, cand -> parallelContinuations, (*s) -> bounds, matchingParameters, scheduler );
+			unsubscribe( *s );
 		}
 	}
 
@@ -304,71 +390,34 @@ _database.printContents();
 }
 
 
-std::shared_ptr<Candidate> BeaconChannel::pickCandidate(double &runningTotal, double uniformDraw, double rateSum){
-
-#if DEBUG
-std::cout << ">>>>>>>>>>>>Picking beacon candidate..." << std::endl;
-#endif
-
-	for ( auto candPair = _activeBeaconReceiveCands.begin(); candPair != _activeBeaconReceiveCands.end(); candPair++ ){
+void BeaconChannel::updateDatabase( std::shared_ptr<Candidate> cand ){
+//update the database for a send or kill that was chosen to fire; receives don't change the database
 
-		for ( auto cand = (candPair -> second).begin(); cand != (candPair -> second).end(); cand++ ){
+	if ( cand -> actionCandidate -> kind() != BLOCK_MESSAGE_SEND ) return;
+	MessageSendBlock *msb = static_cast< MessageSendBlock * >( cand -> actionCandidate );
+	if ( msb -> isHandshake() ) return;
 
-			double r = (*cand) -> rate;
-			double lower = runningTotal / rateSum;
-			double upper = (runningTotal + r) / rateSum;
+	SystemProcess *sp = cand -> processInSystem;
+	const std::vector< Bytecode > &parameterExpressions = msb -> getParameterExpression();
 
-			if ( uniformDraw > lower and uniformDraw <= upper ){
+	//evaluate the expression
+	std::vector<int> param;
+	for ( auto exp = parameterExpressions.begin(); exp < parameterExpressions.end(); exp++ ){
 
-				return *cand;
-			}
-			runningTotal += r;
-		}
+		Numerical paramEval = evalRPN_numerical( *exp, cand -> parameterValues, _globalVars, sp -> localVariables );
+		if (paramEval.isDouble()) throw WrongType(exp -> rpn()[0],"Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
+		param.push_back(paramEval.getInt());
 	}
 
-	for ( auto candPair = _sendCands.begin(); candPair != _sendCands.end(); candPair++ ){
-
-		for ( auto cand = (candPair -> second).begin(); cand != (candPair -> second).end(); cand++ ){
-
-			double r = (*cand) -> rate;
-			double lower = runningTotal / rateSum;
-			double upper = (runningTotal + r) / rateSum;
-
-			if ( uniformDraw > lower and uniformDraw <= upper ){
+	bool changed;
+	if ( msb -> isKill() ) changed = _database.pop( param );
+	else changed = _database.push( param );
 
-				//update the database for the send or kill that we chose
-				MessageSendBlock *msb = dynamic_cast< MessageSendBlock * >( (*cand) -> actionCandidate );
-				SystemProcess *sp = (*cand) -> processInSystem;
-				std::vector< std::vector< Token * > > parameterExpressions = msb -> getParameterExpression();
-				if ( msb -> isKill() ){
+	//remember the beacon so that the update after this transition only revisits the receives it can affect
+	if ( changed ){
 
-					//evaluate the expression
-					std::vector<int> param;
-					for ( auto exp = parameterExpressions.begin(); exp < parameterExpressions.end(); exp++ ){
-
-						Numerical paramEval = evalRPN_numerical( *exp, (*cand) -> parameterValues, _globalVars, sp -> localVariables );
-						if (paramEval.isDouble()) throw WrongType((*exp)[0],"Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-						param.push_back(paramEval.getInt());
-					}
-
-					_database.pop( param );
-				}
-				else if ( not msb -> isHandshake() ){
-
-					//evaluate the expression
-					std::vector<int> param;
-					for ( auto exp = parameterExpressions.begin(); exp < parameterExpressions.end(); exp++ ){
-
-						Numerical paramEval = evalRPN_numerical( *exp, (*cand) -> parameterValues, _globalVars, sp -> localVariables );
-						if (paramEval.isDouble()) throw WrongType((*exp)[0],"Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-						param.push_back(paramEval.getInt());
-					}
-					_database.push( param );
-				}				
-				return *cand;
-			}
-			runningTotal += r;
-		}
+		assert( not _databaseChanged );
+		_databaseChanged = true;
+		_changedEntry = param;
 	}
-	return NULL;
 }
@@ -11,168 +11,62 @@
 
 #include <map>
 #include <memory>
-#include <map>
+#include <unordered_map>
 #include <chrono>
 #include <list>
 #include <iomanip>
 #include <sstream>
 #include <iterator>
 #include "evaluate_trees.h"
+#include "intervals.h"
+#include "scheduler.h"
 
 
-struct BetweenBounds {
-
-	BetweenBounds( std::vector< std::vector< std::pair<int, int> > > i ) : i_ {i} {}
-	bool operator()(std::vector< int > i) {
-
-		for ( unsigned int dim = 0; dim < i.size(); dim++ ){ //go through dimensions
-
-			bool dimMatch = false;
-
-			for ( auto b = i_[dim].begin(); b < i_[dim].end(); b++ ){ //go through the pairs of bounds that we have
+struct TupleHash {
+//hash of a beacon's parameter tuple, mixing in one int at a time
 
-				//testing
-				//std::cout << "<<<< " << (*b).first << " " << i[dim] << " " << (*b).second << std::endl;
-
-				if ( (*b).first <= i[dim] and i[dim] <= (*b).second ){
-
-					dimMatch = true;
-					break;
-				}
-			}
+	size_t operator()( const std::vector< int > &t ) const {
 
-			if ( not dimMatch ) return false;
-		}
-
-		return true;
+		size_t h = t.size();
+		for ( auto i = t.begin(); i < t.end(); i++ ) h ^= std::hash<int>()( *i ) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+		return h;
 	}
-	std::vector< std::vector< std::pair<int, int> > > i_;
 };
 
 
 class communicationDatabase{
 
 	private:
-		std::map< int, std::vector< std::vector< int > > > _arity2entries;
-		GlobalVariables _globalVars;
-
-	public:
-		inline void push( std::vector<int> i ){
-
-			std::vector< std::vector< int > >::iterator pos = std::find(_arity2entries[i.size()].begin(),_arity2entries[i.size()].end(), i);
-			if (pos != _arity2entries[i.size()].end()) return;
-
-			if ( _arity2entries.count(i.size()) == 0 ){
-
-				_arity2entries[i.size()] = {i};
-			}			
-			else{
-
-				_arity2entries[i.size()].push_back(i);
-			}
-		}
-		inline void pop( std::vector<int> i ){
-
-			if ( _arity2entries.count( i.size() ) > 0 ){
-
-				std::vector< std::vector< int > >::iterator pos = std::find(_arity2entries[i.size()].begin(),_arity2entries[i.size()].end(), i);
-
-				if (pos != _arity2entries[i.size()].end()){
-
-					_arity2entries[i.size()].erase(pos);
-				}
-			}
-		}
-		inline bool check( std::vector< std::vector< Token * > > setExpressions, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
-
-			if (_arity2entries.count( setExpressions.size() ) == 0) return false;
-
-			std::vector< std::vector< std::pair<int, int> > > bounds;
-
-			//get the bounds for each set expression
-			for ( unsigned int i = 0; i < setExpressions.size(); i++ ){
-
-				std::vector< std::pair<int, int > > b = evalRPN_set( setExpressions[i], param2value, _globalVars, localVariables );
-				bounds.push_back(b);
-			}
-			
-			std::vector< std::vector< int > >::iterator pos = std::find_if(_arity2entries[setExpressions.size()].begin(), _arity2entries[setExpressions.size()].end(), BetweenBounds(bounds) );
-
-			if ( pos != _arity2entries[setExpressions.size()].end() ) return true;
-			else return false;
-		}
-		inline bool check_quick( std::vector< std::vector< Token * > > setExpressions, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
+		//entries of each arity in lexicographic order, so that entries in a range of the leading dimensions are contiguous, mapped to
+		//the order they were launched in, which is the order findAll reports matches in
+		std::map< int, std::map< std::vector< int >, unsigned long > > _arity2entries;
 
-			if (_arity2entries.count( setExpressions.size() ) == 0) return false;
+		//hash index from each entry to its place in the sorted entries so that launches, kills, and exact-value lookups don't search
+		std::unordered_map< std::vector< int >, std::map< std::vector< int >, unsigned long >::iterator, TupleHash > _entry2position;
+		unsigned long _launches = 0;
 
-			std::vector< int > valueToFind;
+	public:
+		//both return true if the database changed
+		inline bool push( const std::vector<int> &i ){
 
-			//get the one value that the beacon can check
-			for ( unsigned int i = 0; i < setExpressions.size(); i++ ){
+			std::map< std::vector< int >, unsigned long > &entries = _arity2entries[i.size()];
+			if ( _entry2position.count( i ) > 0 ) return false;
 
-				Numerical n = evalRPN_numerical( setExpressions[i], param2value, _globalVars, localVariables );
-				if (not n.isInt()) throw SyntaxError(setExpressions[i][0], "Set expressions must evaluate to ints, not floats.");
-				valueToFind.push_back(n.getInt());
-			}
-			
-			std::vector< std::vector< int > >::iterator pos = std::find(_arity2entries[setExpressions.size()].begin(), _arity2entries[setExpressions.size()].end(), valueToFind );
-
-			if ( pos != _arity2entries[setExpressions.size()].end() ) return true;
-			else return false;
+			_entry2position[i] = entries.insert( std::make_pair( i, _launches++ ) ).first;
+			return true;
 		}
-		inline std::vector< std::vector< int > > findAll( std::vector< std::vector< Token * > > setExpressions, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
-
-			std::vector< std::vector< int > > out;
+		inline bool pop( const std::vector<int> &i ){
 
-			if (_arity2entries.count( setExpressions.size() ) == 0) return out;
-
-			std::vector< std::vector< std::pair<int, int> > > bounds;
-
-			//get the bounds for each set expression
-			for ( unsigned int i = 0; i < setExpressions.size(); i++ ){
-
-				std::vector< std::pair<int, int > > b = evalRPN_set( setExpressions[i], param2value, _globalVars, localVariables );
-				bounds.push_back(b);
-			}
+			auto pos = _entry2position.find( i );
+			if ( pos == _entry2position.end() ) return false;
 
-			std::vector< std::vector< int > >::iterator pos = _arity2entries[setExpressions.size()].begin();
-			while (pos != _arity2entries[setExpressions.size()].end()){
-
-				pos = std::find_if(pos, _arity2entries[setExpressions.size()].end(), BetweenBounds(bounds) );
-
-				if ( pos != _arity2entries[setExpressions.size()].end() ){
-
-					out.push_back(*pos);
-					pos++;
-				}
-			}
-
-			return out;
-		}
-		inline std::vector< std::vector< int > > findAll_trivial( std::vector< std::vector< Token * > > setExpressions, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
-
-			std::vector< std::vector< int > > out;
-
-			if (_arity2entries.count( setExpressions.size() ) == 0) return out;
-
-			std::vector< int > value;
-
-			//get the one value that the beacon can check
-			for ( unsigned int i = 0; i < setExpressions.size(); i++ ){
-
-				Numerical n = evalRPN_numerical( setExpressions[i], param2value, _globalVars, localVariables );
-				if (not n.isInt()) throw SyntaxError(setExpressions[i][0], "Set expressions must evaluate to ints, not floats.");
-				value.push_back(n.getInt());
-			}
-
-			std::vector< std::vector< int > >::iterator pos = std::find(_arity2entries[setExpressions.size()].begin(), _arity2entries[setExpressions.size()].end(), value );
-
-			if ( pos != _arity2entries[setExpressions.size()].end() ){
-				out.push_back(value);
-				return out;
-			}
-			else return out;
+			_arity2entries[i.size()].erase( pos -> second );
+			_entry2position.erase( pos );
+			return true;
 		}
+		bool hasArity( unsigned int arity ) const { return _arity2entries.count( arity ) > 0; }
+		bool check( const Bounds & );
+		std::vector< std::vector< int > > findAll( const Bounds & );
 
 		void printContents( void ){ //for testing
 
@@ -180,9 +74,9 @@ class communicationDatabase{
 
 			for ( auto dbValues = _arity2entries.begin(); dbValues != _arity2entries.end(); dbValues++ ){ //go through arities	
 
-				for ( auto entry = (dbValues -> second).begin(); entry < (dbValues -> second).end(); entry++ ){
+				for ( auto entry = (dbValues -> second).begin(); entry != (dbValues -> second).end(); entry++ ){
 
-					for ( unsigned int i = 0; i < (*entry).size(); i++ ) std::cout << (*entry)[i] << " ";
+					for ( unsigned int i = 0; i < (entry -> first).size(); i++ ) std::cout << (entry -> first)[i] << " ";
 
 				}
 				std::cout << std::endl;
@@ -192,24 +86,55 @@ class communicationDatabase{
 };
 
 
+class BeaconSubscription{
+//a beacon receive or check on a channel, with its set expressions evaluated once when it was added to the channel
+
+	public:
+		std::shared_ptr<Candidate> candidate;
+		std::shared_ptr< const Bounds > bounds; //shared by every candidate built from the same receive
+		bool evaluated = true; //false until a beacon with as many parameters has been launched on the channel
+		bool active = false; //true if the candidate is in the scheduler
+		unsigned long order = 0; //when it joined the active or potential receives, which is the order a sweep over all of them visits it in
+		std::list< std::shared_ptr<BeaconSubscription> >::iterator position; //where it is in its process's subscriptions, which are kept in order
+
+		IntervalIndex< BeaconSubscription >::Filing filing; //where it is in the subscription index, once it's been evaluated
+		std::list< BeaconSubscription * >::iterator filedUnevaluated;
+};
+
+
 class BeaconChannel{
 
 	private:
 		std::vector< std::string > _channelName;
 		communicationDatabase _database;
 		GlobalVariables _globalVars;
-		std::map< SystemProcess *, std::list< std::shared_ptr<Candidate> > > _potentialBeaconReceiveCands;
-		std::map< SystemProcess *, std::list< std::shared_ptr<Candidate> > > _activeBeaconReceiveCands;
-		std::map< SystemProcess *, std::list< std::shared_ptr<Candidate> > > _sendCands;
+
+		//receives and checks for each process, both active (in the scheduler) and potential, and an index of them by the beacons they match
+		std::map< SystemProcess *, std::list< std::shared_ptr<BeaconSubscription> >, SystemProcessOrder > _subscriptions;
+		IntervalIndex< BeaconSubscription > _subscriptionIndex;
+		std::map< unsigned int, std::list< BeaconSubscription * > > _unevaluated; //by the number of parameters they receive
+		unsigned long _subscriptionOrder = 0;
+		std::map< SystemProcess *, std::list< std::shared_ptr<Candidate> >, SystemProcessOrder > _sendCands;
+
+		//the beacon launched or killed since the last update, if that changed the database
+		bool _databaseChanged = false;
+		std::vector< int > _changedEntry;
+
+		Bounds evaluateBounds( MessageReceiveBlock *, ParameterValues &, VariableFrame & );
+		void subscribe( std::shared_ptr<Candidate>, const std::shared_ptr< const Bounds > &, bool, bool );
+		void unfile( BeaconSubscription * );
+		void reorder( BeaconSubscription * );
+		void unsubscribe( BeaconSubscription * );
+		void activateMatches( MessageReceiveBlock *, SystemProcess *, ParameterValues &, const std::shared_ptr< const ParallelContinuation > &, const std::shared_ptr< const Bounds > &, const std::vector< std::vector< int > > &, TransitionScheduler & );
 
 	public:
 		BeaconChannel( std::vector< std::string >, GlobalVariables & );
 		BeaconChannel( const BeaconChannel & );
-		std::vector< std::string > getChannelName(void);
-		void updateBeaconCandidates(int &, double &);
-		void cleanSPFromChannel( SystemProcess *, int &, double & );
-		std::shared_ptr<Candidate> pickCandidate(double &, double, double);
-		void addCandidate( Block *, SystemProcess *, std::list< SystemProcess > , ParameterValues &, int &, double & );
+		const std::vector< std::string > &getChannelName( void ) const { return _channelName; }
+		void updateBeaconCandidates( TransitionScheduler & );
+		void cleanSPFromChannel( SystemProcess *, TransitionScheduler & );
+		void updateDatabase( std::shared_ptr<Candidate> );
+		void addCandidate( Block *, SystemProcess *, const std::shared_ptr< const ParallelContinuation > &, ParameterValues &, TransitionScheduler & );
 };
 
 
@@ -0,0 +1,301 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <cstring>
+#include "binary.h"
+#include "error_handling.h"
+#include "simulator.h"
+
+
+static inline void putVarint( std::ostream &out, uint64_t v ){
+
+	while ( v >= 0x80 ){
+
+		out.put( (char) ( ( v & 0x7f ) | 0x80 ) );
+		v >>= 7;
+	}
+	out.put( (char) v );
+}
+
+
+static inline uint64_t zigzag( int64_t v ){ return ( (uint64_t) v << 1 ) ^ (uint64_t) ( v >> 63 ); }
+static inline int64_t unzigzag( uint64_t v ){ return (int64_t) ( v >> 1 ) ^ -(int64_t) ( v & 1 ); }
+
+
+static void putString( std::ostream &out, const std::string &s ){
+
+	putVarint( out, s.size() );
+	out.write( s.data(), s.size() );
+}
+
+
+static void putStrings( std::ostream &out, const std::vector< std::string > &strings ){
+
+	putVarint( out, strings.size() );
+	for ( auto s = strings.begin(); s < strings.end(); s++ ) putString( out, *s );
+}
+
+
+static unsigned int intern( const std::string &name, std::vector< std::string > &names, std::map< std::string, unsigned int > &ids ){
+
+	auto id = ids.find( name );
+	if ( id != ids.end() ) return id -> second;
+
+	ids[name] = names.size();
+	names.push_back( name );
+	return names.size() - 1;
+}
+
+
+/*BINARY DICTIONARY-----------------------------------------------------------------------------------------------------------------------------------------------*/
+BinaryDictionary::BinaryDictionary( std::map< std::string, ProcessDefinition > &processName2Definition ){
+
+	std::map< std::string, unsigned int > actionIds, channelIds, parameterIds;
+	for ( auto pd = processName2Definition.begin(); pd != processName2Definition.end(); pd++ ){
+
+		const CompiledProcess *cp = (pd -> second).compiled.get();
+		_processIds[cp] = _processNames.size();
+		_processNames.push_back( pd -> first );
+
+		std::vector< unsigned int > parameters;
+		for ( auto p = (cp -> parameters).begin(); p < (cp -> parameters).end(); p++ ) parameters.push_back( intern( *p, _parameters, parameterIds ) );
+		_processParameters.push_back( parameters );
+
+		//the code each node writes, if it's something that shows up in the output
+		std::vector< unsigned long > codes( cp -> numberOfNodes(), 0 );
+		for ( unsigned int i = 0; i < cp -> numberOfNodes(); i++ ){
+
+			Block *b = cp -> block( i );
+			switch ( b -> kind() ){
+
+				case BLOCK_ACTION:
+					codes[i] = 1 + ( (unsigned long) intern( static_cast< ActionBlock * >( b ) -> actionName, _actions, actionIds ) << 1 );
+					break;
+				case BLOCK_MESSAGE_SEND:
+					codes[i] = 1 + ( ( (unsigned long) intern( System::writeChannelName( static_cast< MessageSendBlock * >( b ) -> getChannelName() ), _channels, channelIds ) << 1 ) | 1 );
+					break;
+				case BLOCK_MESSAGE_RECEIVE:
+					codes[i] = 1 + ( ( (unsigned long) intern( System::writeChannelName( static_cast< MessageReceiveBlock * >( b ) -> getChannelName() ), _channels, channelIds ) << 1 ) | 1 );
+					break;
+				default:
+					break;
+			}
+		}
+		_nodeCodes.push_back( codes );
+	}
+}
+
+
+void BinaryDictionary::writeHeader( std::ostream &out ) const {
+
+	out.write( binaryMagic, sizeof( binaryMagic ) - 1 );
+	out.put( (char) binaryVersion );
+	putStrings( out, _actions );
+	putStrings( out, _channels );
+	putStrings( out, _parameters );
+
+	putVarint( out, _processNames.size() );
+	for ( unsigned int i = 0; i < _processNames.size(); i++ ){
+
+		putString( out, _processNames[i] );
+		putVarint( out, _processParameters[i].size() );
+		for ( auto p = _processParameters[i].begin(); p < _processParameters[i].end(); p++ ) putVarint( out, *p );
+	}
+}
+
+
+void BinaryDictionary::writeSimulationStart( std::ostream &out ) const {
+
+	putVarint( out, 0 );
+}
+
+
+void BinaryDictionary::writeRecord( std::ostream &out, double time, uint64_t &lastTime, Block *actionDone, ParameterValues &parameterValues ) const {
+//lastTime is the bit pattern of the last time written in this simulation, which starts at zero
+
+	const CompiledProcess &pd = *( actionDone -> getDefinition() );
+	unsigned int process = _processIds.find( &pd ) -> second;
+	putVarint( out, _nodeCodes[process][ actionDone -> getNode() ] );
+	putVarint( out, process );
+
+	uint64_t bits;
+	memcpy( &bits, &time, sizeof( bits ) );
+	putVarint( out, zigzag( (int64_t) ( bits - lastTime ) ) );
+	lastTime = bits;
+
+	for ( unsigned int i = 0; i < pd.parameters.size(); i++ ){
+
+		if ( not parameterValues.isDefined( pd.parameterSlots[i] ) ){
+
+			out.put( (char) BIN_UNSET );
+			continue;
+		}
+
+		Numerical val = parameterValues.getValue( pd.parameterSlots[i] );
+		if ( val.isInt() ){
+
+			out.put( (char) BIN_INT );
+			putVarint( out, zigzag( val.getInt() ) );
+		}
+		else{
+
+			double d = val.getDouble();
+			memcpy( &bits, &d, sizeof( bits ) );
+			out.put( (char) BIN_DOUBLE );
+			for ( unsigned int b = 0; b < 8; b++ ) out.put( (char) ( ( bits >> ( 8 * b ) ) & 0xff ) );
+		}
+	}
+}
+
+
+void writeBinaryRecord( std::ostream &out, const BinaryRecord &record, uint64_t &lastTime ){
+//write back a record that was read, for copying part of a binary file
+
+	if ( record.simulationStart ){
+
+		putVarint( out, 0 );
+		lastTime = 0;
+		return;
+	}
+
+	putVarint( out, 1 + ( ( (uint64_t) record.name << 1 ) | ( record.isChannel ? 1 : 0 ) ) );
+	putVarint( out, record.process );
+
+	uint64_t bits;
+	memcpy( &bits, &record.time, sizeof( bits ) );
+	putVarint( out, zigzag( (int64_t) ( bits - lastTime ) ) );
+	lastTime = bits;
+
+	for ( auto v = record.parameters.begin(); v < record.parameters.end(); v++ ){
+
+		out.put( (char) v -> type );
+		if ( v -> type == BIN_INT ) putVarint( out, zigzag( v -> intValue ) );
+		else if ( v -> type == BIN_DOUBLE ){
+
+			memcpy( &bits, &( v -> doubleValue ), sizeof( bits ) );
+			for ( unsigned int b = 0; b < 8; b++ ) out.put( (char) ( ( bits >> ( 8 * b ) ) & 0xff ) );
+		}
+	}
+}
+
+
+/*BINARY READER---------------------------------------------------------------------------------------------------------------------------------------------------*/
+BinaryReader::BinaryReader( std::istream &in ) : _in( in ){
+
+	char magic[ sizeof( binaryMagic ) - 1 ];
+	if ( not _in.read( magic, sizeof( magic ) ) or memcmp( magic, binaryMagic, sizeof( magic ) ) != 0 ) throw BadTrajectoryFile();
+	if ( _in.get() != binaryVersion ) throw BadTrajectoryFile();
+
+	for ( uint64_t n = readVarint(); n > 0; n-- ) actions.push_back( readString() );
+	for ( uint64_t n = readVarint(); n > 0; n-- ) channels.push_back( readString() );
+	for ( uint64_t n = readVarint(); n > 0; n-- ) parameters.push_back( readString() );
+	for ( uint64_t n = readVarint(); n > 0; n-- ){
+
+		processNames.push_back( readString() );
+		std::vector< unsigned int > ids;
+		for ( uint64_t k = readVarint(); k > 0; k-- ){
+
+			uint64_t id = readVarint();
+			if ( id >= parameters.size() ) throw BadTrajectoryFile();
+			ids.push_back( id );
+		}
+		processParameters.push_back( ids );
+	}
+}
+
+
+uint64_t BinaryReader::readVarint( void ){
+
+	uint64_t v = 0;
+	for ( unsigned int shift = 0; shift < 64; shift += 7 ){
+
+		int c = _in.get();
+		if ( c == EOF ) throw BadTrajectoryFile();
+		v |= (uint64_t) ( c & 0x7f ) << shift;
+		if ( not ( c & 0x80 ) ) return v;
+	}
+	throw BadTrajectoryFile();
+}
+
+
+std::string BinaryReader::readString( void ){
+
+	uint64_t length = readVarint();
+	std::string s( length, '\0' );
+	if ( length > 0 and not _in.read( &s[0], length ) ) throw BadTrajectoryFile();
+	return s;
+}
+
+
+bool BinaryReader::next( BinaryRecord &record ){
+//read the next record, or return false at the end of the file
+
+	if ( _in.peek() == EOF ) return false;
+
+	uint64_t code = readVarint();
+	record.simulationStart = ( code == 0 );
+	if ( record.simulationStart ){
+
+		_lastTime = 0;
+		return true;
+	}
+
+	record.isChannel = ( code - 1 ) & 1;
+	record.name = ( code - 1 ) >> 1;
+	record.process = readVarint();
+	if ( record.name >= ( record.isChannel ? channels : actions ).size() or record.process >= processNames.size() ) throw BadTrajectoryFile();
+
+	_lastTime += (uint64_t) unzigzag( readVarint() );
+	memcpy( &record.time, &_lastTime, sizeof( record.time ) );
+
+	const std::vector< unsigned int > &ids = processParameters[record.process];
+	record.parameters.resize( ids.size() );
+	for ( unsigned int i = 0; i < ids.size(); i++ ){
+
+		BinaryValue &value = record.parameters[i];
+		int type = _in.get();
+		if ( type == BIN_UNSET ) value.type = BIN_UNSET;
+		else if ( type == BIN_INT ){
+
+			value.type = BIN_INT;
+			value.intValue = unzigzag( readVarint() );
+		}
+		else if ( type == BIN_DOUBLE ){
+
+			unsigned char b[8];
+			if ( not _in.read( (char *) b, 8 ) ) throw BadTrajectoryFile();
+			uint64_t bits = 0;
+			for ( unsigned int j = 0; j < 8; j++ ) bits |= (uint64_t) b[j] << ( 8 * j );
+			value.type = BIN_DOUBLE;
+			memcpy( &value.doubleValue, &bits, sizeof( bits ) );
+		}
+		else throw BadTrajectoryFile();
+	}
+	return true;
+}
+
+
+void BinaryReader::writeText( const BinaryRecord &record, std::ostream &out ) const {
+//write a record the way it would have been written in the text format
+
+	if ( record.simulationStart ){
+
+		out << ">=======\n";
+		return;
+	}
+
+	out << record.time << '\t' << ( record.isChannel ? channels : actions )[record.name] << '\t' << processNames[record.process];
+	const std::vector< unsigned int > &ids = processParameters[record.process];
+	for ( unsigned int i = 0; i < ids.size(); i++ ){
+
+		const BinaryValue &value = record.parameters[i];
+		if ( value.type == BIN_INT ) out << '\t' << parameters[ ids[i] ] << '\t' << value.intValue;
+		else if ( value.type == BIN_DOUBLE ) out << '\t' << parameters[ ids[i] ] << '\t' << value.doubleValue;
+	}
+	out << '\n';
+}
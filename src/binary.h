@@ -0,0 +1,92 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include "blockParser.h"
+
+//binary trajectory files (--format bin) are a header with dictionaries of every action, channel, parameter, and process name in the
+//model, then one block of records per simulation.  a record is:
+// - varint: 0 starts a new simulation, otherwise 1 + (name id << 1 | 1 if the name is a channel)
+// - varint: process id
+// - varint: zigzagged difference between the bit patterns of this time and the last one in the simulation, which is small for
+//           nearby times and gives the time back exactly
+// - for each of the process's parameters, a type byte (BIN_UNSET, BIN_INT, BIN_DOUBLE) then a zigzagged varint or 8 byte double
+//strings are a varint length and then the characters; multi-byte values are little-endian.  records are kept in rows, in the order the
+//transitions happen, rather than in columns, since a simulation is written out a chunk at a time while it runs
+enum BinaryValueType { BIN_UNSET, BIN_INT, BIN_DOUBLE };
+
+static const char binaryMagic[] = "BCSBIN";
+static const unsigned char binaryVersion = 1;
+
+
+class BinaryDictionary{
+//the names in a model and where each of its actions, sends, and receives points to in them, for writing binary trajectories
+
+	private:
+		std::vector< std::string > _actions, _channels, _parameters;
+		std::vector< std::string > _processNames;
+		std::vector< std::vector< unsigned int > > _processParameters; //parameter ids of each process
+		std::unordered_map< const CompiledProcess *, unsigned int > _processIds;
+		std::vector< std::vector< unsigned long > > _nodeCodes; //record code of each node of each process
+
+	public:
+		BinaryDictionary( std::map< std::string, ProcessDefinition > & );
+		void writeHeader( std::ostream & ) const;
+		void writeSimulationStart( std::ostream & ) const;
+		void writeRecord( std::ostream &, double, uint64_t &, Block *, ParameterValues & ) const;
+};
+
+
+struct BinaryValue{
+
+	unsigned char type = BIN_UNSET;
+	int64_t intValue = 0;
+	double doubleValue = 0.0;
+};
+
+
+struct BinaryRecord{
+
+	bool simulationStart = false;
+	bool isChannel = false;
+	unsigned int name = 0, process = 0;
+	double time = 0.0;
+	std::vector< BinaryValue > parameters;
+};
+
+
+void writeBinaryRecord( std::ostream &, const BinaryRecord &, uint64_t & );
+
+
+class BinaryReader{
+//reads a binary trajectory file record by record
+
+	private:
+		std::istream &_in;
+		uint64_t _lastTime = 0;
+		uint64_t readVarint( void );
+		std::string readString( void );
+
+	public:
+		std::vector< std::string > actions, channels, parameters, processNames;
+		std::vector< std::vector< unsigned int > > processParameters;
+		BinaryReader( std::istream & );
+		bool next( BinaryRecord & );
+		void writeText( const BinaryRecord &, std::ostream & ) const;
+};
+
+#endif
@@ -57,7 +57,7 @@ std::vector< std::vector< Token * > > splitOnCommas( std::vector< Token * > &tok
 		if ( (*t) -> value() == "(" ) parenStack.push( *t );
 		else if ( (*t) -> value() == ")" ) parenStack.pop();
 
-		if ( (*t) -> identify() == "Comma" and parenStack.empty() ) {
+		if ( (*t) -> kind() == TOKEN_COMMA and parenStack.empty() ) {
 
 			if (buffer.size() == 0) throw SyntaxError(*t, "Thrown by block parser: Comma-separated list cannot contain the empty string.");
 			allSplit.push_back( buffer );
@@ -71,14 +71,14 @@ std::vector< std::vector< Token * > > splitOnCommas( std::vector< Token * > &tok
 
 
 /*BLOCK METHODS------------------------------------------------------------------------------------------------------------------------------------------------------*/
-ActionBlock::ActionBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+ActionBlock::ActionBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_ACTION, t, s, parameterNames, globalVarNames ){
 
 #if DEBUG
 std::cout << "---------------" << std::endl;
 std::cout << "Starting ActionBlock parsing on: " << t -> value() << std::endl;
 #endif
 
-	assert( t -> identify() == "Action" );
+	assert( t -> kind() == TOKEN_ACTION );
 	_underlyingToken = t;
 	_owningProcess = s;
 	std::string wholeAction = t -> value();
@@ -93,7 +93,7 @@ std::cout << "Starting ActionBlock parsing on: " << t -> value() << std::endl;
 	std::string rateSubstr = wholeAction.substr(wholeAction.find(",")+1, wholeAction.find("}") - wholeAction.find(",") - 1);
 	std::vector< Token * > tokenisedRate = scanLine( rateSubstr, t -> getLine(), t -> getColumn() );
 	for (auto tr = tokenisedRate.begin(); tr < tokenisedRate.end(); tr++){
-		if ((*tr) -> identify() == "Variable"){
+		if ((*tr) -> kind() == TOKEN_VARIABLE){
 			std::string variableName = (*tr) -> value();
 			if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 				and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -101,18 +101,18 @@ std::cout << "Starting ActionBlock parsing on: " << t -> value() << std::endl;
 				}
 		}
 	}
-	_RPNrate = shuntingYard( tokenisedRate );
+	_RPNrate = Bytecode( shuntingYard( tokenisedRate ) );
 
 
 #if DEBUG
 std::cout << "Tokenised rate in RPN: ";
-for ( auto t = _RPNrate.begin(); t < _RPNrate.end(); t++ ) std::cout << (*t) -> value() << " ";
+for ( auto t = _RPNrate.rpn().begin(); t < _RPNrate.rpn().end(); t++ ) std::cout << (*t) -> value() << " ";
 std::cout << std::endl;
 #endif
 }
 
 
-ChoiceBlock::ChoiceBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+ChoiceBlock::ChoiceBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_CHOICE, t, s, parameterNames, globalVarNames ){
 
 	assert( t -> value() == "+" );
 	_owningProcess = s;
@@ -120,7 +120,7 @@ ChoiceBlock::ChoiceBlock( Token *t, std::string s, std::vector<std::string> para
 }
 
 
-ParallelBlock::ParallelBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+ParallelBlock::ParallelBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_PARALLEL, t, s, parameterNames, globalVarNames ){
 
 	assert( t -> value() == "||" );
 	_owningProcess = s;
@@ -128,14 +128,14 @@ ParallelBlock::ParallelBlock( Token *t, std::string s, std::vector<std::string>
 }
 
 
-GateBlock::GateBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+GateBlock::GateBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_GATE, t, s, parameterNames, globalVarNames ){
 
 #if DEBUG
 std::cout << "---------------" << std::endl;
 std::cout << "Starting GateBlock parsing on: " << t -> value() << std::endl;
 #endif
 
-	assert( t -> identify() == "Gate" );
+	assert( t -> kind() == TOKEN_GATE );
 	_underlyingToken = t;
 	_owningProcess = s;
 
@@ -146,7 +146,7 @@ std::cout << "Starting GateBlock parsing on: " << t -> value() << std::endl;
 	if (tokenisedGate.size() == 0) throw SyntaxError( t, "Gate condition cannot be empty.");
 
 	for (auto tr = tokenisedGate.begin(); tr < tokenisedGate.end(); tr++){
-		if ((*tr) -> identify() == "Variable"){
+		if ((*tr) -> kind() == TOKEN_VARIABLE){
 			std::string variableName = (*tr) -> value();
 			if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 				and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -155,17 +155,17 @@ std::cout << "Starting GateBlock parsing on: " << t -> value() << std::endl;
 		}
 	}
 
-	_RPNexpression = shuntingYard( tokenisedGate );
+	_RPNexpression = Bytecode( shuntingYard( tokenisedGate ) );
 
 #if DEBUG
 std::cout << "Tokenised condition in RPN: ";
-for ( auto t = _RPNexpression.begin(); t < _RPNexpression.end(); t++ ) std::cout << (*t) -> value() << " ";
+for ( auto t = _RPNexpression.rpn().begin(); t < _RPNexpression.rpn().end(); t++ ) std::cout << (*t) -> value() << " ";
 std::cout << std::endl;
 #endif
 }
 
 
-MessageSendBlock::MessageSendBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+MessageSendBlock::MessageSendBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_MESSAGE_SEND, t, s, parameterNames, globalVarNames ){
 
 #if DEBUG
 std::cout << "---------------" << std::endl;
@@ -202,8 +202,8 @@ std::cout << "Starting MessageSendBlock parsing on: " << t -> value() << std::en
 		_handshake = false;
 		_kill = false;
 	}
-	_channelNames = splitOnCommas( tokenisedChannel );
-	for ( unsigned int i = 0; i < _channelNames.size(); i++ ) _channelNames[i] = shuntingYard(_channelNames[i]);
+	std::vector< std::vector< Token * > > splitChannel = splitOnCommas( tokenisedChannel );
+	for ( unsigned int i = 0; i < splitChannel.size(); i++ ) _channelNames.push_back( Bytecode( shuntingYard(splitChannel[i]) ) );
 
 #if DEBUG
 std::cout << "Type of send: ";
@@ -213,7 +213,7 @@ else std::cout << "BEACON SEND" << std::endl;
 for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 
 	std::cout << "Channel name expression:" << std::endl;
-	for ( auto t = (*exp).begin(); t < (*exp).end(); t++ ){
+	for ( auto t = exp -> rpn().begin(); t < exp -> rpn().end(); t++ ){
 		std::cout << (*t) -> value() << std::endl;
 	}
 }
@@ -225,7 +225,7 @@ for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 	std::string betweenSquareBrackets = wholeMessage.substr( wholeMessage.find("[") + 1, wholeMessage.find("]") - wholeMessage.find("[") - 1 );
 	std::vector< Token * > tokenisedParamArithmetic = scanLine( betweenSquareBrackets, t -> getLine(), t -> getColumn() );
 	for (auto tr = tokenisedParamArithmetic.begin(); tr < tokenisedParamArithmetic.end(); tr++){
-		if ((*tr) -> identify() == "Variable"){
+		if ((*tr) -> kind() == TOKEN_VARIABLE){
 			std::string variableName = (*tr) -> value();
 			if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 				and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -233,17 +233,17 @@ for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 				}
 		}
 	}
-	_RPNexpressions = splitOnCommas( tokenisedParamArithmetic );
+	std::vector< std::vector< Token * > > splitParams = splitOnCommas( tokenisedParamArithmetic );
 	
 	if (tokenisedParamArithmetic.size() == 0) throw SyntaxError( t, "Message must send a comma-separated list of at least one value.");
 
-	for ( unsigned int i = 0; i < _RPNexpressions.size(); i++ ) _RPNexpressions[i] = shuntingYard(_RPNexpressions[i]);
+	for ( unsigned int i = 0; i < splitParams.size(); i++ ) _RPNexpressions.push_back( Bytecode( shuntingYard(splitParams[i]) ) );
 
 #if DEBUG
 for ( auto exp = _RPNexpressions.begin(); exp < _RPNexpressions.end(); exp++ ){
 
 	std::cout << "Parameter expression:" << std::endl;
-	for ( auto t = (*exp).begin(); t < (*exp).end(); t++ ){
+	for ( auto t = exp -> rpn().begin(); t < exp -> rpn().end(); t++ ){
 		std::cout << (*t) -> value() << std::endl;
 	}
 }
@@ -253,7 +253,7 @@ for ( auto exp = _RPNexpressions.begin(); exp < _RPNexpressions.end(); exp++ ){
 	std::string rateSubstr = wholeMessage.substr(wholeMessage.find(",",wholeMessage.find(']'))+1, wholeMessage.find("}") - wholeMessage.find(",",wholeMessage.find(']')) - 1);
 	std::vector< Token * > tokenisedRate = scanLine( rateSubstr, t -> getLine(), t -> getColumn() );
 	for (auto tr = tokenisedRate.begin(); tr < tokenisedRate.end(); tr++){
-		if ((*tr) -> identify() == "Variable"){
+		if ((*tr) -> kind() == TOKEN_VARIABLE){
 			std::string variableName = (*tr) -> value();
 			if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 				and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -261,17 +261,17 @@ for ( auto exp = _RPNexpressions.begin(); exp < _RPNexpressions.end(); exp++ ){
 				}
 		}
 	}
-	_RPNrate = shuntingYard( tokenisedRate );
+	_RPNrate = Bytecode( shuntingYard( tokenisedRate ) );
 
 #if DEBUG
 std::cout << "Tokenised rate in RPN: ";
-for ( auto t = _RPNrate.begin(); t < _RPNrate.end(); t++ ) std::cout << (*t) -> value() << " ";
+for ( auto t = _RPNrate.rpn().begin(); t < _RPNrate.rpn().end(); t++ ) std::cout << (*t) -> value() << " ";
 std::cout << std::endl;
 #endif
 }
 
 
-MessageReceiveBlock::MessageReceiveBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+MessageReceiveBlock::MessageReceiveBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_MESSAGE_RECEIVE, t, s, parameterNames, globalVarNames ){
 
 #if DEBUG
 std::cout << "---------------" << std::endl;
@@ -309,8 +309,8 @@ std::cout << "Starting MessageReceiveBlock parsing on: " << t -> value() << std:
 		_handshake = false;
 		_check = false;
 	}
-	_channelNames = splitOnCommas( tokenisedChannel );
-	for ( unsigned int i = 0; i < _channelNames.size(); i++ ) _channelNames[i] = shuntingYard(_channelNames[i]);
+	std::vector< std::vector< Token * > > splitChannel = splitOnCommas( tokenisedChannel );
+	for ( unsigned int i = 0; i < splitChannel.size(); i++ ) _channelNames.push_back( Bytecode( shuntingYard(splitChannel[i]) ) );
 
 #if DEBUG
 std::cout << "Type of receive: ";
@@ -320,7 +320,7 @@ else std::cout << "BEACON RECEIVE" << std::endl;
 for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 
 	std::cout << "Channel name expression:" << std::endl;
-	for ( auto t = (*exp).begin(); t < (*exp).end(); t++ ){
+	for ( auto t = exp -> rpn().begin(); t < exp -> rpn().end(); t++ ){
 		std::cout << (*t) -> value() << std::endl;
 	}
 }
@@ -330,7 +330,7 @@ for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 	std::string betweenSquareBrackets = wholeMessage.substr( wholeMessage.find("[") + 1, wholeMessage.find("]") - wholeMessage.find("[") - 1 );
 	std::vector< Token * > tokenisedParamArithmetic = scanLine( betweenSquareBrackets, t -> getLine(), t -> getColumn() );
 	for (auto tr = tokenisedParamArithmetic.begin(); tr < tokenisedParamArithmetic.end(); tr++){
-		if ((*tr) -> identify() == "Variable"){
+		if ((*tr) -> kind() == TOKEN_VARIABLE){
 			std::string variableName = (*tr) -> value();
 			if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 				and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -338,12 +338,12 @@ for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 				}
 		}
 	}
-	_RPNexpressions = splitOnCommas( tokenisedParamArithmetic );
+	std::vector< std::vector< Token * > > splitParams = splitOnCommas( tokenisedParamArithmetic );
 
 	//check if it uses set operations so we can optimise it if not
 	for (auto paramToken = tokenisedParamArithmetic.begin(); paramToken < tokenisedParamArithmetic.end(); paramToken++){
 
-		if ( (*paramToken) -> identify() == "SetOperation" ){
+		if ( (*paramToken) -> kind() == TOKEN_SET_OPERATION ){
 			_usesSets = true;
 			break;
 		}
@@ -351,13 +351,13 @@ for ( auto exp = _channelNames.begin(); exp < _channelNames.end(); exp++ ){
 
 	if (tokenisedParamArithmetic.size() == 0) throw SyntaxError( t, "Message must receive comma-separated list of at least one value or set.");
 
-	for ( unsigned int i = 0; i < _RPNexpressions.size(); i++ ) _RPNexpressions[i] = shuntingYard(_RPNexpressions[i]);
+	for ( unsigned int i = 0; i < splitParams.size(); i++ ) _RPNexpressions.push_back( Bytecode( shuntingYard(splitParams[i]) ) );
 
 #if DEBUG
 for ( auto exp = _RPNexpressions.begin(); exp < _RPNexpressions.end(); exp++ ){
 
 	std::cout << "Parameter expression:" << std::endl;
-	for ( auto t = (*exp).begin(); t < (*exp).end(); t++ ){
+	for ( auto t = exp -> rpn().begin(); t < exp -> rpn().end(); t++ ){
 		std::cout << (*t) -> value() << std::endl;
 	}
 }
@@ -370,7 +370,7 @@ for ( auto exp = _RPNexpressions.begin(); exp < _RPNexpressions.end(); exp++ ){
 	std::vector< Token * > tokenisedRate, tokenisedBinding;
 	for (auto t = tokenisedWholeMessage.begin(); t < tokenisedWholeMessage.end(); t++){
 
-		if ( (*t) -> identify() == "ParameterCondition" ){
+		if ( (*t) -> kind() == TOKEN_PARAMETER_CONDITION ){
 			t++;
 			if ( (*t) -> value() == "(" ){
 				_hasBindingVar = true;
@@ -405,14 +405,15 @@ std::cout << "Binds variable? " << _hasBindingVar << std::endl;
 std::cout << "Binding variable token: " << tokenisedBinding[i] -> value() << std::endl;
 #endif
 
-			if ( tokenisedBinding[i] -> identify() == "Comma" ){
+			if ( tokenisedBinding[i] -> kind() == TOKEN_COMMA ){
 
 				if (i % 2 != 0) throw SyntaxError( tokenisedBinding[i], "Binding variables must be a comma-separated list of variables.");	
 			}
-			else if (tokenisedBinding[i] -> identify() == "Variable"){
+			else if (tokenisedBinding[i] -> kind() == TOKEN_VARIABLE){
 
 				if (i % 2 != 1) throw SyntaxError( tokenisedBinding[i], "Binding variables must be a comma-separated list of variables.");	
 				_bindingVariables.push_back( tokenisedBinding[i] -> value() );
+				_bindingSlots.push_back( VariableFrame::slot( tokenisedBinding[i] -> value() ) );
 			}
 			else{
 
@@ -428,7 +429,7 @@ std::cout << "Binding variable token: " << tokenisedBinding[i] -> value() << std
 
 		//if we bind a variable, we already figured out what the tokenised rate is above
 		for (auto tr = tokenisedRate.begin(); tr < tokenisedRate.end(); tr++){
-			if ((*tr) -> identify() == "Variable"){
+			if ((*tr) -> kind() == TOKEN_VARIABLE){
 				std::string variableName = (*tr) -> value();
 				if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 					and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()
@@ -437,7 +438,7 @@ std::cout << "Binding variable token: " << tokenisedBinding[i] -> value() << std
 					}
 			}
 		}
-		_RPNrate = shuntingYard( tokenisedRate );
+		_RPNrate = Bytecode( shuntingYard( tokenisedRate ) );
 	}
 	else{//if no binding variable, parse the rate the same way we would for a send
 
@@ -445,7 +446,7 @@ std::cout << "Binding variable token: " << tokenisedBinding[i] -> value() << std
 		std::string rateSubstr = wholeMessage.substr(wholeMessage.find(",",wholeMessage.find(']'))+1, wholeMessage.find("}") - wholeMessage.find(",",wholeMessage.find(']')) - 1);
 		tokenisedRate = scanLine( rateSubstr, t -> getLine(), t -> getColumn() );
 		for (auto tr = tokenisedRate.begin(); tr < tokenisedRate.end(); tr++){
-			if ((*tr) -> identify() == "Variable"){
+			if ((*tr) -> kind() == TOKEN_VARIABLE){
 				std::string variableName = (*tr) -> value();
 				if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 					and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -453,25 +454,25 @@ std::cout << "Binding variable token: " << tokenisedBinding[i] -> value() << std
 					}
 			}
 		}
-		_RPNrate = shuntingYard( tokenisedRate );
+		_RPNrate = Bytecode( shuntingYard( tokenisedRate ) );
 	}
 
 #if DEBUG
 std::cout << "Tokenised rate in RPN: ";
-for ( auto t = _RPNrate.begin(); t < _RPNrate.end(); t++ ) std::cout << (*t) -> value() << " ";
+for ( auto t = _RPNrate.rpn().begin(); t < _RPNrate.rpn().end(); t++ ) std::cout << (*t) -> value() << " ";
 std::cout << std::endl;
 #endif
 }
 
 
-ProcessBlock::ProcessBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( t, s, parameterNames, globalVarNames ){
+ProcessBlock::ProcessBlock( Token *t, std::string s, std::vector<std::string> parameterNames, std::vector<std::string> globalVarNames ) : Block( BLOCK_PROCESS, t, s, parameterNames, globalVarNames ){
 
 #if DEBUG
 std::cout << "---------------" << std::endl;
 std::cout << "Starting MessageReceiveBlock parsing on: " << t -> value() << std::endl;
 #endif
 
-	assert( t -> identify() == "Process" );
+	assert( t -> kind() == TOKEN_PROCESS );
 	_underlyingToken = t;
 	_owningProcess = s;
 	std::string wholeProcess = t -> value();
@@ -483,7 +484,7 @@ std::cout << "Starting MessageReceiveBlock parsing on: " << t -> value() << std:
 	std::string betweenBrackets = wholeProcess.substr( wholeProcess.find("[") + 1, wholeProcess.find("]") - wholeProcess.find("[") - 1 );
 	std::vector< Token * > tokenisedParam = scanLine( betweenBrackets, t -> getLine(), t -> getColumn() );
 	for (auto tr = tokenisedParam.begin(); tr < tokenisedParam.end(); tr++){
-		if ((*tr) -> identify() == "Variable"){
+		if ((*tr) -> kind() == TOKEN_VARIABLE){
 			std::string variableName = (*tr) -> value();
 			if (std::find(parameterNames.begin(),parameterNames.end(),variableName) == parameterNames.end()
 				and std::find(globalVarNames.begin(),globalVarNames.end(),variableName) == globalVarNames.end()){
@@ -496,14 +497,14 @@ std::cout << "Starting MessageReceiveBlock parsing on: " << t -> value() << std:
 		std::vector< std::vector< Token * > > split_tokenisedParam = splitOnCommas( tokenisedParam );
 		for ( auto tv = split_tokenisedParam.begin(); tv < split_tokenisedParam.end(); tv++ ){
 
-			_parameterExpressions.push_back( shuntingYard( *tv ) );
+			_parameterExpressions.push_back( Bytecode( shuntingYard( *tv ) ) );
 		}
 	}
 #if DEBUG
 for ( auto exp = _parameterExpressions.begin(); exp < _parameterExpressions.end(); exp++ ){
 
 	std::cout << "Parameter expression:" << std::endl;
-	for ( auto t = (*exp).begin(); t < (*exp).end(); t++ ){
+	for ( auto t = exp -> rpn().begin(); t < exp -> rpn().end(); t++ ){
 		std::cout << (*t) -> value() << std::endl;
 	}
 }
@@ -511,6 +512,77 @@ for ( auto exp = _parameterExpressions.begin(); exp < _parameterExpressions.end(
 }
 
 
+/*CHANNEL NAMES-------------------------------------------------------------------------------------------------------------------------------------------------------*/
+static std::map< ChannelKey, unsigned int > idsByKey;
+static std::vector< ChannelKey > keysById;
+
+
+unsigned int ChannelNames::intern( const ChannelKey &key ){
+
+	auto id = idsByKey.find( key );
+	if ( id != idsByKey.end() ) return id -> second;
+
+	unsigned int newId = keysById.size();
+	idsByKey[key] = newId;
+	keysById.push_back( key );
+	return newId;
+}
+
+
+const ChannelKey &ChannelNames::key( unsigned int id ){
+
+	assert( id < keysById.size() );
+	return keysById[id];
+}
+
+
+unsigned int ChannelNames::count( void ){
+
+	return keysById.size();
+}
+
+
+std::vector< std::string > ChannelNames::spell( const ChannelKey &key ){
+//the channel name as it's written, which is what channels are ordered by
+
+	std::vector< std::string > name;
+	for ( unsigned int i = 0; i < key.size(); i += 2 ){
+
+		if ( key[i] == CHANNEL_NAME ) name.push_back( VariableFrame::slotName( key[i+1] ) );
+		else name.push_back( std::to_string( key[i+1] ) );
+	}
+	return name;
+}
+
+
+/*COMPILED PROCESS METHODS---------------------------------------------------------------------------------------------------------------------------------------------*/
+CompiledProcess::CompiledProcess( Tree<Block> &bt, const std::vector< std::string > &parameterNames, const std::vector< unsigned int > &slots ) : parameters( parameterNames ), parameterSlots( slots ){
+
+	//lay the blocks out in preorder, then record where each node's children are
+	number( bt, bt.getRoot() );
+	for ( unsigned int i = 0; i < _nodes.size(); i++ ){
+
+		_childOffsets.push_back( _children.size() );
+		if ( bt.isLeaf( _nodes[i] ) ) continue;
+
+		std::vector< Block * > children = bt.getChildren( _nodes[i] );
+		for ( auto c = children.begin(); c < children.end(); c++ ) _children.push_back( (*c) -> getNode() );
+	}
+	_childOffsets.push_back( _children.size() );
+}
+
+
+void CompiledProcess::number( Tree<Block> &bt, Block *b ){
+
+	b -> place( this, _nodes.size() );
+	_nodes.push_back( b );
+
+	if ( bt.isLeaf( b ) ) return;
+	std::vector< Block * > children = bt.getChildren( b );
+	for ( auto c = children.begin(); c < children.end(); c++ ) number( bt, *c );
+}
+
+
 /*SECOND PASS PARSING FUNCTIONS--------------------------------------------------------------------------------------------------------------------------------------*/
 Block *tokenToBlock( Token *t,
 		             std::string processName,
@@ -519,7 +591,7 @@ Block *tokenToBlock( Token *t,
 
 	Block *newBlock;
 	
-	if ( t -> identify() == "Action" ){
+	if ( t -> kind() == TOKEN_ACTION ){
 
 		newBlock = new ActionBlock( t, processName, parameterNames, globalVarNames );
 	}
@@ -531,19 +603,19 @@ Block *tokenToBlock( Token *t,
 
 		newBlock = new ParallelBlock( t, processName, parameterNames, globalVarNames );
 	}
-	else if ( t -> identify() == "Gate" ){
+	else if ( t -> kind() == TOKEN_GATE ){
 
 		newBlock = new GateBlock( t, processName, parameterNames, globalVarNames );
 	}
-	else if ( t -> identify() == "MessageSend" or t -> identify() == "BeaconKill" ){
+	else if ( t -> kind() == TOKEN_MESSAGE_SEND or t -> kind() == TOKEN_BEACON_KILL ){
 
 		newBlock = new MessageSendBlock( t, processName, parameterNames, globalVarNames );
 	}
-	else if ( t -> identify() == "MessageReceive" or t -> identify() == "BeaconCheck" ){
+	else if ( t -> kind() == TOKEN_MESSAGE_RECEIVE or t -> kind() == TOKEN_BEACON_CHECK ){
 
 		newBlock = new MessageReceiveBlock( t, processName, parameterNames, globalVarNames );
 	}
-	else if ( t -> identify() == "Process" ){
+	else if ( t -> kind() == TOKEN_PROCESS ){
 
 		newBlock = new ProcessBlock( t, processName, parameterNames, globalVarNames );
 	}
@@ -556,7 +628,7 @@ Block *tokenToBlock( Token *t,
 void secondParseSystemLine( std::vector< Token * > &tokenisedSL, std::list< SystemProcess > &system, std::map< std::string, ProcessDefinition > &processName2Definition, GlobalVariables &globalVars ){
 
 	/*last entry in the system line should be a process */
-	if ( (*(tokenisedSL.end() - 1)) -> identify() != "Process" ){
+	if ( (*(tokenisedSL.end() - 1)) -> kind() != TOKEN_PROCESS ){
 
 		throw SyntaxError( *(tokenisedSL.end() - 1), "Thrown by block parser: Trailing token in system line must be a process.");
 	}
@@ -565,7 +637,7 @@ void secondParseSystemLine( std::vector< Token * > &tokenisedSL, std::list< Syst
 	int multiplier = 1;
 	for ( auto t = tokenisedSL.begin(); t < tokenisedSL.end(); t++ ){
 
-		if( (*t) -> identify() == "Process" ){
+		if( (*t) -> kind() == TOKEN_PROCESS ){
 
 			SystemProcess sp;
 
@@ -576,7 +648,8 @@ void secondParseSystemLine( std::vector< Token * > &tokenisedSL, std::list< Syst
 			/*set the readhead at the process tree's root */
 			if ( processName2Definition.count( processName ) == 0 ) throw UndefinedVariable( *t );
 			
-			sp.parseTree = (processName2Definition[processName]).parseTree;
+			sp.definition = (processName2Definition[processName]).compiled.get();
+			sp.node = 0;
 			
 			/*get the initial conditions of the parameters */
 			std::string betweenBrackets = wholeProcess.substr( wholeProcess.find("[") + 1, wholeProcess.find("]") - wholeProcess.find("[") - 1 );
@@ -599,8 +672,8 @@ void secondParseSystemLine( std::vector< Token * > &tokenisedSL, std::list< Syst
 
 					std::vector< Token * > parsedIntlExp = shuntingYard( split_tokenisedParam[i] );
 					ParameterValues ParameterValues_dummy;
-					std::map< std::string, Numerical > localVariables_dummy;
-					Numerical intlValue = evalRPN_numerical(parsedIntlExp, ParameterValues_dummy, globalVars, localVariables_dummy);
+					VariableFrame localVariables_dummy;
+					Numerical intlValue = evalRPN_numerical(Bytecode( parsedIntlExp ), ParameterValues_dummy, globalVars, localVariables_dummy);
 					pValues.updateValue(parameterVar[i], intlValue);
 				}
 				sp.parameterValues = pValues;
@@ -617,24 +690,20 @@ std::cout << "---------------" << std::endl;
 std::cout << "SYSTEM LINE PARSE:" << std::endl;
 std::cout << "Process name: " << processName << std::endl;
 std::cout << "copies: " << multiplier << std::endl << "parse tree:" << std::endl;
-printBlockTree( sp.parseTree, sp.parseTree.getRoot() );
+printBlockTree( processName2Definition[processName].parseTree, sp.currentBlock() );
 std::cout << "ints:" << std::endl;
-for (auto param = sp.parameterValues.values.begin(); param != sp.parameterValues.values.end(); param++ ){
-	
-	if ( (param -> second).isDouble() ) std::cout << param -> first << " " << (param -> second).getDouble() << " double" << std::endl;
-	if ( (param -> second).isInt() ) std::cout << param -> first << " " << (param -> second).getInt() << " int" << std::endl;
-}
+sp.parameterValues.printValues();
 #endif
 			multiplier = 1;
 		}
-		else if ( (*t) -> identify() == "Variable" or (*t) -> identify() == "IntLiteral" ){
+		else if ( (*t) -> kind() == TOKEN_VARIABLE or (*t) -> kind() == TOKEN_INT_LITERAL ){
 
 			std::string str_multiplier = (*t) -> value();
 			
-			if ( (*t) -> identify() == "Variable" ){
+			if ( (*t) -> kind() == TOKEN_VARIABLE ){
 
-				if ( globalVars.values.count(str_multiplier) == 0 ) throw UndefinedVariable( *t );
-				Numerical multiplier_n = globalVars.values.at(str_multiplier);
+				if ( not globalVars.isDefined(str_multiplier) ) throw UndefinedVariable( *t );
+				Numerical multiplier_n = globalVars.getValue( VariableFrame::slot(str_multiplier) );
 				if (multiplier_n.isDouble()) throw SyntaxError( *t, "Thrown by block parser: System process multiplier must be an int, not a float.");
 				multiplier = multiplier_n.getInt();
 			}
@@ -666,7 +735,7 @@ void secondParseProcessDef( Token *t, Block *b,
 // - globalVars: global variable names so we can check all variables are defined
 
 	/*carry forward new binding variables if we have them */
-	if (b -> identify() == "MessageReceive"){
+	if (b -> kind() == BLOCK_MESSAGE_RECEIVE){
 		MessageReceiveBlock *receive = dynamic_cast< MessageReceiveBlock* >(b);
 		std::vector<std::string> newBindingVars = receive -> getBindingVariable();
 		parameterNames.insert(parameterNames.end(),newBindingVars.begin(),newBindingVars.end());
@@ -687,16 +756,21 @@ void secondParseProcessDef( Token *t, Block *b,
 
 
 void checkProcessDefinition( Block *b, Tree<Block> &bt, std::map< std::string, ProcessDefinition > &processName2Definition ){
-//checks that if a process block is used in a process definition, that process block has the right number of parameters
+//checks that if a process block is used in a process definition, that process is defined and the process block has the right number of parameters,
+//then points the process block at the compiled definition it calls
+
+	if ( b -> kind() == BLOCK_PROCESS ){
 
-	if ( b -> identify() == "Process" ){
+		ProcessBlock *pb = static_cast< ProcessBlock* >(b);
+		auto called = processName2Definition.find( pb -> getProcessName() );
+		if ( called == processName2Definition.end() ) throw UndefinedVariable( b -> getToken() );
 
-		ProcessBlock *pb = dynamic_cast< ProcessBlock* >(b);
-		std::vector< std::vector<Token*> > parameterExpressions = pb -> getParameterExpressions();
-		if (parameterExpressions.size() != processName2Definition[pb -> getProcessName()].parameters.size()){
+		const std::vector< Bytecode > &parameterExpressions = pb -> getParameterExpressions();
+		if (parameterExpressions.size() != (called -> second).parameters.size()){
 
 			throw SyntaxError( b -> getToken(), "Thrown by block parser: Number of parameters specified do not match the process definition." );
 		}
+		pb -> setTarget( (called -> second).compiled.get() );
 	}
 
 	if ( not bt.isLeaf( b ) ){
@@ -711,6 +785,78 @@ void checkProcessDefinition( Block *b, Tree<Block> &bt, std::map< std::string, P
 }
 
 
+bool constantChannelName( const std::vector< Bytecode > &channelExpressions, const std::set< unsigned int > &boundSlots, GlobalVariables &globalVars, ChannelKey &key ){
+//true if this channel name is the same wherever and whenever it's used, and then key is filled in.  a variable part is a literal name
+//if nothing ever gives it a value and a global's value if only the globals do; anything else has to be worked out at runtime
+
+	key.clear();
+	for ( auto exp = channelExpressions.begin(); exp < channelExpressions.end(); exp++ ){
+
+		const std::vector< Instruction > &code = exp -> code();
+		if ( code.size() != 1 ) return false;
+
+		Numerical value;
+		if ( code[0].op == OP_PUSH_CONSTANT ) value = exp -> constant( code[0].operand );
+		else if ( code[0].op == OP_LOAD_VARIABLE and boundSlots.count( code[0].operand ) == 0 ){
+
+			if ( not globalVars.isDefined( code[0].operand ) ){
+
+				key.push_back( CHANNEL_NAME );
+				key.push_back( code[0].operand );
+				continue;
+			}
+			value = globalVars.getValue( code[0].operand );
+		}
+		else return false;
+
+		//doubles are a runtime error, so leave those to the simulation to throw
+		if ( not value.isInt() ) return false;
+		key.push_back( CHANNEL_INDEX );
+		key.push_back( value.getInt() );
+	}
+	return true;
+}
+
+
+void bindConstantChannels( std::map< std::string, ProcessDefinition > &processName2Definition, GlobalVariables &globalVars ){
+//give every message block whose channel name never changes the interned id of that name, so the simulation can skip working it out
+
+	//variables that a process parameter or a binding can give a value to at some point in the simulation
+	std::set< unsigned int > boundSlots;
+	for ( auto pd = processName2Definition.begin(); pd != processName2Definition.end(); pd++ ){
+
+		const CompiledProcess *cp = (pd -> second).compiled.get();
+		boundSlots.insert( (cp -> parameterSlots).begin(), (cp -> parameterSlots).end() );
+		for ( unsigned int i = 0; i < cp -> numberOfNodes(); i++ ){
+
+			if ( cp -> block( i ) -> kind() != BLOCK_MESSAGE_RECEIVE ) continue;
+			const std::vector< unsigned int > &bindings = static_cast< MessageReceiveBlock * >( cp -> block( i ) ) -> getBindingSlots();
+			boundSlots.insert( bindings.begin(), bindings.end() );
+		}
+	}
+
+	ChannelKey key;
+	for ( auto pd = processName2Definition.begin(); pd != processName2Definition.end(); pd++ ){
+
+		const CompiledProcess *cp = (pd -> second).compiled.get();
+		for ( unsigned int i = 0; i < cp -> numberOfNodes(); i++ ){
+
+			Block *b = cp -> block( i );
+			if ( b -> kind() == BLOCK_MESSAGE_SEND ){
+
+				MessageSendBlock *msb = static_cast< MessageSendBlock * >( b );
+				if ( constantChannelName( msb -> getChannelName(), boundSlots, globalVars, key ) ) msb -> setConstantChannel( ChannelNames::intern( key ) );
+			}
+			else if ( b -> kind() == BLOCK_MESSAGE_RECEIVE ){
+
+				MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( b );
+				if ( constantChannelName( mrb -> getChannelName(), boundSlots, globalVars, key ) ) mrb -> setConstantChannel( ChannelNames::intern( key ) );
+			}
+		}
+	}
+}
+
+
 std::pair< std::map< std::string, ProcessDefinition >, std::list< SystemProcess > > secondPassParse( std::vector< Tree<Token> > processDefPTs,
 		                                                                                             std::vector< Token* > tokenisedSystemLine,
 																									 GlobalVariables &globalVars ){
@@ -736,17 +882,18 @@ std::pair< std::map< std::string, ProcessDefinition >, std::list< SystemProcess
 		std::vector< Token * > tokenisedParam = scanLine( betweenBrackets, children[0] -> getLine(), children[0] -> getColumn() );
 		if ( tokenisedParam.size() > 0 ){
 
-			if ( tokenisedParam.back() -> identify() != "Variable" ) throw SyntaxError( tokenisedParam.back(), "Thrown by block parser: Parameter list must trail with a variable." );
+			if ( tokenisedParam.back() -> kind() != TOKEN_VARIABLE ) throw SyntaxError( tokenisedParam.back(), "Thrown by block parser: Parameter list must trail with a variable." );
 			int flip = 0;
 			
 			for ( auto t = tokenisedParam.begin(); t < tokenisedParam.end(); t++ ){
-				if ( (*t) -> identify() == "Variable" and flip == 0 ){
+				if ( (*t) -> kind() == TOKEN_VARIABLE and flip == 0 ){
 
 					flip++; flip %= 2;
 					(pd.parameters).push_back( (*t) -> value() );
+					(pd.parameterSlots).push_back( VariableFrame::slot( (*t) -> value() ) );
 					continue;
 				} 
-				else if ( (*t) -> identify() == "Comma" and flip == 1 ){
+				else if ( (*t) -> kind() == TOKEN_COMMA and flip == 1 ){
 
 					flip++; flip %= 2;
 					continue;
@@ -759,6 +906,7 @@ std::pair< std::map< std::string, ProcessDefinition >, std::list< SystemProcess
 		Block *root = tokenToBlock( children[1], processName, pd.parameters, globalVars.getNames() );
 		(pd.parseTree).setRoot( root );
 		secondParseProcessDef( children[1], root, *pt, pd.parseTree, processName, pd.parameters, globalVars.getNames() );
+		pd.compiled = std::make_shared< const CompiledProcess >( pd.parseTree, pd.parameters, pd.parameterSlots );
 		processName2Definition[ processName ] = pd;
 
 #if DEBUG
@@ -775,6 +923,8 @@ printBlockTree( pd.parseTree, (pd.parseTree).getRoot() );
 		checkProcessDefinition( (pd -> second).parseTree.getRoot(), (pd -> second).parseTree, processName2Definition );
 	}
 
+	bindConstantChannels( processName2Definition, globalVars );
+
 	/*second round parse of system line */
 	std::list< SystemProcess > system;
 	secondParseSystemLine( tokenisedSystemLine, system, processName2Definition, globalVars );
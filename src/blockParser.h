@@ -15,20 +15,51 @@
 #include <string>
 #include <tuple>
 #include <iostream>
+#include <memory>
 #include "parser.h"
 #include "lexer.h"
+#include "bytecode.h"
+
+enum BlockKind { BLOCK_ACTION, BLOCK_CHOICE, BLOCK_PARALLEL, BLOCK_GATE, BLOCK_MESSAGE_RECEIVE, BLOCK_MESSAGE_SEND, BLOCK_PROCESS };
+
+//a channel name as ints, two for each part: whether the part is a name or an index, then the name's variable slot or the index's value
+typedef std::vector< int > ChannelKey;
+enum ChannelPart { CHANNEL_NAME, CHANNEL_INDEX };
+
+class ChannelNames{
+//channel names that are the same wherever they're used, given dense ids while parsing so that the blocks using them can carry
+//the id instead of working out the name every time
+
+	public:
+		static unsigned int intern( const ChannelKey & );
+		static const ChannelKey &key( unsigned int );
+		static unsigned int count( void );
+		static std::vector< std::string > spell( const ChannelKey & );
+};
+
+class CompiledProcess;
 
 class Block{
 
 	protected:
 		Token * inputToken;
-		Block( Token * t, std::string &name, std::vector<std::string> paramNames, std::vector<std::string> globalNames ){inputToken = t;}
+		BlockKind _kind;
+		const CompiledProcess *_definition = NULL; //the compiled definition this block belongs to, and where it sits in it
+		unsigned int _node = 0;
+		bool _recorded = true; //whether transitions here are written to the trajectory (see --record-actions and friends)
+		Block( BlockKind k, Token * t, std::string &name, std::vector<std::string> paramNames, std::vector<std::string> globalNames ){_kind = k; inputToken = t;}
 
 	public:
 		virtual Token * getToken(void) const = 0;
 		virtual std::string identify( void ) const = 0;
-		virtual std::vector< Token * > getRate( void ) const = 0;
-		virtual std::string getOwningProcess( void ) const = 0;
+		BlockKind kind( void ) const { return _kind; }
+		void place( const CompiledProcess *definition, unsigned int node ){ _definition = definition; _node = node; }
+		const CompiledProcess *getDefinition( void ) const { return _definition; }
+		unsigned int getNode( void ) const { return _node; }
+		void setRecorded( bool recorded ){ _recorded = recorded; }
+		bool isRecorded( void ) const { return _recorded; }
+		virtual const Bytecode &getRate( void ) const = 0;
+		virtual const std::string &getOwningProcess( void ) const = 0;
 };
 
 class ActionBlock: public Block {
@@ -36,7 +67,7 @@ class ActionBlock: public Block {
 	private:
 		std::string _owningProcess;
 		Token *_underlyingToken;
-		std::vector< Token * > _RPNrate;
+		Bytecode _RPNrate;
 
 	public:
 		ActionBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
@@ -47,9 +78,9 @@ class ActionBlock: public Block {
 		}
 		Token * getToken(void) const {return _underlyingToken;}
 		std::string identify( void ) const { return "Action"; }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
 		std::string actionName;
-		std::vector< Token * > getRate( void ) const { return _RPNrate; }
+		const Bytecode &getRate( void ) const { return _RPNrate; }
 };
 
 class ChoiceBlock: public Block {
@@ -63,8 +94,8 @@ class ChoiceBlock: public Block {
 		ChoiceBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
 		ChoiceBlock( const ChoiceBlock &cb ) : Block(cb) {}
 		std::string identify( void ) const { return "Choice"; }
-		std::vector< Token * > getRate( void ) const { assert( false ); }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
+		const Bytecode &getRate( void ) const { assert( false ); }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
 };
 
 class ParallelBlock: public Block {
@@ -78,8 +109,8 @@ class ParallelBlock: public Block {
 		ParallelBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
 		ParallelBlock( const ParallelBlock &cb ) : Block(cb) {}
 		std::string identify( void ) const { return "Parallel"; }
-		std::vector< Token * > getRate( void ) const { assert( false ); }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
+		const Bytecode &getRate( void ) const { assert( false ); }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
 };
 
 class GateBlock: public Block {
@@ -87,7 +118,7 @@ class GateBlock: public Block {
 	protected:
 		std::string _owningProcess;
 		Token *_underlyingToken;
-		std::vector< Token * > _RPNexpression;
+		Bytecode _RPNexpression;
 	public:
 		Token * getToken(void) const {return _underlyingToken;}
 		GateBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
@@ -96,9 +127,9 @@ class GateBlock: public Block {
 			_RPNexpression = gb.getConditionExpression();
 		}
 		std::string identify( void ) const { return "Gate"; }
-		std::vector< Token * > getRate( void ) const { assert( false ); }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
-		std::vector< Token * > getConditionExpression( void ) const { return _RPNexpression; }
+		const Bytecode &getRate( void ) const { assert( false ); }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
+		const Bytecode &getConditionExpression( void ) const { return _RPNexpression; }
 };
 
 class MessageReceiveBlock: public Block {
@@ -107,10 +138,12 @@ class MessageReceiveBlock: public Block {
 		bool _handshake, _check, _usesSets=false,_hasBindingVar=false;
 		std::string _owningProcess;
 		Token *_underlyingToken;
-		std::vector< std::vector< Token * > > _channelNames;
+		std::vector< Bytecode > _channelNames;
 		std::vector< std::string > _bindingVariables;
-		std::vector< std::vector< Token * > > _RPNexpressions;
-		std::vector< Token * > _RPNrate;
+		std::vector< unsigned int > _bindingSlots;
+		std::vector< Bytecode > _RPNexpressions;
+		Bytecode _RPNrate;
+		int _constantChannel = -1; //interned id of the channel name if it never changes
 
 	public:
 		MessageReceiveBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
@@ -122,19 +155,24 @@ class MessageReceiveBlock: public Block {
 			_RPNexpressions = mb.getSetExpression();
 			_channelNames = mb.getChannelName();
 			_bindingVariables = mb.getBindingVariable();
+			_bindingSlots = mb.getBindingSlots();
 			_RPNrate = mb.getRate();
+			_constantChannel = mb.getConstantChannel();
 		}
 		Token * getToken(void) const {return _underlyingToken;}
 		bool isHandshake( void ) const { return _handshake; }
 		bool isCheck( void ) const { return _check; }
 		bool bindsVariable( void ) const { return _hasBindingVar; }
 		bool usesSets( void ) const { return _usesSets; }
-		std::vector< std::vector< Token * > > getChannelName( void ) const { return _channelNames; }
-		std::vector< std::string > getBindingVariable( void ) const { return _bindingVariables; }
-		std::vector< std::vector< Token * > > getSetExpression( void ) const { return _RPNexpressions; }
+		const std::vector< Bytecode > &getChannelName( void ) const { return _channelNames; }
+		const std::vector< std::string > &getBindingVariable( void ) const { return _bindingVariables; }
+		const std::vector< unsigned int > &getBindingSlots( void ) const { return _bindingSlots; }
+		const std::vector< Bytecode > &getSetExpression( void ) const { return _RPNexpressions; }
+		int getConstantChannel( void ) const { return _constantChannel; }
+		void setConstantChannel( int id ){ _constantChannel = id; }
 		std::string identify( void ) const { return "MessageReceive"; }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
-		std::vector< Token * > getRate( void ) const { return _RPNrate; }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
+		const Bytecode &getRate( void ) const { return _RPNrate; }
 };
 
 class MessageSendBlock: public Block {
@@ -143,9 +181,10 @@ class MessageSendBlock: public Block {
 		bool _handshake, _kill;
 		std::string _owningProcess;
 		Token *_underlyingToken;
-		std::vector< std::vector< Token * > > _channelNames;
-		std::vector< std::vector< Token * > > _RPNexpressions;
-		std::vector< Token * > _RPNrate;
+		std::vector< Bytecode > _channelNames;
+		std::vector< Bytecode > _RPNexpressions;
+		Bytecode _RPNrate;
+		int _constantChannel = -1; //interned id of the channel name if it never changes
 	public:
 		MessageSendBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
 		MessageSendBlock( const MessageSendBlock &mb ) : Block(mb){
@@ -155,23 +194,27 @@ class MessageSendBlock: public Block {
 			_RPNexpressions = mb.getParameterExpression();
 			_channelNames = mb.getChannelName();
 			_RPNrate = mb.getRate();
+			_constantChannel = mb.getConstantChannel();
 		}
 		Token * getToken(void) const {return _underlyingToken;}
 		bool isHandshake( void ) const { return _handshake; }
 		bool isKill( void ) const { return _kill; }
-		std::vector< std::vector< Token * > > getChannelName( void ) const { return _channelNames; }
-		std::vector< std::vector< Token * > > getParameterExpression( void ) const { return _RPNexpressions; }
+		const std::vector< Bytecode > &getChannelName( void ) const { return _channelNames; }
+		const std::vector< Bytecode > &getParameterExpression( void ) const { return _RPNexpressions; }
+		int getConstantChannel( void ) const { return _constantChannel; }
+		void setConstantChannel( int id ){ _constantChannel = id; }
 		std::string identify( void ) const { return "MessageSend"; }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
-		std::vector< Token * > getRate( void ) const { return _RPNrate; }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
+		const Bytecode &getRate( void ) const { return _RPNrate; }
 };
 
 class ProcessBlock: public Block {
 
 	protected:
 		std::string _processName, _owningProcess;
-		std::vector< std::vector<Token * > > _parameterExpressions;
+		std::vector< Bytecode > _parameterExpressions;
 		Token *_underlyingToken;
+		const CompiledProcess *_target = NULL; //definition of the process we call, resolved once all definitions are compiled
 	public:
 		ProcessBlock( Token *, std::string, std::vector<std::string>, std::vector<std::string> );
 		ProcessBlock( const ProcessBlock &pb ) : Block(pb) {
@@ -181,10 +224,34 @@ class ProcessBlock: public Block {
 		}
 		Token * getToken(void) const {return _underlyingToken;}
 		std::string identify( void ) const { return "Process"; }
-		std::string getProcessName( void ) const { return _processName; }
-		std::vector< std::vector< Token * > > getParameterExpressions( void ) const { return _parameterExpressions; }
-		std::vector< Token * > getRate( void ) const { assert( false ); }
-		std::string getOwningProcess( void ) const { return _owningProcess; }
+		const std::string &getProcessName( void ) const { return _processName; }
+		const std::vector< Bytecode > &getParameterExpressions( void ) const { return _parameterExpressions; }
+		void setTarget( const CompiledProcess *target ){ _target = target; }
+		const CompiledProcess *getTarget( void ) const { return _target; }
+		const Bytecode &getRate( void ) const { assert( false ); }
+		const std::string &getOwningProcess( void ) const { return _owningProcess; }
+};
+
+
+class CompiledProcess{
+//a process definition's block tree laid out once as a preorder array of nodes with child offsets.  it isn't modified after parsing,
+//so it's shared by every simulation and a system process running it is just a cursor to one of its nodes
+
+	private:
+		std::vector< Block * > _nodes;
+		std::vector< unsigned int > _childOffsets; //children of node i are _children[ _childOffsets[i] ] up to _children[ _childOffsets[i+1] - 1 ]
+		std::vector< unsigned int > _children;
+		void number( Tree<Block> &, Block * );
+
+	public:
+		const std::vector< std::string > parameters;
+		const std::vector< unsigned int > parameterSlots;
+		CompiledProcess( Tree<Block> &, const std::vector< std::string > &, const std::vector< unsigned int > & );
+		Block *block( unsigned int node ) const { return _nodes[node]; }
+		unsigned int numberOfNodes( void ) const { return _nodes.size(); }
+		unsigned int numberOfChildren( unsigned int node ) const { return _childOffsets[node+1] - _childOffsets[node]; }
+		unsigned int child( unsigned int node, unsigned int i ) const { return _children[ _childOffsets[node] + i ]; }
+		bool isLeaf( unsigned int node ) const { return _childOffsets[node+1] == _childOffsets[node]; }
 };
 
 
@@ -193,6 +260,8 @@ class ProcessDefinition{
 	public:
 		Tree<Block> parseTree;
 		std::vector< std::string > parameters;
+		std::vector< unsigned int > parameterSlots;
+		std::shared_ptr< const CompiledProcess > compiled;
 };
 
 class SystemProcess;
@@ -200,50 +269,53 @@ class Candidate;
 
 
 
-class ParameterValues{
+class ParameterValues : public VariableFrame {};
+
+class SystemProcess{
 
 	public:
-		std::map< std::string, Numerical > values;
-	
-	ParameterValues(){}
-	ParameterValues( const ParameterValues &pv ){
+		const CompiledProcess *definition = NULL; //the definition this process is running and the node it's at
+		unsigned int node = 0;
+		ParameterValues parameterValues;
+		VariableFrame localVariables; //system line variable substitutions and bound variables
+		unsigned int id = 0; //order in which the process entered the system, so that iteration doesn't depend on memory addresses
+		unsigned int count = 1; //number of identical copies this stands for, which is only ever more than one with --lump
+		std::list< SystemProcess * >::iterator position; //where it is in the system's list of processes, so it can leave in constant time
+		SystemProcess(){}
+		SystemProcess( const SystemProcess &sp ){
 
-		values = pv.values;
-	}
-	void updateValue(std::string pName, Numerical value){
+			definition = sp.definition;
+			node = sp.node;
+			parameterValues = sp.parameterValues;
+			localVariables = sp.localVariables;
+		}
+		Block *currentBlock( void ) const { return definition -> block( node ); }
+};
 
-		if ( values.count(pName) > 0 ) values.erase(values.find(pName));
-		values[pName] = value;
-	}
-	void printValues(){
-		std::cout << "number of values: " << values.size() << std::endl;
-		for ( auto i = values.begin(); i != values.end(); i++){
 
-			if ((i->second).isDouble()){
+class ParallelContinuation{
+//a process that starts running alongside a candidate if that candidate fires.  continuations are chained and each link is shared by every
+//candidate below the parallel operator that made it, so they're only turned into system processes once a candidate is actually chosen
 
-				std::cout << i -> first << " " << (i -> second).getDouble() << " Double" << std::endl;
-			}
-			else{
+	public:
+		const CompiledProcess *definition;
+		unsigned int node;
+		ParameterValues parameterValues;
+		std::shared_ptr< const ParallelContinuation > previous; //made by an enclosing parallel operator, NULL at the end of the chain
+		ParallelContinuation( const CompiledProcess *d, unsigned int n, const ParameterValues &pv, const std::shared_ptr< const ParallelContinuation > &p ){
 
-				std::cout << i -> first << " " << (i -> second).getInt() << " Int" << std::endl;
-			}
+			definition = d;
+			node = n;
+			parameterValues = pv;
+			previous = p;
 		}
-	}
 };
 
-class SystemProcess{
 
-	public:
-		Tree<Block> parseTree;
-		ParameterValues parameterValues;
-		std::map< std::string, Numerical > localVariables; //system line variable substitutions and bound variables
-		SystemProcess(){}
-		SystemProcess( const SystemProcess &sp ){
+struct SystemProcessOrder{
+//order maps keyed on system processes by id rather than by pointer value
 
-			parseTree = sp.parseTree;
-			parameterValues = sp.parameterValues;
-			localVariables = sp.localVariables;
-		}
+	bool operator()( const SystemProcess *a, const SystemProcess *b ) const { return a -> id < b -> id; }
 };
 
 
@@ -252,34 +324,25 @@ class Candidate{
 	public:
 		Block *actionCandidate;
 		ParameterValues parameterValues;
-		std::map< std::string, Numerical > localVariables;
+		VariableFrame localVariables;
 		SystemProcess *processInSystem;
 		double rate;
+		int slot = -1; //position in the transition scheduler, -1 if this candidate can't currently fire
 		std::vector< Numerical > rangeEvaluation;
-		std::list< SystemProcess > parallelProcesses;
-		Candidate( Block *b, ParameterValues pv, std::map< std::string, Numerical > lv, SystemProcess *si, std::list< SystemProcess > pp ){
+		std::shared_ptr< const ParallelContinuation > parallelContinuations;
+		Candidate( Block *b, const ParameterValues &pv, const VariableFrame &lv, SystemProcess *si, const std::shared_ptr< const ParallelContinuation > &pc ){
 
 			actionCandidate = b;
 			parameterValues = pv;
 			localVariables = lv;
 			processInSystem = si;
-			parallelProcesses = pp;
+			parallelContinuations = pc;
 		}
-		std::vector< std::vector< Token * > > getChannelName(void){
+		const std::vector< Bytecode > &getChannelName(void) const {
 	
-			assert( actionCandidate -> identify() == "MessageSend" or actionCandidate -> identify() == "MessageReceive" );
-			std::vector< std::vector< Token * > > channelName;
-			if ( actionCandidate -> identify() == "MessageSend" ){
-
-				MessageSendBlock *msb = dynamic_cast< MessageSendBlock * >(actionCandidate);
-				channelName = msb -> getChannelName();
-			}
-			else if (actionCandidate -> identify() == "MessageReceive"){
-
-				MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >(actionCandidate);
-				channelName = mrb -> getChannelName();
-			}
-			return channelName; 
+			assert( actionCandidate -> kind() == BLOCK_MESSAGE_SEND or actionCandidate -> kind() == BLOCK_MESSAGE_RECEIVE );
+			if ( actionCandidate -> kind() == BLOCK_MESSAGE_SEND ) return static_cast< MessageSendBlock * >(actionCandidate) -> getChannelName();
+			else return static_cast< MessageReceiveBlock * >(actionCandidate) -> getChannelName();
 		}
 };
 
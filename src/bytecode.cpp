@@ -0,0 +1,81 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <map>
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+#include "bytecode.h"
+
+
+static const std::map< std::string, OpCode > operatorOpCodes = {{"neg", OP_NEG},
+							      {"abs", OP_ABS},
+							      {"sqrt", OP_SQRT},
+							      {"+", OP_ADD},
+							      {"-", OP_SUB},
+							      {"*", OP_MUL},
+							      {"/", OP_DIV},
+							      {"^", OP_POW},
+							      {"min", OP_MIN},
+							      {"max", OP_MAX},
+							      {"==", OP_EQ},
+							      {"!=", OP_NE},
+							      {">", OP_GT},
+							      {"<", OP_LT},
+							      {">=", OP_GE},
+							      {"<=", OP_LE},
+							      {"&", OP_AND},
+							      {"|", OP_OR},
+							      {"~", OP_NOT},
+							      {"..", OP_RANGE},
+							      {"U", OP_UNION},
+							      {"I", OP_INTERSECT},
+							      {"\\", OP_DIFFERENCE}};
+
+
+Bytecode::Bytecode( const std::vector< Token * > &rpn ){
+
+	_rpn = rpn;
+	int depth = 0;
+
+	for ( auto t = rpn.begin(); t < rpn.end(); t++ ){
+
+		Instruction ins;
+		TokenKind kind = (*t) -> kind();
+
+		if ( kind == TOKEN_INT_LITERAL or kind == TOKEN_DOUBLE_LITERAL ){
+
+			Numerical n;
+			if ( kind == TOKEN_INT_LITERAL ) n.setInt( atoi( (*t) -> value().c_str() ) );
+			else n.setDouble( atof( (*t) -> value().c_str() ) );
+			ins.op = OP_PUSH_CONSTANT;
+			ins.operand = _constants.size();
+			_constants.push_back( n );
+			depth++;
+		}
+		else if ( kind == TOKEN_VARIABLE ){
+
+			ins.op = OP_LOAD_VARIABLE;
+			ins.operand = VariableFrame::slot( (*t) -> value() );
+			depth++;
+		}
+		else{
+
+			//tokens that aren't operators the evaluator knows about are ignored, as they always have been
+			if ( kind != TOKEN_OPERATOR and kind != TOKEN_COMPARISON and kind != TOKEN_SET_OPERATION and kind != TOKEN_FUNCTION ) continue;
+			auto op = operatorOpCodes.find( (*t) -> value() );
+			if ( op == operatorOpCodes.end() ) continue;
+			ins.op = op -> second;
+			ins.operand = 0;
+		}
+
+		_code.push_back( ins );
+		_instructionTokens.push_back( *t );
+		_maxDepth = std::max( _maxDepth, (unsigned int) depth );
+	}
+}
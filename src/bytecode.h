@@ -0,0 +1,57 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <vector>
+#include <string>
+#include "lexer.h"
+#include "numerical.h"
+#include "frame.h"
+
+enum OpCode : unsigned char {
+
+	OP_PUSH_CONSTANT, OP_LOAD_VARIABLE,
+	OP_NEG, OP_ABS, OP_SQRT,
+	OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW, OP_MIN, OP_MAX,
+	OP_EQ, OP_NE, OP_GT, OP_LT, OP_GE, OP_LE,
+	OP_AND, OP_OR, OP_NOT,
+	OP_RANGE, OP_UNION, OP_INTERSECT, OP_DIFFERENCE
+};
+
+
+struct Instruction{
+
+	OpCode op;
+	unsigned int operand; //index into the constant table or the variable's frame slot for pushes, unused otherwise
+};
+
+
+class Bytecode{
+//an RPN expression from the shunting yard, lowered once into opcodes with literals decoded and variable names
+//resolved to frame slots so that evaluation never has to look at token strings
+
+	private:
+		std::vector< Instruction > _code;
+		std::vector< Token * > _instructionTokens; //the token each instruction came from, for error messages
+		std::vector< Numerical > _constants;
+		std::vector< Token * > _rpn;
+		unsigned int _maxDepth = 0;
+
+	public:
+		Bytecode(){}
+		Bytecode( const std::vector< Token * > & );
+		const std::vector< Instruction > &code( void ) const { return _code; }
+		Token *instructionToken( unsigned int i ) const { return _instructionTokens[i]; }
+		const Numerical &constant( unsigned int i ) const { return _constants[i]; }
+		const std::vector< Token * > &rpn( void ) const { return _rpn; }
+		unsigned int maxDepth( void ) const { return _maxDepth; }
+};
+
+#endif
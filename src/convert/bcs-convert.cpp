@@ -0,0 +1,122 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include "../binary.h"
+#include "../error_handling.h"
+#include "../common.h"
+
+
+static const char *help=
+"bcs-convert turns a binary bcs trajectory file (from bcs --format bin) back into the text format.\n"
+"To run bcs-convert, do:\n"
+"  ./bcs-convert [arguments] simulationOutput.simulation.bcsb\n"
+"Optional arguments are:\n"
+"  -o,--output               output file name prefix (default: write to stdout),\n"
+"  -h,--help                 show useage information,\n"
+"  -v,--version              show version.\n";
+
+
+struct Arguments {
+
+	std::string targetFilename;
+	std::string outputFilename;
+};
+
+
+void showHelp(){
+
+	std::cout << help;
+	std::cout << "Version: " << VERSION << std::endl;
+}
+
+
+Arguments parseArguments( int argc, char** argv ){
+
+	if( argc < 2 ){
+
+		std::cout << "Exiting with error.  No binary trajectory file specified." << std::endl;
+		showHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	Arguments args;
+	for ( int i = 1; i < argc; ){
+
+		std::string flag( argv[ i ] );
+
+		if ( ( flag == "-o" or flag == "--output" ) and i + 1 < argc ){
+
+			args.outputFilename = std::string( argv[ i + 1 ] ) + ".simulation.bcs";
+			i+=2;
+		}
+		else if ( flag == "-h" or flag == "--help" ){
+
+			showHelp();
+			exit(EXIT_SUCCESS);
+		}
+		else if ( flag == "-v" or flag == "--version" ){
+
+			std::cout << "Version: " << VERSION << std::endl;
+			exit(EXIT_SUCCESS);
+		}
+		else{
+
+			if ( flag.substr(0,1) == "-" ){
+
+				std::cout << "Exiting with error.  Unknown flag specified." << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+
+			args.targetFilename = flag;
+			i+=1;
+		}
+	}
+	return args;
+}
+
+
+int main( int argc, char** argv ){
+
+	Arguments args = parseArguments( argc, argv );
+
+	std::ifstream inFile( args.targetFilename, std::ios::binary );
+	if ( not inFile.is_open() ){
+
+		std::cerr << "Exiting with error.  " << BadSourcePath().what() << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::ofstream outFile;
+	if ( not args.outputFilename.empty() ){
+
+		outFile.open( args.outputFilename );
+		if ( not outFile.is_open() ){
+
+			std::cerr << "Exiting with error.  " << BadOutputPath().what() << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	std::ostream &out = args.outputFilename.empty() ? std::cout : outFile;
+
+	try{
+
+		BinaryReader reader( inFile );
+		BinaryRecord record;
+		while ( reader.next( record ) ) reader.writeText( record, out );
+	}
+	catch ( BadTrajectoryFile &e ){
+
+		std::cerr << "Exiting with error.  " << e.what() << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return 0;
+}
@@ -25,6 +25,40 @@ struct BadOutputPath : public std::exception {
 	}
 };
 
+struct BadTrajectoryFile : public std::exception {
+	const char * what () const throw () {
+		return "Not a bcs binary trajectory file, or the file is truncated.";
+	}
+};
+
+struct BadSummaryGrid : public std::exception {
+	const char * what () const throw () {
+		return "Summary time grid should be start:stop:width with start < stop, a positive width, and at most 10^7 bins.";
+	}
+};
+
+struct BadSummarySelector : public std::exception {
+	std::string message;
+	BadSummarySelector( const std::string &selector ){
+
+		message = "Summary selector " + selector + " should be name[:process[:parameter]] and match an action or channel in the model.";
+	}
+	const char * what () const throw () {
+		return message.c_str();
+	}
+};
+
+struct BadRecordFilter : public std::exception {
+	std::string message;
+	BadRecordFilter( const std::string &kind, const std::string &name ){
+
+		message = "Record filter for " + kind + " " + name + " does not match any " + kind + " in the model.";
+	}
+	const char * what () const throw () {
+		return message.c_str();
+	}
+};
+
 struct UnbalancedParentheses : public std::exception {
 	std::string badToken, lineNum, colNum;	
 	UnbalancedParentheses( Token *t ){
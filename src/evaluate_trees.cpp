@@ -22,11 +22,11 @@ bool castToDouble( std::vector<Token * > expression, GlobalVariables &gv, Parame
 
 	for ( auto t = expression.begin(); t < expression.end(); t++ ){
 
-		if ( (*t) -> identify() == "DoubleLiteral" ) return true;
-		if ( (*t) -> identify() == "Variable" ){
+		if ( (*t) -> kind() == TOKEN_DOUBLE_LITERAL ) return true;
+		if ( (*t) -> kind() == TOKEN_VARIABLE ){
 
-			if (gv.values.count((*t) -> value()) > 0) return true;
-			if (pv.values.count((*t) -> value()) > 0) return true;
+			if (gv.isDefined((*t) -> value())) return true;
+			if (pv.isDefined((*t) -> value())) return true;
 		}
 	}
 	return false;
@@ -37,7 +37,7 @@ bool isOperator( Token *t ){
 
 	if ( not t ) return false;
 
-	if( t -> identify() == "SetOperation" or t -> identify() == "Operator" or t -> identify() == "Comparison" ) return true;
+	if( t -> kind() == TOKEN_SET_OPERATION or t -> kind() == TOKEN_OPERATOR or t -> kind() == TOKEN_COMPARISON ) return true;
 	else return false;
 }
 
@@ -46,7 +46,7 @@ bool isOperand( Token *t ){
 
 	if ( not t ) return false;
 
-	if( t -> identify() == "IntLiteral" or t -> identify() == "DoubleLiteral" or t -> identify() == "Variable" ) return true;
+	if( t -> kind() == TOKEN_INT_LITERAL or t -> kind() == TOKEN_DOUBLE_LITERAL or t -> kind() == TOKEN_VARIABLE ) return true;
 	else return false;
 }
 
@@ -151,7 +151,7 @@ bool isValidInfixExpression( std::vector< Token * > inputExp ){
 	//terminate if we've got down to a single value
 	if (inputExp.size() == 1){
 
-		if (inputExp[0] -> identify() == "Variable" or inputExp[0] -> identify() == "IntLiteral" or inputExp[0] -> identify() == "DoubleLiteral") return true;
+		if (inputExp[0] -> kind() == TOKEN_VARIABLE or inputExp[0] -> kind() == TOKEN_INT_LITERAL or inputExp[0] -> kind() == TOKEN_DOUBLE_LITERAL) return true;
 		else return false;
 	}
 
@@ -168,7 +168,7 @@ bool isValidInfixExpression( std::vector< Token * > inputExp ){
 		if ( (*t) -> value() == "(" ) parenStack.push( *t );
 		else if ( (*t) -> value() == ")" ) parenStack.pop();
 
-		if ( (isOperator(*t) or (*t) -> identify() == "Function") and parenStack.empty() ){
+		if ( (isOperator(*t) or (*t) -> kind() == TOKEN_FUNCTION) and parenStack.empty() ){
 
 			int precedence;
 			if ((*t) -> value() == "-" and t == inputExp.begin()){//is negation
@@ -242,7 +242,7 @@ bool isValidInfixExpression( std::vector< Token * > inputExp ){
 
 			if ( (*subidx) -> value() == "(" ) commaStack.push( *subidx );
 			else if ( (*subidx) -> value() == ")" ) commaStack.pop();
-			if (commaStack.empty() and (*subidx) -> identify() == "Comma"){
+			if (commaStack.empty() and (*subidx) -> kind() == TOKEN_COMMA){
 			
 				commaidx = subidx;
 				foundComma = true;
@@ -295,7 +295,7 @@ std::vector< Token * > shuntingYard( std::vector< Token * > &inputExp ){
 
 	for ( auto t = inputExp.begin(); t < inputExp.end(); t++ ){
 
-		if ( (*t) -> identify() == "Comma" ){
+		if ( (*t) -> kind() == TOKEN_COMMA ){
 
 			while( operatorStack.top() -> value() != "(" ){
 
@@ -312,7 +312,7 @@ std::vector< Token * > shuntingYard( std::vector< Token * > &inputExp ){
 
 			expRPN.push_back( *t );
 		}
-		if ( (*t) -> identify() == "Function" ){
+		if ( (*t) -> kind() == TOKEN_FUNCTION ){
 
 			operatorStack.push(*t); //push the function on the stack
 			
@@ -327,7 +327,7 @@ std::vector< Token * > shuntingYard( std::vector< Token * > &inputExp ){
 		if ( isOperator(*t) and (*t) -> value() != "-" ){ //any operator other than a minus sign
 
 			while ( (not operatorStack.empty())
-				and (operatorStack.top() -> identify() == "Function" 
+				and (operatorStack.top() -> kind() == TOKEN_FUNCTION 
 			        or ( isOperator(operatorStack.top()) and precedence(operatorStack.top()) > precedence(*t) ) 
 			        or ( isOperator(operatorStack.top()) and precedence(operatorStack.top()) == precedence(*t) and isLeftAsso(operatorStack.top()) ) )
 				and ( ( operatorStack.top() -> value() != "(") ) ){
@@ -342,7 +342,7 @@ std::vector< Token * > shuntingYard( std::vector< Token * > &inputExp ){
 			if (not isOperand(prevToken) ){ //the minus sign is a unary negative operator
 
 				while ( (not operatorStack.empty())
-					and (operatorStack.top() -> identify() == "Function" 
+					and (operatorStack.top() -> kind() == TOKEN_FUNCTION 
 					or ( (*t) -> value() == "neg" ) ) //the only operators you can pop are other negative functions
 					and ( ( operatorStack.top() -> value() != "(") ) ){
 
@@ -354,7 +354,7 @@ std::vector< Token * > shuntingYard( std::vector< Token * > &inputExp ){
 			else{ //the minus sign is a binary subtraction operator
 
 				while ( (not operatorStack.empty())
-					and (operatorStack.top() -> identify() == "Function" 
+					and (operatorStack.top() -> kind() == TOKEN_FUNCTION 
 					or ( isOperator(operatorStack.top()) and precedence(operatorStack.top()) > precedence(*t) ) 
 					or ( isOperator(operatorStack.top()) and precedence(operatorStack.top()) == precedence(*t) and isLeftAsso(operatorStack.top()) ) )
 					and ( ( operatorStack.top() -> value() != "(") ) ){
@@ -403,7 +403,7 @@ std::cout << "-------" << std::endl;
 	while ( not operatorStack.empty() ){
 
 		if ( operatorStack.top() -> value() == ")" or operatorStack.top() -> value() == "(" ) throw UnbalancedParentheses(operatorStack.top());
-		if ( (not isOperator(operatorStack.top())) and (operatorStack.top() -> identify() != "Function") ){
+		if ( (not isOperator(operatorStack.top())) and (operatorStack.top() -> kind() != TOKEN_FUNCTION) ){
 			throw SyntaxError( operatorStack.top(), "Thrown by expression parser: Expression is incorrectly formatted." );
 		}
 
@@ -423,425 +423,8 @@ std::cout << "Whole expression in RPN: ";
 	return expRPN;
 }
 
-
-inline Numerical substituteVariable( Token *t, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables ){
-//takes a variable token and looks for valid substitutions from the process's parameter values, the system's global variables, and local variables within the system process
-
-	Numerical out;
-	if ( t -> identify() == "DoubleLiteral" ){
-
-		std::string litValue = t -> value();
-		out.setDouble(atof(litValue.c_str()));
-		return out;
-	}
-	else if ( t -> identify() == "IntLiteral" ){
-
-		std::string litValue = t -> value();
-		out.setInt(atoi(litValue.c_str()));
-		return out;
-	}
-	else{
-
-		assert( t -> identify() == "Variable" );
-		if ( localVariables.count( t -> value() ) > 0 ){
-
-			return localVariables[ t -> value() ];
-		}
-		else if ( globalVariables.values.count( t -> value() ) > 0 ){
-
-			return globalVariables.values[ t -> value() ];
-		}
-		else if ( param2value.values.count( t -> value() ) > 0 ){
-
-			return param2value.values[ t -> value() ];
-		}
-		else throw UndefinedVariable( t );
-	}
-}
-
-
-inline bool variableIsDefined( Token *t, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables ){
-//takes a variable token and looks for valid substitutions from the process's parameter values, the system's global variables, and local variables within the system process
-
-	assert( t -> identify() == "Variable" );
-	if ( localVariables.count( t -> value() ) > 0 ){
-
-		return true;
-	}
-	else if ( globalVariables.values.count( t -> value() ) > 0 ){
-
-		return true;
-	}
-	else if ( param2value.values.count( t -> value() ) > 0 ){
-
-		return true;
-	}
-	else return false;
-}
-
-
-Numerical evalRPN_numerical( std::vector< Token * > inputRPN, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
-
-	//quick exit for simple cases
-	if (inputRPN.size() == 1){
-		Numerical result = substituteVariable( inputRPN[0], param2value, globalVariables, localVariables );
-		return result;
-	}
-
-	std::stack<RPNoperand *> evalStack;	
-
-	for ( auto t = inputRPN.begin(); t < inputRPN.end(); t++ ){
-
-		if ( isOperator(*t) or (*t) -> identify() == "Function"){
-
-			if ( (*t) -> value() == "abs" or (*t) -> value() == "sqrt" or (*t) ->value() == "neg" ){ //unary
-
-				if ( evalStack.size() < 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand = evalStack.top();
-				evalStack.pop();
-				if (operand -> identify() != "Numerical") throw WrongType(*t,operand -> identify());
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand);
-				Numerical op_n = numptr -> getValue();
-				Numerical result;
-				if ( (*t) -> value() == "abs" ){
-
-					if (op_n.isInt()) result.setInt(std::abs(op_n.getInt()));
-					else result.setDouble(std::abs(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "sqrt" ){
-
-					if (op_n.isInt()) result.setInt(sqrt(op_n.getInt()));
-					else result.setDouble(sqrt(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "neg" ){
-
-					if (op_n.isInt()) result.setInt(-op_n.getInt());
-					else result.setDouble(-op_n.getDouble());
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for function evaluation.");
-
-				evalStack.push( new NumericalOperand(result) );
-				delete operand;
-			}
-			else if ( (*t) -> value() == "min" or (*t) -> value() == "max" or (*t) -> value() == "+" or (*t) -> value() == "-" or (*t) -> value() == "*" or (*t) -> value() == "/" or (*t) -> value() == "^"){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-
-				//upcast
-				bool upcast = false;
-				if (op1_n.isDouble() or op2_n.isDouble()) upcast = true;
-
-				Numerical result;
-				if ( (*t) -> value() == "+" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() + op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() + op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "-" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() - op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() - op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "/" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() / op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() / op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "*" ){
-					if (upcast) result.setDouble( op1_n.doubleCast() * op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() * op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "^" ){
-
-					if (upcast) result.setDouble( pow(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( pow(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "min" ){
-
-					if (upcast) result.setDouble( std::min(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::min(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "max" ){
-
-					if (upcast) result.setDouble( std::max(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::max(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for arithmetic evaluation.");
-
-				evalStack.push( new NumericalOperand(result) );
-				delete operand1; delete operand2;
-			}
-
-		}
-		else if ( isOperand(*t) ){
-
-			//check types
-			if ((*t) -> identify() != "DoubleLiteral" and (*t) -> identify() != "IntLiteral" and (*t) -> identify() != "Variable"){
-
-				throw WrongType(*t, "Operands must be doubles, ints, or variables.");
-			}			
-
-			Numerical result = substituteVariable( *t, param2value, globalVariables, localVariables );
-			evalStack.push( new NumericalOperand(result) );
-		}
-	}
-
-	if ( evalStack.top() -> identify() != "Numerical" ) throw SyntaxError( inputRPN[0], "Expression must evaluate to a numerical value." );
-
-	NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(evalStack.top());
-	Numerical result = numptr -> getValue();
-	delete evalStack.top();
-
-#if DEBUG_RPN
-	if (result.isInt()) std::cout << "Int is: " << result.getInt() << std::endl;
-	else std::cout << "Double is: " << result.getDouble() << std::endl;
-#endif
-
-	return result;
-}
-
-
-bool evalRPN_condition( std::vector< Token * > inputRPN, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
-
-	std::stack<RPNoperand *> evalStack;	
-
-	for ( auto t = inputRPN.begin(); t < inputRPN.end(); t++ ){
-
-		if ( isOperator(*t) or (*t) -> identify() == "Function"){
-
-			if ( (*t) -> value() == "abs" or (*t) -> value() == "sqrt" or (*t) ->value() == "neg" ){ //unary
-
-				if ( evalStack.size() < 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand = evalStack.top();
-				evalStack.pop();
-				if (operand -> identify() != "Numerical") throw WrongType(*t,operand -> identify());
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand);
-				Numerical op_n = numptr -> getValue();
-				Numerical result;
-				if ( (*t) -> value() == "abs" ){
-
-					if (op_n.isInt()) result.setInt(std::abs(op_n.getInt()));
-					else result.setDouble(std::abs(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "sqrt" ){
-
-					if (op_n.isInt()) result.setInt(sqrt(op_n.getInt()));
-					else result.setDouble(sqrt(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "neg" ){
-
-					if (op_n.isInt()) result.setInt(-op_n.getInt());
-					else result.setDouble(-op_n.getDouble());
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for function evaluation.");
-
-				evalStack.push( new NumericalOperand(result) );
-				delete operand;
-			}
-			else if ( (*t) -> value() == "min" or (*t) -> value() == "max" or (*t) -> value() == "+" or (*t) -> value() == "-" or (*t) -> value() == "*" or (*t) -> value() == "/" or (*t) -> value() == "^"){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-
-				//upcast
-				bool upcast = false;
-				if (op1_n.isDouble() or op2_n.isDouble()) upcast = true;
-
-				Numerical result;
-				if ( (*t) -> value() == "+" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() + op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() + op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "-" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() - op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() - op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "/" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() / op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() / op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "*" ){
-					if (upcast) result.setDouble( op1_n.doubleCast() * op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() * op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "^" ){
-
-					if (upcast) result.setDouble( pow(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( pow(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "min" ){
-
-					if (upcast) result.setDouble( std::min(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::min(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "max" ){
-
-					if (upcast) result.setDouble( std::max(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::max(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for arithmetic evaluation.");
-
-				evalStack.push( new NumericalOperand(result) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == "==" or (*t) -> value() == "!=" or (*t) -> value() == ">" or (*t) -> value() == "<" or (*t) -> value() == ">=" or (*t) -> value() == "<=" ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-
-				bool result;
-				if ( (*t) -> value() == "==" ){
-					result = op1_n.doubleCast() == op2_n.doubleCast();
-				}
-				else if ( (*t) -> value() == "!=" ){
-					result = op1_n.doubleCast() != op2_n.doubleCast();
-				}
-				else if ( (*t) -> value() == ">" ){
-					result = op1_n.doubleCast() > op2_n.doubleCast();
-				}
-				else if ( (*t) -> value() == "<" ){
-					result = op1_n.doubleCast() < op2_n.doubleCast();
-				}
-				else if ( (*t) -> value() == ">=" ){
-					result = op1_n.doubleCast() >= op2_n.doubleCast();
-				}
-				else if ( (*t) -> value() == "<=" ){
-					result = op1_n.doubleCast() <= op2_n.doubleCast();
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for comparison evaluation.");
-
-				evalStack.push( new BoolOperand(result) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == "|" or (*t) -> value() == "&" ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Bool") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Bool") throw WrongType(*t,operand2 -> identify());
-				bool op1_d,op2_d;
-				BoolOperand *boolptr = dynamic_cast<BoolOperand *>(operand1);
-				op1_d = boolptr -> getValue();
-				boolptr = dynamic_cast<BoolOperand *>(operand2);
-				op2_d = boolptr -> getValue();
-
-				bool result;
-				if ( (*t) -> value() == "|" ){
-					result = op1_d or op2_d;
-				}
-				else if ( (*t) -> value() == "&" ){
-					result = op1_d and op2_d;
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for Boolean evaluation.");
-
-				evalStack.push( new BoolOperand(result) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == "~" ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() < 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand = evalStack.top();
-				evalStack.pop();
-				if (operand -> identify() != "Bool") throw WrongType(*t,operand -> identify());
-				bool op_b;
-				BoolOperand *boolptr = dynamic_cast<BoolOperand *>(operand);
-				op_b = boolptr -> getValue();
-
-				bool result = not op_b;
-				evalStack.push( new BoolOperand(result) );
-				delete operand;
-			}
-			
-		}
-		else if ( isOperand(*t) ){
-
-			//check types
-			if ((*t) -> identify() != "DoubleLiteral" and (*t) -> identify() != "IntLiteral" and (*t) -> identify() != "Variable"){
-
-				throw WrongType(*t, "Operands must be doubles, ints, or variables.");
-			}			
-
-			Numerical result = substituteVariable( *t, param2value, globalVariables, localVariables );
-			evalStack.push( new NumericalOperand(result) );
-		}
-	}
-
-	if ( evalStack.top() -> identify() != "Bool" ) throw SyntaxError( inputRPN[0], "Gate expression must evaluate to a bool." );
-
-	bool result;
-	BoolOperand *boolptr = dynamic_cast<BoolOperand *>(evalStack.top());
-	result = boolptr -> getValue();
-
-	delete evalStack.top();
-
-#if DEBUG_RPN
-	std::cout << "Bool is: " << result << std::endl;
-#endif
-	return result;
-}
-
-
-std::vector< std::pair< int, int > > unionBounds( std::pair<int, int> B1, std::pair<int, int> B2 ){
-
-	if ( B2.first <= B1.second and B1.second <= B2.second){
-
-		if ( B2.first <= B1.first and B1.first <= B2.second ) return {B2};
-		else return {std::make_pair(B1.first, B2.second)};
-	}
-	else if ( B1.first <= B2.second and B2.second <= B1.second){
-
-		if ( B1.first <= B2.first and B2.first <= B1.second ) return {B1};
-		else return {std::make_pair(B2.first, B1.second)};
-	}
-	else if ( B1.second + 1 == B2.first ) return {std::make_pair(B1.first, B2.second)};
-	else if ( B2.second + 1 == B1.first ) return {std::make_pair(B2.first, B1.second)};
-	else return {B1,B2};
-}
-
-
 std::vector< std::pair< int, int > > condenseToDisjoint( std::vector< std::pair<int, int> > S1 ){
+//sort the bounds by their lower bound and merge any that overlap or sit next to each other, so that the result is sorted and disjoint
 
 #if DEBUG_SETS
 std::cout << "Condensing to disjoint..." << std::endl;
@@ -849,42 +432,21 @@ std::cout << "Before condensing:" << std::endl;
 for ( auto p = S1.begin(); p < S1.end(); p++ ) std::cout << p -> first << " " << p -> second << std::endl;
 #endif
 
-	bool condensed;
-	std::vector< std::pair< int, int > > out;
-
-	if (S1.size() == 0) return out;
-
-	do{
-		condensed = false;
-		out.clear();
-		for (unsigned int i = 0; i < S1.size() - 1; i++){
-
-			for (unsigned int j = i+1; j < S1.size(); j++){
-
-				std::vector< std::pair< int, int > > u = unionBounds( S1[i], S1[j] );
+	std::sort( S1.begin(), S1.end() );
 
-				if (u.size() == 1){
-					
-					if ( std::find(out.begin(),out.end(),u[0]) == out.end() ) out.push_back(u[0]);
-					condensed = true;
-				}
-				else{
-
-					if ( std::find(out.begin(),out.end(),u[0]) == out.end() ) out.push_back(u[0]);
-					if ( std::find(out.begin(),out.end(),u[0]) == out.end() ) out.push_back(u[1]);
-				}
-			}
-		}
-		if (condensed) S1 = out;
+	std::vector< std::pair< int, int > > out;
+	for ( auto b = S1.begin(); b < S1.end(); b++ ){
 
-	} while(condensed);
+		if ( not out.empty() and (long) b -> first <= (long) out.back().second + 1 ) out.back().second = std::max( out.back().second, b -> second );
+		else out.push_back( *b );
+	}
 
 #if DEBUG_SETS
 std::cout << "After condensing:" << std::endl;
-for ( auto p = S1.begin(); p < S1.end(); p++ ) std::cout << p -> first << " " << p -> second << std::endl;
+for ( auto p = out.begin(); p < out.end(); p++ ) std::cout << p -> first << " " << p -> second << std::endl;
 #endif
 
-	return S1;
+	return out;
 }
 
 
@@ -940,29 +502,13 @@ std::cout << "B2:" << std::endl;
 std::cout << B2.first << " " << B2.second << std::endl;
 #endif
 
-	if ( B2.first == B1.second and B1.second == B2.second) return {};
-	else if ( B2.first <= B1.second and B1.second <= B2.second){
+	if ( B2.second < B1.first or B1.second < B2.first ) return {B1}; //no overlap
 
-		if ( B2.first <= B1.first and B1.first <= B2.second ) return {};
-		else return {std::make_pair(B1.first, B2.first-1)};
-	}
-	else if ( B1.first <= B2.second and B2.second <= B1.second){
-
-		if ( B1.first < B2.first and B2.first < B1.second ){ //fully contained
-
-			return {std::make_pair(B1.first, B2.first-1), std::make_pair(B2.second+1, B1.second)};
-		}
-		else if ( B1.first < B2.first and B2.first == B1.second ){ //right side aligns
-
-			return {std::make_pair(B1.first, B2.first-1)};
-		}
-		else if ( B1.first == B2.first and B2.first < B1.second ){ //left side aligns
-
-			return {std::make_pair(B2.second+1, B1.second)};
-		}
-		else return {std::make_pair(B2.second+1, B1.second)};
-	}
-	else return {B1};
+	//keep whatever part of B1 sticks out either side of B2
+	std::vector< std::pair< int, int > > out;
+	if ( B1.first < B2.first ) out.push_back( std::make_pair( B1.first, B2.first - 1 ) );
+	if ( B2.second < B1.second ) out.push_back( std::make_pair( B2.second + 1, B1.second ) );
+	return out;
 }
 
 
@@ -972,479 +518,424 @@ std::vector< std::pair<int, int> > setDifference( std::vector< std::pair<int, in
 std::cout << "Set difference..." << std::endl;
 #endif
 
-	std::vector< std::pair< int, int > > out;
-	
-	for ( unsigned int i = 0; i < S1.size(); i++ ){
+	//take each bound in S2 away from what's left of S1 in turn
+	for ( unsigned int j = 0; j < S2.size(); j++ ){
 
-		for ( unsigned int j = 0; j < S2.size(); j++ ){
+		std::vector< std::pair< int, int > > remaining;
+		for ( unsigned int i = 0; i < S1.size(); i++ ){
 
 			std::vector< std::pair< int, int > > difference = differenceBounds( S1[i], S2[j] );
-			out.insert(out.end(), difference.begin(), difference.end());
+			remaining.insert(remaining.end(), difference.begin(), difference.end());
 		}
+		S1 = remaining;
 	}
 
 	//merge bounds so that they're disjoint
-	return condenseToDisjoint(out);
+	return condenseToDisjoint(S1);
 }
 
 
-std::vector< std::pair<int, int> > evalRPN_set( std::vector< Token * > &inputRPN, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
 
-#if DEBUG_SETS
-std::cout << "Expression is: ";
-for (auto test = inputRPN.begin(); test < inputRPN.end(); test++) std::cout << (*test) -> value();
-std::cout << std::endl;
-//std::cout << "Parameters are:" << std::endl;
-//param2value.printValues();
-#endif
+/*BYTECODE EVALUATION------------------------------------------------------------------------------------------------------------------------------------------------*/
+//all four kinds of expression run on the same stack machine, and differ only in which operators they accept and what they must evaluate to
+enum EvaluationMode { EVAL_NUMERICAL, EVAL_CONDITION, EVAL_SET, EVAL_SETTEST };
 
-	std::stack<RPNoperand *> evalStack;
+enum StackValueType { VALUE_NUMERICAL, VALUE_BOOL, VALUE_SET };
 
-	for ( auto t = inputRPN.begin(); t < inputRPN.end(); t++ ){
+struct StackValue{
 
-		if ( isOperator(*t) or (*t) -> identify() == "Function"){
+	StackValueType type;
+	Numerical number;
+	bool truth;
+	unsigned int set; //index into the set scratch space
+};
 
-			if ( (*t) -> value() == "abs" or (*t) -> value() == "sqrt" or (*t) ->value() == "neg" ){ //unary
+//scratch space is kept per thread and reused between evaluations, so that evaluating an expression doesn't allocate once it has warmed up
+static thread_local std::vector< StackValue > vmStack;
+static thread_local std::vector< std::vector< std::pair< int, int > > > vmSets;
 
-				if ( evalStack.size() < 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand = evalStack.top();
-				evalStack.pop();
-				if (operand -> identify() != "Numerical") throw WrongType(*t,operand -> identify());
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand);
-				Numerical op_n = numptr -> getValue();
-				if (op_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
+static const std::string intsOnly = "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).";
 
-				Numerical result;
-				if ( (*t) -> value() == "abs" ){
 
-					if (op_n.isInt()) result.setInt(std::abs(op_n.getInt()));
-					else result.setDouble(std::abs(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "sqrt" ){
+static std::string valueIdentify( const StackValue &v ){
 
-					if (op_n.isInt()) result.setInt(sqrt(op_n.getInt()));
-					else result.setDouble(sqrt(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "neg" ){
+	if ( v.type == VALUE_NUMERICAL ) return "Numerical";
+	else if ( v.type == VALUE_BOOL ) return "Bool";
+	else return "Set";
+}
 
-					if (op_n.isInt()) result.setInt(-op_n.getInt());
-					else result.setDouble(-op_n.getDouble());
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for function evaluation.");
 
-				evalStack.push( new NumericalOperand(result) );
-				delete operand;
-			}
-			else if ( (*t) -> value() == "min" or (*t) -> value() == "max" or (*t) -> value() == "+" or (*t) -> value() == "-" or (*t) -> value() == "*" or (*t) -> value() == "/" or (*t) -> value() == "^"){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-				if (op1_n.isDouble() or op2_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-
-				//upcast
-				bool upcast = false;
-				if (op1_n.isDouble() or op2_n.isDouble()) upcast = true;
-
-				Numerical result;
-				if ( (*t) -> value() == "+" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() + op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() + op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "-" ){
+static Numerical lookupVariable( const Bytecode &bc, unsigned int pc, const ParameterValues &param2value, const GlobalVariables &globalVariables, const VariableFrame &localVariables ){
+//looks for valid substitutions from local variables within the system process, the system's global variables, and the process's parameter values, in that order
 
-					if (upcast) result.setDouble( op1_n.doubleCast() - op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() - op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "/" ){
+	unsigned int slot = bc.code()[pc].operand;
+	if ( localVariables.isDefined( slot ) ) return localVariables.getValue( slot );
+	if ( globalVariables.isDefined( slot ) ) return globalVariables.getValue( slot );
+	if ( param2value.isDefined( slot ) ) return param2value.getValue( slot );
 
-					if (upcast) result.setDouble( op1_n.doubleCast() / op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() / op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "*" ){
-					if (upcast) result.setDouble( op1_n.doubleCast() * op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() * op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "^" ){
+	throw UndefinedVariable( bc.instructionToken( pc ) );
+}
 
-					if (upcast) result.setDouble( pow(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( pow(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "min" ){
 
-					if (upcast) result.setDouble( std::min(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::min(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "max" ){
+static Numerical unaryArithmetic( OpCode op, Numerical &op_n ){
 
-					if (upcast) result.setDouble( std::max(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::max(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for arithmetic evaluation.");
+	Numerical result;
+	if ( op == OP_ABS ){
 
-				evalStack.push( new NumericalOperand(result) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == ".." ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-				if (op1_n.isDouble() or op2_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-
-				if (op1_n.getInt() > op2_n.getInt() ) throw SyntaxError(*t,"Thrown by expression evaluation (sets).  Range upper bound is greater than range lower bound.");
-
-				evalStack.push( new SetOperand({std::make_pair(op1_n.getInt(), op2_n.getInt())}) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == "U" or (*t) -> value() == "I" or (*t) -> value() == "\\" ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical" and operand1 -> identify() != "Set") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical" and operand2 -> identify() != "Set") throw WrongType(*t,operand2 -> identify());
-				std::vector<std::pair<int, int>> op1_s, op2_s;
-				
-				//get everything in set format
-				if (operand1 -> identify() == "Numerical"){
-
-					NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-					Numerical op1_n = numptr -> getValue();
-					if (op1_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-					op1_s = {std::make_pair(op1_n.getInt(), op1_n.getInt())};
-				}
-				else{
+		if (op_n.isInt()) result.setInt(std::abs(op_n.getInt()));
+		else result.setDouble(std::abs(op_n.getDouble()));
+	}
+	else if ( op == OP_SQRT ){
 
-					SetOperand *setptr = dynamic_cast<SetOperand *>(operand1);
-					op1_s = setptr -> getValue();
-				}
+		if (op_n.isInt()) result.setInt(sqrt(op_n.getInt()));
+		else result.setDouble(sqrt(op_n.getDouble()));
+	}
+	else{
 
-				if (operand2 -> identify() == "Numerical"){
+		if (op_n.isInt()) result.setInt(-op_n.getInt());
+		else result.setDouble(-op_n.getDouble());
+	}
+	return result;
+}
 
-					NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand2);
-					Numerical op2_n = numptr -> getValue();
-					if (op2_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-					op2_s = {std::make_pair(op2_n.getInt(), op2_n.getInt())};
-				}
-				else{
 
-					SetOperand *setptr = dynamic_cast<SetOperand *>(operand2);
-					op2_s = setptr -> getValue();
-				}
+static Numerical binaryArithmetic( OpCode op, Numerical &op1_n, Numerical &op2_n ){
+
+	//upcast
+	bool upcast = op1_n.isDouble() or op2_n.isDouble();
+
+	Numerical result;
+	switch ( op ){
+
+		case OP_ADD:
+			if (upcast) result.setDouble( op1_n.doubleCast() + op2_n.doubleCast() );
+			else result.setInt( op1_n.getInt() + op2_n.getInt() );
+			break;
+		case OP_SUB:
+			if (upcast) result.setDouble( op1_n.doubleCast() - op2_n.doubleCast() );
+			else result.setInt( op1_n.getInt() - op2_n.getInt() );
+			break;
+		case OP_MUL:
+			if (upcast) result.setDouble( op1_n.doubleCast() * op2_n.doubleCast() );
+			else result.setInt( op1_n.getInt() * op2_n.getInt() );
+			break;
+		case OP_DIV:
+			if (upcast) result.setDouble( op1_n.doubleCast() / op2_n.doubleCast() );
+			else result.setInt( op1_n.getInt() / op2_n.getInt() );
+			break;
+		case OP_POW:
+			if (upcast) result.setDouble( pow(op1_n.doubleCast(), op2_n.doubleCast()) );
+			else result.setInt( pow(op1_n.getInt(), op2_n.getInt()) );
+			break;
+		case OP_MIN:
+			if (upcast) result.setDouble( std::min(op1_n.doubleCast(), op2_n.doubleCast()) );
+			else result.setInt( std::min(op1_n.getInt(), op2_n.getInt()) );
+			break;
+		default:
+			assert( op == OP_MAX );
+			if (upcast) result.setDouble( std::max(op1_n.doubleCast(), op2_n.doubleCast()) );
+			else result.setInt( std::max(op1_n.getInt(), op2_n.getInt()) );
+	}
+	return result;
+}
 
-				std::vector<std::pair<int, int>> result;
-				if ( (*t) -> value() == "U" ){
-					op1_s.insert(op1_s.end(), op2_s.begin(), op2_s.end() );
-					result = condenseToDisjoint( op1_s );
-				}
-				else if ( (*t) -> value() == "I" ){
 
-					result = setIntersection( op1_s, op2_s );
-				}
-				else if ( (*t) -> value() == "\\" ){
+static bool comparison( OpCode op, Numerical &op1_n, Numerical &op2_n ){
 
-					result = setDifference( op1_s, op2_s );
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for set evaluation.");
+	double a = op1_n.doubleCast();
+	double b = op2_n.doubleCast();
+	switch ( op ){
 
-				evalStack.push( new SetOperand(result) );
-				delete operand1; delete operand2;
-			}
-		}
-		else if ( isOperand(*t) ){
+		case OP_EQ: return a == b;
+		case OP_NE: return a != b;
+		case OP_GT: return a > b;
+		case OP_LT: return a < b;
+		case OP_GE: return a >= b;
+		default:
+			assert( op == OP_LE );
+			return a <= b;
+	}
+}
 
-			//check types
-			if ((*t) -> identify() != "DoubleLiteral" and (*t) -> identify() != "IntLiteral" and (*t) -> identify() != "Variable"){
 
-				throw WrongType(*t, "Operands must be doubles, ints, or variables.");
-			}			
+static unsigned int newSet( unsigned int &setsUsed ){
 
-			Numerical result = substituteVariable( *t, param2value, globalVariables, localVariables );
-			evalStack.push( new NumericalOperand(result) );
-		}
-	}
+	if ( setsUsed == vmSets.size() ) vmSets.push_back( std::vector< std::pair< int, int > >() );
+	vmSets[setsUsed].clear();
+	return setsUsed++;
+}
 
-	if ( evalStack.top() -> identify() != "Set" and evalStack.top() -> identify() != "Numerical" ) throw SyntaxError( inputRPN[0], "Message receive expression must evaluate to a bool or an int" );
 
-	std::vector<std::pair<int, int>> result;
-	if ( evalStack.top() -> identify() == "Numerical" ){
+static void asSet( StackValue &v, Token *t, unsigned int &setsUsed ){
+//message receive sets treat a lone int as the singleton set that contains it
 
-		NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(evalStack.top());
-		Numerical op1_n = numptr -> getValue();
-		if (op1_n.isDouble()) throw WrongType(inputRPN[0], "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-		result = {std::make_pair(op1_n.getInt(), op1_n.getInt())};
-	}
-	else{
+	if ( v.type == VALUE_SET ) return;
+	if ( v.number.isDouble() ) throw WrongType(t, intsOnly);
+	int i = v.number.getInt();
+	v.type = VALUE_SET;
+	v.set = newSet( setsUsed );
+	vmSets[v.set].push_back( std::make_pair( i, i ) );
+}
 
-		SetOperand *setptr = dynamic_cast<SetOperand *>(evalStack.top());
-		result = setptr -> getValue();
-	}
-	delete evalStack.top();
 
-#if DEBUG_SETS
-std::cout << "Set is: " << std::endl;
-for ( auto itr = result.begin(); itr < result.end(); itr++ ){
+static bool asTest( StackValue &v, Token *t, int toTest ){
+//when testing membership, a lone int is true if it's the value being tested
 
-	std::cout << itr -> first << " " << itr -> second << std::endl;
-}
-#endif
-	return result;
+	if ( v.type == VALUE_BOOL ) return v.truth;
+	if ( v.number.isDouble() ) throw WrongType(t, intsOnly);
+	return v.number.getInt() == toTest;
 }
 
 
-bool evalRPN_setTest( int &toTest, std::vector< Token * > &inputRPN, ParameterValues &param2value, GlobalVariables &globalVariables, std::map< std::string, Numerical > &localVariables){
+static StackValue &runBytecode( const Bytecode &bc, EvaluationMode mode, int toTest, const ParameterValues &param2value, const GlobalVariables &globalVariables, const VariableFrame &localVariables ){
+//returns the value left on top of the stack, which stays valid until the next evaluation on this thread
 
-#if DEBUG_SETS
-std::cout << "Testing: " << toTest << std::endl;
-std::cout << "Expression is: ";
-for (auto test = inputRPN.begin(); test < inputRPN.end(); test++) std::cout << (*test) -> value();
-std::cout << std::endl;
-//std::cout << "Parameters are:" << std::endl;
-//param2value.printValues();
-#endif
+	const std::vector< Instruction > &code = bc.code();
+	if ( vmStack.size() < bc.maxDepth() ) vmStack.resize( bc.maxDepth() );
 
-	std::stack<RPNoperand *> evalStack;
+	bool intsOnlyMode = ( mode == EVAL_SET or mode == EVAL_SETTEST );
+	unsigned int top = 0;
+	unsigned int setsUsed = 0;
 
-	for ( auto t = inputRPN.begin(); t < inputRPN.end(); t++ ){
+	for ( unsigned int pc = 0; pc < code.size(); pc++ ){
 
-		if ( isOperator(*t) or (*t) -> identify() == "Function"){
+		OpCode op = code[pc].op;
+		switch ( op ){
 
-			if ( (*t) -> value() == "abs" or (*t) -> value() == "sqrt" or (*t) ->value() == "neg" ){ //unary
+			case OP_PUSH_CONSTANT:
+				vmStack[top].type = VALUE_NUMERICAL;
+				vmStack[top].number = bc.constant( code[pc].operand );
+				top++;
+				break;
 
-				if ( evalStack.size() < 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand = evalStack.top();
-				evalStack.pop();
-				if (operand -> identify() != "Numerical") throw WrongType(*t,operand -> identify());
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand);
-				Numerical op_n = numptr -> getValue();
-				if (op_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
+			case OP_LOAD_VARIABLE:
+				vmStack[top].type = VALUE_NUMERICAL;
+				vmStack[top].number = lookupVariable( bc, pc, param2value, globalVariables, localVariables );
+				top++;
+				break;
 
-				Numerical result;
-				if ( (*t) -> value() == "abs" ){
+			case OP_NEG: case OP_ABS: case OP_SQRT:{
 
-					if (op_n.isInt()) result.setInt(std::abs(op_n.getInt()));
-					else result.setDouble(std::abs(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "sqrt" ){
+				Token *t = bc.instructionToken( pc );
+				if ( top < 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand = vmStack[top-1];
+				if ( operand.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand));
+				if ( intsOnlyMode and operand.number.isDouble() ) throw WrongType(t, intsOnly);
+				operand.number = unaryArithmetic( op, operand.number );
+				break;
+			}
 
-					if (op_n.isInt()) result.setInt(sqrt(op_n.getInt()));
-					else result.setDouble(sqrt(op_n.getDouble()));
-				}
-				else if ( (*t) -> value() == "neg" ){
+			case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_POW: case OP_MIN: case OP_MAX:{
+
+				Token *t = bc.instructionToken( pc );
+				if ( top <= 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand1 = vmStack[top-2];
+				StackValue &operand2 = vmStack[top-1];
+				if ( operand1.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand1));
+				if ( operand2.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand2));
+				if ( intsOnlyMode and (operand1.number.isDouble() or operand2.number.isDouble()) ) throw WrongType(t, intsOnly);
+				operand1.number = binaryArithmetic( op, operand1.number, operand2.number );
+				top--;
+				break;
+			}
 
-					if (op_n.isInt()) result.setInt(-op_n.getInt());
-					else result.setDouble(-op_n.getDouble());
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for function evaluation.");
+			case OP_EQ: case OP_NE: case OP_GT: case OP_LT: case OP_GE: case OP_LE:{
+
+				if ( mode != EVAL_CONDITION ) break;
+				Token *t = bc.instructionToken( pc );
+				if ( top <= 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand1 = vmStack[top-2];
+				StackValue &operand2 = vmStack[top-1];
+				if ( operand1.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand1));
+				if ( operand2.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand2));
+				operand1.truth = comparison( op, operand1.number, operand2.number );
+				operand1.type = VALUE_BOOL;
+				top--;
+				break;
+			}
 
-				evalStack.push( new NumericalOperand(result) );
-				delete operand;
+			case OP_AND: case OP_OR:{
+
+				if ( mode != EVAL_CONDITION ) break;
+				Token *t = bc.instructionToken( pc );
+				if ( top <= 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand1 = vmStack[top-2];
+				StackValue &operand2 = vmStack[top-1];
+				if ( operand1.type != VALUE_BOOL ) throw WrongType(t, valueIdentify(operand1));
+				if ( operand2.type != VALUE_BOOL ) throw WrongType(t, valueIdentify(operand2));
+				if ( op == OP_AND ) operand1.truth = operand1.truth and operand2.truth;
+				else operand1.truth = operand1.truth or operand2.truth;
+				top--;
+				break;
 			}
-			else if ( (*t) -> value() == "min" or (*t) -> value() == "max" or (*t) -> value() == "+" or (*t) -> value() == "-" or (*t) -> value() == "*" or (*t) -> value() == "/" or (*t) -> value() == "^"){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-				if (op1_n.isDouble() or op2_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-
-				//upcast
-				bool upcast = false;
-				if (op1_n.isDouble() or op2_n.isDouble()) upcast = true;
-
-				Numerical result;
-				if ( (*t) -> value() == "+" ){
-
-					if (upcast) result.setDouble( op1_n.doubleCast() + op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() + op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "-" ){
 
-					if (upcast) result.setDouble( op1_n.doubleCast() - op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() - op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "/" ){
+			case OP_NOT:{
 
-					if (upcast) result.setDouble( op1_n.doubleCast() / op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() / op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "*" ){
-					if (upcast) result.setDouble( op1_n.doubleCast() * op2_n.doubleCast() );
-					else result.setInt( op1_n.getInt() * op2_n.getInt() );
-				}
-				else if ( (*t) -> value() == "^" ){
+				if ( mode != EVAL_CONDITION ) break;
+				Token *t = bc.instructionToken( pc );
+				if ( top < 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand = vmStack[top-1];
+				if ( operand.type != VALUE_BOOL ) throw WrongType(t, valueIdentify(operand));
+				operand.truth = not operand.truth;
+				break;
+			}
 
-					if (upcast) result.setDouble( pow(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( pow(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "min" ){
+			case OP_RANGE:{
 
-					if (upcast) result.setDouble( std::min(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::min(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else if ( (*t) -> value() == "max" ){
+				if ( not intsOnlyMode ) break;
+				Token *t = bc.instructionToken( pc );
+				if ( top <= 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand1 = vmStack[top-2];
+				StackValue &operand2 = vmStack[top-1];
+				if ( operand1.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand1));
+				if ( operand2.type != VALUE_NUMERICAL ) throw WrongType(t, valueIdentify(operand2));
+				if ( operand1.number.isDouble() or operand2.number.isDouble() ) throw WrongType(t, intsOnly);
 
-					if (upcast) result.setDouble( std::max(op1_n.doubleCast(), op2_n.doubleCast()) );
-					else result.setInt( std::max(op1_n.getInt(), op2_n.getInt()) );
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for arithmetic evaluation.");
+				int lower = operand1.number.getInt();
+				int upper = operand2.number.getInt();
+				if ( lower > upper ) throw SyntaxError(t,"Thrown by expression evaluation (sets).  Range upper bound is greater than range lower bound.");
 
-				evalStack.push( new NumericalOperand(result) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == ".." ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-				if (op1_n.isDouble() or op2_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-
-				bool result;
-				if (op1_n.getInt() > op2_n.getInt() ) throw SyntaxError(*t,"Thrown by expression evaluation (sets).  Range upper bound is greater than range lower bound.");
-				if (op1_n.getInt() <= toTest and toTest <= op2_n.getInt()) result = true;
-				else result = false;
-
-				evalStack.push( new BoolOperand(result) );
-				delete operand1; delete operand2;
-			}
-			else if ( (*t) -> value() == "U" or (*t) -> value() == "I" or (*t) -> value() == "\\" ){
-
-				//get the operands and make sure they're of correct type for the operator
-				if ( evalStack.size() <= 1 ) throw SyntaxError(*t, "Insufficient arguments.");
-				RPNoperand *operand2 = evalStack.top();
-				evalStack.pop();
-				RPNoperand *operand1 = evalStack.top();
-				evalStack.pop();
-				if (operand1 -> identify() != "Numerical" and operand1 -> identify() != "Bool") throw WrongType(*t,operand1 -> identify());
-				if (operand2 -> identify() != "Numerical" and operand2 -> identify() != "Bool") throw WrongType(*t,operand2 -> identify());
-				Numerical op1_n,op2_n;
-				NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-				op1_n = numptr -> getValue();
-				numptr = dynamic_cast<NumericalOperand *>(operand2);
-				op2_n = numptr -> getValue();
-				
-				//get everything in bool format
-				bool op1_s;
-				if (operand1 -> identify() == "Numerical"){
-
-					NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand1);
-					Numerical op1_n = numptr -> getValue();
-					if (op1_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-					op1_s = op1_n.getInt() == toTest;
+				if ( mode == EVAL_SET ){
+
+					operand1.type = VALUE_SET;
+					operand1.set = newSet( setsUsed );
+					vmSets[operand1.set].push_back( std::make_pair( lower, upper ) );
 				}
 				else{
 
-					BoolOperand *boolptr = dynamic_cast<BoolOperand *>(operand1);
-					op1_s = boolptr -> getValue();
+					operand1.type = VALUE_BOOL;
+					operand1.truth = ( lower <= toTest and toTest <= upper );
 				}
+				top--;
+				break;
+			}
+
+			case OP_UNION: case OP_INTERSECT: case OP_DIFFERENCE:{
+
+				if ( not intsOnlyMode ) break;
+				Token *t = bc.instructionToken( pc );
+				if ( top <= 1 ) throw SyntaxError(t, "Insufficient arguments.");
+				StackValue &operand1 = vmStack[top-2];
+				StackValue &operand2 = vmStack[top-1];
+
+				if ( mode == EVAL_SET ){
 
-				bool op2_s;
-				if (operand2 -> identify() == "Numerical"){
+					if ( operand1.type == VALUE_BOOL ) throw WrongType(t, valueIdentify(operand1));
+					if ( operand2.type == VALUE_BOOL ) throw WrongType(t, valueIdentify(operand2));
+					asSet( operand1, t, setsUsed );
+					asSet( operand2, t, setsUsed );
 
-					NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(operand2);
-					Numerical op2_n = numptr -> getValue();
-					if (op2_n.isDouble()) throw WrongType(*t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-					op2_s = op2_n.getInt() == toTest;
+					std::vector< std::pair< int, int > > &op1_s = vmSets[operand1.set];
+					std::vector< std::pair< int, int > > &op2_s = vmSets[operand2.set];
+					if ( op == OP_UNION ){
+
+						op1_s.insert( op1_s.end(), op2_s.begin(), op2_s.end() );
+						op1_s = condenseToDisjoint( op1_s );
+					}
+					else if ( op == OP_INTERSECT ) op1_s = setIntersection( op1_s, op2_s );
+					else op1_s = setDifference( op1_s, op2_s );
 				}
 				else{
 
-					BoolOperand *boolptr = dynamic_cast<BoolOperand *>(operand2);
-					op2_s = boolptr -> getValue();
-				}
+					if ( operand1.type == VALUE_SET ) throw WrongType(t, valueIdentify(operand1));
+					if ( operand2.type == VALUE_SET ) throw WrongType(t, valueIdentify(operand2));
+					bool op1_b = asTest( operand1, t, toTest );
+					bool op2_b = asTest( operand2, t, toTest );
 
-				bool result;
-				if ( (*t) -> value() == "U" ){
-					result = op1_s or op2_s;
-				}
-				else if ( (*t) -> value() == "I" ){
-					result = op1_s and op2_s;
+					operand1.type = VALUE_BOOL;
+					if ( op == OP_UNION ) operand1.truth = op1_b or op2_b;
+					else if ( op == OP_INTERSECT ) operand1.truth = op1_b and op2_b;
+					else operand1.truth = op1_b and not op2_b;
 				}
-				else if ( (*t) -> value() == "\\" ){
-					result = op1_s and not op2_s;
-				}
-				else throw SyntaxError(*t, "Unrecognised operator for set evaluation.");
-
-				evalStack.push( new BoolOperand(result) );
-				delete operand1; delete operand2;
+				top--;
+				break;
 			}
 		}
-		else if ( isOperand(*t) ){
+	}
 
-			//check types
-			if ((*t) -> identify() != "DoubleLiteral" and (*t) -> identify() != "IntLiteral" and (*t) -> identify() != "Variable"){
+	assert( top > 0 );
+	return vmStack[top-1];
+}
 
-				throw WrongType(*t, "Operands must be doubles, ints, or variables.");
-			}			
 
-			Numerical result = substituteVariable( *t, param2value, globalVariables, localVariables );
-			evalStack.push( new NumericalOperand(result) );
-		}
-	}
+Numerical evalRPN_numerical( const Bytecode &bc, const ParameterValues &param2value, const GlobalVariables &globalVariables, const VariableFrame &localVariables){
 
-	if ( evalStack.top() -> identify() != "Bool" and evalStack.top() -> identify() != "Numerical" ) throw SyntaxError( inputRPN[0], "Message receive expression must evaluate to a bool or an int" );
+	StackValue &top = runBytecode( bc, EVAL_NUMERICAL, 0, param2value, globalVariables, localVariables );
+	if ( top.type != VALUE_NUMERICAL ) throw SyntaxError( bc.rpn()[0], "Expression must evaluate to a numerical value." );
 
-	bool result;
-	if ( evalStack.top() -> identify() == "Numerical" ){
+#if DEBUG_RPN
+	if (top.number.isInt()) std::cout << "Int is: " << top.number.getInt() << std::endl;
+	else std::cout << "Double is: " << top.number.getDouble() << std::endl;
+#endif
+
+	return top.number;
+}
 
-		NumericalOperand *numptr = dynamic_cast<NumericalOperand *>(evalStack.top());
-		Numerical op1_n = numptr -> getValue();
-		if (op1_n.isDouble()) throw WrongType(inputRPN[0], "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
-		result = op1_n.doubleCast() == toTest;
+
+bool evalRPN_condition( const Bytecode &bc, const ParameterValues &param2value, const GlobalVariables &globalVariables, const VariableFrame &localVariables){
+
+	StackValue &top = runBytecode( bc, EVAL_CONDITION, 0, param2value, globalVariables, localVariables );
+	if ( top.type != VALUE_BOOL ) throw SyntaxError( bc.rpn()[0], "Gate expression must evaluate to a bool." );
+
+#if DEBUG_RPN
+	std::cout << "Bool is: " << top.truth << std::endl;
+#endif
+	return top.truth;
+}
+
+
+std::vector< std::pair<int, int> > evalRPN_set( const Bytecode &bc, const ParameterValues &param2value, const GlobalVariables &globalVariables, const VariableFrame &localVariables){
+
+#if DEBUG_SETS
+std::cout << "Expression is: ";
+for (auto test = bc.rpn().begin(); test < bc.rpn().end(); test++) std::cout << (*test) -> value();
+std::cout << std::endl;
+#endif
+
+	StackValue &top = runBytecode( bc, EVAL_SET, 0, param2value, globalVariables, localVariables );
+	if ( top.type != VALUE_SET and top.type != VALUE_NUMERICAL ) throw SyntaxError( bc.rpn()[0], "Message receive expression must evaluate to a bool or an int" );
+
+	std::vector<std::pair<int, int>> result;
+	if ( top.type == VALUE_NUMERICAL ){
+
+		if (top.number.isDouble()) throw WrongType(bc.rpn()[0], intsOnly);
+		result = {std::make_pair(top.number.getInt(), top.number.getInt())};
 	}
-	else{
+	else result = vmSets[top.set];
+
+#if DEBUG_SETS
+std::cout << "Set is: " << std::endl;
+for ( auto itr = result.begin(); itr < result.end(); itr++ ){
+
+	std::cout << itr -> first << " " << itr -> second << std::endl;
+}
+#endif
+	return result;
+}
+
+
+bool evalRPN_setTest( int &toTest, const Bytecode &bc, const ParameterValues &param2value, const GlobalVariables &globalVariables, const VariableFrame &localVariables){
 
-		BoolOperand *boolptr = dynamic_cast<BoolOperand *>(evalStack.top());
-		result = boolptr -> getValue();
+#if DEBUG_SETS
+std::cout << "Testing: " << toTest << std::endl;
+std::cout << "Expression is: ";
+for (auto test = bc.rpn().begin(); test < bc.rpn().end(); test++) std::cout << (*test) -> value();
+std::cout << std::endl;
+#endif
+
+	StackValue &top = runBytecode( bc, EVAL_SETTEST, toTest, param2value, globalVariables, localVariables );
+	if ( top.type != VALUE_BOOL and top.type != VALUE_NUMERICAL ) throw SyntaxError( bc.rpn()[0], "Message receive expression must evaluate to a bool or an int" );
+
+	bool result;
+	if ( top.type == VALUE_NUMERICAL ){
+
+		if (top.number.isDouble()) throw WrongType(bc.rpn()[0], intsOnly);
+		result = top.number.doubleCast() == toTest;
 	}
-	delete evalStack.top();
+	else result = top.truth;
 
 #if DEBUG_SETS
 	std::cout << "Bool is: " << result << std::endl;
 #endif
 	return result;
 }
-
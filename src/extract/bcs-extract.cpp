@@ -0,0 +1,206 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include "../trajectory_index.h"
+#include "../binary.h"
+#include "../error_handling.h"
+#include "../common.h"
+
+
+static const char *help=
+"bcs-extract copies simulations out of a bcs output file using the sidecar index written by bcs --index.\n"
+"To run bcs-extract, do:\n"
+"  ./bcs-extract [arguments] simulationOutput.simulation.bcs\n"
+"Optional arguments are:\n"
+"  -i,--index                index file (default: the output file name with .idx appended),\n"
+"  -s,--simulations          which simulations to extract, by their position in the file from 0, e.g. 0,4,10-19 (default: all),\n"
+"  --from                    only keep transitions at or after this time,\n"
+"  --to                      only keep transitions at or before this time,\n"
+"  -l,--list                 list the simulations in the index instead of extracting them,\n"
+"  -o,--output               output file name prefix (default: write to stdout),\n"
+"  -h,--help                 show useage information,\n"
+"  -v,--version              show version.\n";
+
+
+struct Arguments {
+
+	std::string targetFilename, indexFilename, outputPrefix, simulations;
+	double from = -std::numeric_limits< double >::infinity();
+	double to = std::numeric_limits< double >::infinity();
+	bool window = false, list = false;
+};
+
+
+void showHelp(){
+
+	std::cout << help;
+	std::cout << "Version: " << VERSION << std::endl;
+}
+
+
+void exitWithError( const std::string &message ){
+
+	std::cerr << "Exiting with error.  " << message << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+
+Arguments parseArguments( int argc, char** argv ){
+
+	if( argc < 2 ){
+
+		std::cout << "Exiting with error.  No output file specified." << std::endl;
+		showHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	Arguments args;
+	for ( int i = 1; i < argc; ){
+
+		std::string flag( argv[ i ] );
+		bool hasValue = i + 1 < argc;
+
+		if ( ( flag == "-i" or flag == "--index" ) and hasValue ){
+
+			args.indexFilename = argv[ i + 1 ];
+			i+=2;
+		}
+		else if ( ( flag == "-s" or flag == "--simulations" ) and hasValue ){
+
+			args.simulations = argv[ i + 1 ];
+			i+=2;
+		}
+		else if ( flag == "--from" and hasValue ){
+
+			args.from = atof( argv[ i + 1 ] );
+			args.window = true;
+			i+=2;
+		}
+		else if ( flag == "--to" and hasValue ){
+
+			args.to = atof( argv[ i + 1 ] );
+			args.window = true;
+			i+=2;
+		}
+		else if ( flag == "-l" or flag == "--list" ){
+
+			args.list = true;
+			i+=1;
+		}
+		else if ( ( flag == "-o" or flag == "--output" ) and hasValue ){
+
+			args.outputPrefix = argv[ i + 1 ];
+			i+=2;
+		}
+		else if ( flag == "-h" or flag == "--help" ){
+
+			showHelp();
+			exit(EXIT_SUCCESS);
+		}
+		else if ( flag == "-v" or flag == "--version" ){
+
+			std::cout << "Version: " << VERSION << std::endl;
+			exit(EXIT_SUCCESS);
+		}
+		else{
+
+			if ( flag.substr(0,1) == "-" ){
+
+				std::cout << "Exiting with error.  Unknown flag specified." << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+
+			args.targetFilename = flag;
+			i+=1;
+		}
+	}
+
+	if ( args.indexFilename.empty() ) args.indexFilename = args.targetFilename + ".idx";
+	return args;
+}
+
+
+std::vector< uint64_t > parseSimulations( const std::string &list, uint64_t numberOfSimulations ){
+//turn a list like 0,4,10-19 into the positions it names
+
+	std::vector< uint64_t > out;
+	if ( list.empty() ){
+
+		for ( uint64_t k = 0; k < numberOfSimulations; k++ ) out.push_back( k );
+		return out;
+	}
+
+	size_t start = 0;
+	while ( start <= list.size() ){
+
+		size_t end = list.find( ',', start );
+		if ( end == std::string::npos ) end = list.size();
+		std::string range = list.substr( start, end - start );
+
+		size_t dash = range.find( '-' );
+		char *rest;
+		uint64_t first = strtoull( range.c_str(), &rest, 10 );
+		uint64_t last = first;
+		if ( dash != std::string::npos ) last = strtoull( range.c_str() + dash + 1, &rest, 10 );
+		if ( range.empty() or *rest != '\0' or last < first ) exitWithError( "Could not read the list of simulations: " + list );
+		if ( last >= numberOfSimulations ) exitWithError( "The index only has " + std::to_string( numberOfSimulations ) + " simulations." );
+
+		for ( uint64_t k = first; k <= last; k++ ) out.push_back( k );
+		start = end + 1;
+	}
+	return out;
+}
+
+
+int main( int argc, char** argv ){
+
+	Arguments args = parseArguments( argc, argv );
+
+	try{
+
+		MappedTrajectory trajectory( args.targetFilename, args.indexFilename );
+
+		if ( args.list ){
+
+			std::cout << "position\tsimulation\toffset\tbytes\ttransitions\tfinalTime" << std::endl;
+			for ( uint64_t k = 0; k < trajectory.size(); k++ ){
+
+				IndexEntry e = trajectory.entry( k );
+				std::cout << k << '\t' << e.simulation << '\t' << e.offset << '\t' << e.length << '\t' << e.transitions << '\t' << e.finalTime << std::endl;
+			}
+			return 0;
+		}
+
+		std::vector< uint64_t > simulations = parseSimulations( args.simulations, trajectory.size() );
+
+		std::ofstream outFile;
+		if ( not args.outputPrefix.empty() ){
+
+			outFile.open( args.outputPrefix + ( trajectory.isBinary() ? ".simulation.bcsb" : ".simulation.bcs" ), std::ios::binary );
+			if ( not outFile.is_open() ) exitWithError( BadOutputPath().what() );
+		}
+		std::ostream &out = args.outputPrefix.empty() ? std::cout : outFile;
+
+		trajectory.writeHeader( out );
+		for ( auto k = simulations.begin(); k < simulations.end(); k++ ){
+
+			if ( args.window ) trajectory.writeWindow( *k, args.from, args.to, out );
+			else trajectory.writeSimulation( *k, out );
+		}
+	}
+	catch ( std::exception &e ){
+
+		exitWithError( e.what() );
+	}
+	return 0;
+}
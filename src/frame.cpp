@@ -0,0 +1,78 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <map>
+#include <iostream>
+#include "frame.h"
+
+
+static std::map< std::string, unsigned int > slotsByName;
+static std::vector< std::string > namesBySlot;
+
+
+unsigned int VariableFrame::slot( const std::string &name ){
+
+	auto s = slotsByName.find( name );
+	if ( s != slotsByName.end() ) return s -> second;
+
+	unsigned int newSlot = namesBySlot.size();
+	slotsByName[name] = newSlot;
+	namesBySlot.push_back( name );
+	return newSlot;
+}
+
+
+int VariableFrame::findSlot( const std::string &name ){
+
+	auto s = slotsByName.find( name );
+	if ( s == slotsByName.end() ) return -1;
+	return s -> second;
+}
+
+
+const std::string &VariableFrame::slotName( unsigned int s ){
+
+	assert( s < namesBySlot.size() );
+	return namesBySlot[s];
+}
+
+
+bool VariableFrame::isDefined( const std::string &name ) const {
+
+	int s = findSlot( name );
+	return s != -1 and isDefined( (unsigned int) s );
+}
+
+
+void VariableFrame::updateValue( const std::string &name, const Numerical &value ){
+
+	updateValue( slot( name ), value );
+}
+
+
+std::vector< std::string > VariableFrame::getNames( void ) const {
+
+	std::vector< std::string > variableNames;
+	for ( unsigned int s = 0; s < _values.size(); s++ ){
+
+		if ( isDefined( s ) ) variableNames.push_back( slotName( s ) );
+	}
+	return variableNames;
+}
+
+
+void VariableFrame::printValues( void ) const {
+
+	for ( unsigned int s = 0; s < _values.size(); s++ ){
+
+		if ( not isDefined( s ) ) continue;
+		Numerical value = _values[s];
+		if ( value.isDouble() ) std::cout << slotName( s ) << " " << value.getDouble() << " Double" << std::endl;
+		else std::cout << slotName( s ) << " " << value.getInt() << " Int" << std::endl;
+	}
+}
@@ -0,0 +1,49 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <vector>
+#include <string>
+#include <cassert>
+#include "numerical.h"
+
+
+class VariableFrame{
+//variable values indexed by slot, where every variable name in the model is given a slot the first time the parser sees it
+//so that lookups during simulation are array indexing and copying a frame is a flat copy
+
+	private:
+		std::vector< Numerical > _values;
+
+	public:
+		//slots are only handed out while parsing; during simulation they're read-only and safe to share between threads
+		static unsigned int slot( const std::string & );
+		static int findSlot( const std::string & );
+		static const std::string &slotName( unsigned int );
+
+		unsigned int size( void ) const { return _values.size(); }
+		bool isDefined( unsigned int s ) const { return s < _values.size() and _values[s].isSet(); }
+		const Numerical &getValue( unsigned int s ) const {
+
+			assert( isDefined( s ) );
+			return _values[s];
+		}
+		void updateValue( unsigned int s, const Numerical &value ){
+
+			if ( s >= _values.size() ) _values.resize( s + 1 );
+			_values[s] = value;
+		}
+		bool isDefined( const std::string & ) const;
+		void updateValue( const std::string &, const Numerical & );
+		std::vector< std::string > getNames( void ) const;
+		void printValues( void ) const;
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include <iomanip>
 #include <sstream>
 #include <iterator>
+#include <algorithm>
 #include "handshake.h"
 #include "error_handling.h"
 
@@ -23,13 +24,11 @@ HandshakeChannel::HandshakeChannel( std::vector< std::string > name, GlobalVaria
 	_globalVars = globalVars;
 }
 
-std::vector< std::string > HandshakeChannel::getChannelName(void){ return _channelName;}
 
+std::shared_ptr<HandshakeCandidate> HandshakeChannel::buildHandshakeCandidate( std::shared_ptr<Candidate> sendCand, std::shared_ptr<Candidate> receiveCand, std::vector<int> sEval, TransitionScheduler &scheduler ){
 
-std::shared_ptr<HandshakeCandidate> HandshakeChannel::buildHandshakeCandidate( std::shared_ptr<Candidate> sendCand, std::shared_ptr<Candidate> receiveCand, std::vector<int> sEval ){
-
-	assert( (receiveCand -> actionCandidate) -> identify() == "MessageReceive");
-	assert( (sendCand -> actionCandidate) -> identify() == "MessageSend");
+	assert( (receiveCand -> actionCandidate) -> kind() == BLOCK_MESSAGE_RECEIVE);
+	assert( (sendCand -> actionCandidate) -> kind() == BLOCK_MESSAGE_SEND);
 
 #if DEBUG_HANDSHAKE
 std::cout << "built handshake candidate on channel: ";
@@ -39,204 +38,211 @@ std::cout << "sending sp: " << sendCand -> processInSystem << std::endl;
 std::cout << "receiving sp: " << receiveCand -> processInSystem << std::endl;
 #endif
 
-	std::map< std::string, Numerical > augmentedLocalVars = receiveCand -> localVariables;
+	VariableFrame augmentedLocalVars = receiveCand -> localVariables;
 
 	//if we have a binding variable, we're allowed to use it in the rate calculation for the handshake receive candidate
-	MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >(receiveCand -> actionCandidate);
+	MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >(receiveCand -> actionCandidate);
 	if ( mrb -> bindsVariable() ){
 
-		std::vector< std::string > bindingVarNames = mrb -> getBindingVariable();
-		for ( unsigned int i = 0; i < bindingVarNames.size(); i++ ){
+		const std::vector< unsigned int > &bindingSlots = mrb -> getBindingSlots();
+		for ( unsigned int i = 0; i < bindingSlots.size(); i++ ){
 
 			Numerical n;
 			n.setInt(sEval[i]);
-			augmentedLocalVars[ bindingVarNames[i] ] = n;
+			augmentedLocalVars.updateValue( bindingSlots[i], n );
 		}
 	}
 
 	Numerical receiveRate = evalRPN_numerical( mrb -> getRate(), receiveCand -> parameterValues, _globalVars, augmentedLocalVars );
 	if ( receiveRate.doubleCast() <= 0 ) throw BadRate( mrb -> getToken() );
 
-	double rate = (sendCand -> rate) * receiveRate.doubleCast();
+	//with --lump, a send can pair with any copy of the receiving process, but not with the copy that's sending
+	unsigned int receivers = ( receiveCand -> processInSystem ) -> count;
+	if ( sendCand -> processInSystem == receiveCand -> processInSystem ) receivers--;
+	double rate = (sendCand -> rate) * receiveRate.doubleCast() * receivers;
 	std::shared_ptr<HandshakeCandidate> hsCand( new HandshakeCandidate( sendCand, receiveCand, rate, sEval, _channelName ) );
 
 	//associate both the sending and receiving system processes with this handshake candidate, and vice versa
-	_possibleHandshakes_sp2Candidates[ sendCand -> processInSystem ].push_back( hsCand );
-	_possibleHandshakes_sp2Candidates[ receiveCand -> processInSystem ].push_back( hsCand );
-	_possibleHandshakes_candidates2Sp[ hsCand ].push_back( sendCand -> processInSystem );
-	_possibleHandshakes_candidates2Sp[ hsCand ].push_back( receiveCand -> processInSystem );
+	std::list< std::shared_ptr<HandshakeCandidate> > &sendHandshakes = _possibleHandshakes_sp2Candidates[ sendCand -> processInSystem ];
+	hsCand -> sendPosition = sendHandshakes.insert( sendHandshakes.end(), hsCand );
+	if ( sendCand -> processInSystem == receiveCand -> processInSystem ) hsCand -> receivePosition = hsCand -> sendPosition;
+	else{
+
+		std::list< std::shared_ptr<HandshakeCandidate> > &receiveHandshakes = _possibleHandshakes_sp2Candidates[ receiveCand -> processInSystem ];
+		hsCand -> receivePosition = receiveHandshakes.insert( receiveHandshakes.end(), hsCand );
+	}
 
-	assert(sendCand -> processInSystem != receiveCand -> processInSystem);
+	assert( sendCand -> processInSystem != receiveCand -> processInSystem or ( sendCand -> processInSystem ) -> count > 1 );
 
+	scheduler.add( hsCand );
 	return hsCand;
 }
 
 
-std::pair<int, double> HandshakeChannel::updateHandshakeCandidates(void){
+template< typename T >
+static bool sweepOrder( const T *a, const T *b ){
+//the order a sweep over every process's sends or receives, and then over each process's in the order they were added, visits them in
 
-	int candidatesAdded = 0;
-	double rateSum = 0.0;
+	SystemProcess *spA = (a -> candidate) -> processInSystem;
+	SystemProcess *spB = (b -> candidate) -> processInSystem;
+	if ( spA != spB ) return SystemProcessOrder()( spA, spB );
+	return a -> order < b -> order;
+}
 
-	//match added send to receives that are already there
-	for ( auto addedSend = _sendToAdd.begin(); addedSend != _sendToAdd.end(); addedSend++ ){
 
-		std::vector<Numerical> sEval_n = (*addedSend) -> rangeEvaluation;
-		std::vector<int> sEval;
-		
-		//check types
-		for ( auto s = sEval_n.begin(); s < sEval_n.end(); s++) sEval.push_back( (*s).getInt() );
+bool HandshakeChannel::testEachValue( const std::vector< int > &sEval, HandshakeReceive &receive ){
+//check each value against its set expression, for receives whose sets couldn't be evaluated up front
 
-		for ( auto receive = _hsReceive_Sp2Candidates.begin(); receive != _hsReceive_Sp2Candidates.end(); receive++ ){
+	const std::vector< Bytecode > &setExpressions = static_cast< MessageReceiveBlock * >( receive.candidate -> actionCandidate ) -> getSetExpression();
+	for ( unsigned int i = 0; i < sEval.size(); i++ ){
 
-			//can't have a handshake between the same sp
-			if (receive -> first == (*addedSend) -> processInSystem) continue;
+		int toTest = sEval[i];
+		if ( not evalRPN_setTest( toTest, setExpressions[i], receive.candidate -> parameterValues, _globalVars, receive.candidate -> localVariables ) ) return false;
+	}
+	return true;
+}
 
-			for ( auto r_cand = (receive -> second).begin(); r_cand != (receive -> second).end(); r_cand++ ){
 
-				MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >((*r_cand) -> actionCandidate);
-				std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
+std::vector< HandshakeReceive * > HandshakeChannel::receivesFor( const std::vector< int > &sEval ){
+//receives on the channel that might take these values: those whose sets contain them, and those we have to test one by one
 
-				//check each value against its set expression
-				bool allPassed = true;
-				for ( unsigned int i = 0; i < sEval.size(); i++ ){
+	std::vector< HandshakeReceive * > out;
 
-					bool setEval = evalRPN_setTest( sEval[i], setExpressions[i], (*r_cand) -> parameterValues, _globalVars, (*r_cand) -> localVariables );
-					if (not setEval){
-						allPassed = false;
-						break;
-					}
-				}
-				if (allPassed){
+	auto index = _receiveIndex.find( sEval.size() );
+	if ( index != _receiveIndex.end() ) out = (index -> second).stab( sEval );
 
-					std::shared_ptr<HandshakeCandidate> newHS = buildHandshakeCandidate( *addedSend, *r_cand, sEval );
-					candidatesAdded++;
-					rateSum += newHS -> rate;
-				}
-			}
-		}
+	auto unevaluated = _unevaluatedReceives.find( sEval.size() );
+	if ( unevaluated != _unevaluatedReceives.end() ) out.insert( out.end(), (unevaluated -> second).begin(), (unevaluated -> second).end() );
+
+	std::sort( out.begin(), out.end(), sweepOrder< HandshakeReceive > );
+	return out;
+}
+
+
+std::vector< HandshakeSend * > HandshakeChannel::sendsFor( HandshakeReceive &receive ){
+//sends on the channel that this receive might take: those in range of its sets, or all of them if we have to test them one by one
+
+	std::vector< HandshakeSend * > out;
+
+	auto index = _sendIndex.find( receive.arity() );
+	if ( index == _sendIndex.end() ) return out;
+	std::multimap< std::vector< int >, HandshakeSend * > &sends = index -> second;
+
+	if ( not receive.evaluated or receive.bounds.empty() ){
+
+		for ( auto s = sends.begin(); s != sends.end(); s++ ) out.push_back( s -> second );
 	}
+	else{
 
-	//match added receives to sends that are already there
-	for ( auto addedReceive = _receiveToAdd.begin(); addedReceive != _receiveToAdd.end(); addedReceive++ ){
+		std::vector< int > prefix;
+		std::vector< std::multimap< std::vector< int >, HandshakeSend * >::const_iterator > inRange;
+		searchRange( sends, receive.bounds, prefix, 0, &inRange );
+		for ( auto s = inRange.begin(); s < inRange.end(); s++ ) out.push_back( (*s) -> second );
+	}
 
-		MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >((*addedReceive) -> actionCandidate);
-		std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
+	std::sort( out.begin(), out.end(), sweepOrder< HandshakeSend > );
+	return out;
+}
 
-		for ( auto send = _hsSend_Sp2Candidates.begin(); send != _hsSend_Sp2Candidates.end(); send++ ){
 
-			//can't have a handshake between the same sp
-			if (send -> first == (*addedReceive) -> processInSystem) continue;
+void HandshakeChannel::updateHandshakeCandidates( TransitionScheduler &scheduler ){
+//pair new sends and receives with each other and with those already on the channel, in the same order as a sweep over all of them
 
-			for ( auto s_cand = (send -> second).begin(); s_cand != (send -> second).end(); s_cand++ ){
+	//match added send to receives that are already there
+	for ( auto addedSend = _sendToAdd.begin(); addedSend != _sendToAdd.end(); addedSend++ ){
 
-				std::vector<Numerical> sEval_n = (*s_cand) -> rangeEvaluation;
-				std::vector<int> sEval;
-		
-				//check types
-				for ( auto s = sEval_n.begin(); s < sEval_n.end(); s++) sEval.push_back( (*s).getInt() );
-								
+		std::vector< HandshakeReceive * > receives = receivesFor( (*addedSend) -> values );
+		for ( auto r = receives.begin(); r < receives.end(); r++ ){
 
-				//check each value against its set expression
-				bool allPassed = true;
-				for ( unsigned int i = 0; i < sEval.size(); i++ ){
+			//can't have a handshake between the same sp, unless it stands for more than one copy of a process (--lump)
+			if ( (*r) -> candidate -> processInSystem == (*addedSend) -> candidate -> processInSystem and (*r) -> candidate -> processInSystem -> count < 2 ) continue;
 
-					bool setEval = evalRPN_setTest( sEval[i], setExpressions[i], (*addedReceive) -> parameterValues, _globalVars, (*addedReceive) -> localVariables );
-					if (not setEval){
-						allPassed = false;
-						break;
-					}
-				}
-				if (allPassed){
+			if ( (*r) -> evaluated or testEachValue( (*addedSend) -> values, **r ) ){
 
-					std::shared_ptr<HandshakeCandidate> newHS = buildHandshakeCandidate( *s_cand, *addedReceive, sEval );
-					candidatesAdded++;
-					rateSum += newHS -> rate;
-				}
+				buildHandshakeCandidate( (*addedSend) -> candidate, (*r) -> candidate, (*addedSend) -> values, scheduler );
 			}
 		}
 	}
 
-	//match added sends to added receives
-	for ( auto addedSend = _sendToAdd.begin(); addedSend != _sendToAdd.end(); addedSend++ ){
+	//match added receives to sends that are already there
+	for ( auto addedReceive = _receiveToAdd.begin(); addedReceive != _receiveToAdd.end(); addedReceive++ ){
 
-		std::vector<Numerical> sEval_n = (*addedSend) -> rangeEvaluation;
-		std::vector<int> sEval;
-		
-		//check types
-		for ( auto s = sEval_n.begin(); s < sEval_n.end(); s++) sEval.push_back( (*s).getInt() );
+		std::vector< HandshakeSend * > sends = sendsFor( **addedReceive );
+		for ( auto s = sends.begin(); s < sends.end(); s++ ){
 
+			//can't have a handshake between the same sp, unless it stands for more than one copy of a process (--lump)
+			if ( (*s) -> candidate -> processInSystem == (*addedReceive) -> candidate -> processInSystem and (*s) -> candidate -> processInSystem -> count < 2 ) continue;
 
-		for ( auto r_cand = _receiveToAdd.begin(); r_cand != _receiveToAdd.end(); r_cand++ ){
+			if ( (*addedReceive) -> evaluated or testEachValue( (*s) -> values, **addedReceive ) ){
 
-			//can't have a handshake between the same sp
-			if ((*addedSend) -> processInSystem == (*r_cand) -> processInSystem) continue;
+				buildHandshakeCandidate( (*s) -> candidate, (*addedReceive) -> candidate, (*s) -> values, scheduler );
+			}
+		}
+	}
 
-			MessageReceiveBlock *mrb = dynamic_cast< MessageReceiveBlock * >((*r_cand) -> actionCandidate);
-			std::vector< std::vector< Token * > > setExpressions = mrb -> getSetExpression();
+	//match added sends to added receives
+	for ( auto addedSend = _sendToAdd.begin(); addedSend != _sendToAdd.end(); addedSend++ ){
 
-			//check each value against its set expression
-			bool allPassed = true;
-			for ( unsigned int i = 0; i < sEval.size(); i++ ){
+		for ( auto r = _receiveToAdd.begin(); r != _receiveToAdd.end(); r++ ){
 
-				bool setEval = evalRPN_setTest( sEval[i], setExpressions[i], (*r_cand) -> parameterValues, _globalVars, (*r_cand) -> localVariables );
-				if (not setEval){
-					allPassed = false;
-					break;
-				}
-			}
-			if (allPassed){
+			//can't have a handshake between the same sp, unless it stands for more than one copy of a process (--lump)
+			if ( (*addedSend) -> candidate -> processInSystem == (*r) -> candidate -> processInSystem and (*r) -> candidate -> processInSystem -> count < 2 ) continue;
+			if ( (*addedSend) -> values.size() != (*r) -> arity() ) continue;
 
-				std::shared_ptr<HandshakeCandidate> newHS = buildHandshakeCandidate( *addedSend, *r_cand, sEval );
-				candidatesAdded++;
-				rateSum += newHS -> rate;
-			}
+			bool matches;
+			if ( (*r) -> evaluated ) matches = boundsContain( (*r) -> bounds, (*addedSend) -> values );
+			else matches = testEachValue( (*addedSend) -> values, **r );
+
+			if ( matches ) buildHandshakeCandidate( (*addedSend) -> candidate, (*r) -> candidate, (*addedSend) -> values, scheduler );
 		}
 	}
-	
-	//add everything to sp -> candidates at the end so we don't count anything twice
+
+	//add everything to sp -> candidates and the indices at the end so we don't count anything twice
 	for ( auto addedSend = _sendToAdd.begin(); addedSend != _sendToAdd.end(); addedSend++ ){
 
-		_hsSend_Sp2Candidates[(*addedSend) -> processInSystem].push_back( *addedSend );
+		(*addedSend) -> order = _order++;
+		(*addedSend) -> filed = _sendIndex[(*addedSend) -> values.size()].insert( std::make_pair( (*addedSend) -> values, addedSend -> get() ) );
+		_hsSend_Sp2Candidates[(*addedSend) -> candidate -> processInSystem].push_back( *addedSend );
 	}
 	for ( auto addedReceive = _receiveToAdd.begin(); addedReceive != _receiveToAdd.end(); addedReceive++ ){
 
-		_hsReceive_Sp2Candidates[(*addedReceive) -> processInSystem].push_back( *addedReceive );		
+		HandshakeReceive *r = addedReceive -> get();
+		r -> order = _order++;
+		if ( r -> evaluated ) r -> filing = _receiveIndex[r -> arity()].insert( r, r -> bounds );
+		else{
+
+			std::list< HandshakeReceive * > &unevaluated = _unevaluatedReceives[r -> arity()];
+			r -> filedUnevaluated = unevaluated.insert( unevaluated.end(), r );
+		}
+		_hsReceive_Sp2Candidates[r -> candidate -> processInSystem].push_back( *addedReceive );
 	}
 
 	_sendToAdd.clear();
 	_receiveToAdd.clear();
-
-	return std::make_pair(candidatesAdded, rateSum);
 }
 
 
-std::pair< int, double > HandshakeChannel::cleanSPFromChannel( SystemProcess *sp ){
-//clean a system process that we're removing from the system from the channel
-//return the number of handshake candidates we removed and the amount that this should decrease the total system rate
+void HandshakeChannel::cleanSPFromChannel( SystemProcess *sp, TransitionScheduler &scheduler ){
+//clean a system process that we're removing from the system from the channel, and take its handshake candidates out of the scheduler
 
+#if DEBUG_HANDSHAKE
 	int removed = 0;
-	double rateSum = 0.0;
+#endif
 
 	//for each candidate the system process used
 	if ( _possibleHandshakes_sp2Candidates.count(sp) > 0 ){
 		for ( auto c = _possibleHandshakes_sp2Candidates.at(sp).begin(); c != _possibleHandshakes_sp2Candidates.at(sp).end(); c++ ){
 
-			//count the candidate as removed and decrement the ratesum
+			//take the candidate out of the scheduler
+#if DEBUG_HANDSHAKE
 			removed++;
-			rateSum += (*c) -> rate;
-
-			//remove this candidate from the sp->candidate map for other sp's that also use it so we don't count a candidate twice later
-			assert(_possibleHandshakes_candidates2Sp.count(*c) > 0);
-
-			for ( auto otherSp = _possibleHandshakes_candidates2Sp[*c].begin(); otherSp != _possibleHandshakes_candidates2Sp[*c].end(); otherSp++ ){
+#endif
+			scheduler.remove( **c );
 
-				if ( *otherSp == sp ) continue;//we'll do this one later
-		
-				//find the candidate in the candidate list for the other sp and erase it
-				auto itr = std::find( _possibleHandshakes_sp2Candidates[*otherSp].begin(), _possibleHandshakes_sp2Candidates[*otherSp].end(), *c );
-				_possibleHandshakes_sp2Candidates[*otherSp].erase( itr );
-			}
-			_possibleHandshakes_candidates2Sp.erase( _possibleHandshakes_candidates2Sp.find( *c ) );
+			//remove this candidate from the sp->candidate map for the other sp that also uses it so we don't count a candidate twice later
+			if ( (*c) -> hsSendCand -> processInSystem == (*c) -> hsReceiveCand -> processInSystem ) continue;
+			else if ( (*c) -> hsSendCand -> processInSystem == sp ) _possibleHandshakes_sp2Candidates[ (*c) -> hsReceiveCand -> processInSystem ].erase( (*c) -> receivePosition );
+			else _possibleHandshakes_sp2Candidates[ (*c) -> hsSendCand -> processInSystem ].erase( (*c) -> sendPosition );
 		}
 		_possibleHandshakes_sp2Candidates.erase( _possibleHandshakes_sp2Candidates.find(sp) );
 	}
@@ -249,6 +255,7 @@ std::cout << "chan: ";
 for (unsigned int dbg = 0; dbg < _channelName.size(); dbg++ ) std::cout << _channelName[dbg];
 std::cout << " removed " << _hsSend_Sp2Candidates[sp].size() << " possible sends associated with " << sp << std::endl;
 #endif
+		for ( auto s = (locInSend -> second).begin(); s != (locInSend -> second).end(); s++ ) _sendIndex[(*s) -> values.size()].erase( (*s) -> filed );
 		_hsSend_Sp2Candidates.erase( locInSend );
 	}
 
@@ -260,31 +267,17 @@ std::cout << "chan: ";
 for (unsigned int dbg = 0; dbg < _channelName.size(); dbg++ ) std::cout << _channelName[dbg];
 std::cout << " removed " << _hsReceive_Sp2Candidates[sp].size() << " possible receives associated with " << sp << std::endl;
 #endif
+		for ( auto r = (locInRec -> second).begin(); r != (locInRec -> second).end(); r++ ){
+
+			if ( (*r) -> evaluated ) _receiveIndex[(*r) -> arity()].erase( (*r) -> filing );
+			else _unevaluatedReceives[(*r) -> arity()].erase( (*r) -> filedUnevaluated );
+		}
 		_hsReceive_Sp2Candidates.erase( locInRec );
 	}
 
 #if DEBUG_HANDSHAKE
 std::cout << "cleaned " << sp << " and removed " << removed << std::endl;
 #endif
-	return std::make_pair( removed, rateSum );
-}
-
-
-std::shared_ptr<HandshakeCandidate> HandshakeChannel::pickCandidate(double &runningTotal, double uniformDraw, double rateSum){
-
-	for ( auto cand = _possibleHandshakes_candidates2Sp.begin(); cand != _possibleHandshakes_candidates2Sp.end(); cand++ ){
-
-		double r = (cand -> first) -> rate;
-		double lower = runningTotal / rateSum;
-		double upper = (runningTotal + r) / rateSum;
-
-		if ( uniformDraw > lower and uniformDraw <= upper ){
-
-			return cand -> first;
-		}
-		runningTotal += r;
-	}
-	return NULL;
 }
 
 
@@ -306,7 +299,10 @@ std::cout << "associated with sp: " << sc -> processInSystem << std::endl;
 		if ( params[i].isDouble() ) throw WrongType(t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
 	}
 
-	_sendToAdd.push_back( sc );
+	std::shared_ptr<HandshakeSend> send( new HandshakeSend() );
+	send -> candidate = sc;
+	for ( auto p = params.begin(); p < params.end(); p++ ) (send -> values).push_back( p -> getInt() );
+	_sendToAdd.push_back( send );
 }
 
 
@@ -328,5 +324,24 @@ std::cout << "associated with sp: " << rc -> processInSystem << std::endl;
 		if ( params[i].isDouble() ) throw WrongType(t, "Parameter expressions in message receive must evaluate to ints, not doubles (either through explicit or implicit casting).");
 	}
 
-	_receiveToAdd.push_back( rc );
+	std::shared_ptr<HandshakeReceive> receive( new HandshakeReceive() );
+	receive -> candidate = rc;
+
+	//evaluate the set expressions once up front.  if one can't be evaluated on its own (a bad range, say), leave it to be tested against
+	//each send as it comes so that the error is thrown when, and only if, a send is actually tested against it
+	MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( b );
+	const std::vector< Bytecode > &setExpressions = mrb -> getSetExpression();
+	try{
+
+		for ( unsigned int i = 0; i < setExpressions.size(); i++ ){
+
+			(receive -> bounds).push_back( condenseToDisjoint( evalRPN_set( setExpressions[i], rc -> parameterValues, _globalVars, rc -> localVariables ) ) );
+		}
+		receive -> evaluated = true;
+	}
+	catch ( std::exception & ){
+
+		(receive -> bounds).clear();
+	}
+	_receiveToAdd.push_back( receive );
 }
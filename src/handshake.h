@@ -17,6 +17,8 @@
 #include <sstream>
 #include <iterator>
 #include "evaluate_trees.h"
+#include "intervals.h"
+#include "scheduler.h"
 
 class HandshakeCandidate{
 
@@ -26,7 +28,11 @@ class HandshakeCandidate{
 		bool bindsVariable = false;
 		std::string bindingVariable;
 		double rate;
+		int slot = -1;
 		std::vector< std::string > channel;
+
+		//where the handshake is in the sending and receiving processes' lists of possible handshakes
+		std::list< std::shared_ptr<HandshakeCandidate> >::iterator sendPosition, receivePosition;
 		HandshakeCandidate( std::shared_ptr<Candidate> send, std::shared_ptr<Candidate> receive, double r, std::vector< int > i, std::vector< std::string > c ){
 
 			hsSendCand = send;
@@ -42,26 +48,58 @@ class HandshakeCandidate{
 };
 
 
+class HandshakeSend{
+//a handshake send waiting on a channel, filed by the values it sends so that receives can find it with a range query
+
+	public:
+		std::shared_ptr<Candidate> candidate;
+		std::vector< int > values;
+		unsigned long order = 0; //when it was added to the channel, which is the order a sweep over its process's sends visits it in
+		std::multimap< std::vector< int >, HandshakeSend * >::iterator filed;
+};
+
+
+class HandshakeReceive{
+//a handshake receive waiting on a channel, with its set expressions evaluated once so that sends can find it with a stabbing query
+
+	public:
+		std::shared_ptr<Candidate> candidate;
+		Bounds bounds;
+		bool evaluated = false; //false if a set expression can't be evaluated on its own, so it's tested against each send as it comes
+		unsigned long order = 0;
+		IntervalIndex< HandshakeReceive >::Filing filing;
+		std::list< HandshakeReceive * >::iterator filedUnevaluated;
+		unsigned int arity( void ) const { return static_cast< MessageReceiveBlock * >( candidate -> actionCandidate ) -> getSetExpression().size(); }
+};
+
+
 class HandshakeChannel{
 
 	private:
 		std::vector< std::string > _channelName;
 		GlobalVariables _globalVars;
-		std::map< SystemProcess *, std::list< std::shared_ptr<Candidate> > > _hsSend_Sp2Candidates;
-		std::map< SystemProcess *, std::list< std::shared_ptr<Candidate> > > _hsReceive_Sp2Candidates;
-		std::map< SystemProcess *, std::list< std::shared_ptr<HandshakeCandidate> > > _possibleHandshakes_sp2Candidates;
-		std::map< std::shared_ptr<HandshakeCandidate>, std::list< SystemProcess * > > _possibleHandshakes_candidates2Sp;
-		std::list< std::shared_ptr<Candidate> > _sendToAdd;
-		std::list< std::shared_ptr<Candidate> > _receiveToAdd;
+		std::map< SystemProcess *, std::list< std::shared_ptr<HandshakeSend> >, SystemProcessOrder > _hsSend_Sp2Candidates;
+		std::map< SystemProcess *, std::list< std::shared_ptr<HandshakeReceive> >, SystemProcessOrder > _hsReceive_Sp2Candidates;
+
+		//sends and receives on the channel indexed by the number of parameters, and then by the values sent or the sets received on
+		std::map< unsigned int, std::multimap< std::vector< int >, HandshakeSend * > > _sendIndex;
+		std::map< unsigned int, IntervalIndex< HandshakeReceive > > _receiveIndex;
+		std::map< unsigned int, std::list< HandshakeReceive * > > _unevaluatedReceives;
+		unsigned long _order = 0;
+		std::map< SystemProcess *, std::list< std::shared_ptr<HandshakeCandidate> >, SystemProcessOrder > _possibleHandshakes_sp2Candidates;
+		std::list< std::shared_ptr<HandshakeSend> > _sendToAdd;
+		std::list< std::shared_ptr<HandshakeReceive> > _receiveToAdd;
+		bool testEachValue( const std::vector< int > &, HandshakeReceive & );
+		std::vector< HandshakeReceive * > receivesFor( const std::vector< int > & );
+		std::vector< HandshakeSend * > sendsFor( HandshakeReceive & );
 
 	public:
 		HandshakeChannel( std::vector< std::string > name, GlobalVariables & );
 		HandshakeChannel( const HandshakeChannel & );
-		std::vector< std::string > getChannelName(void);
-		std::shared_ptr<HandshakeCandidate> buildHandshakeCandidate( std::shared_ptr<Candidate> , std::shared_ptr<Candidate> , std::vector<int> );
-		std::pair<int, double> updateHandshakeCandidates(void);
-		std::pair< int, double > cleanSPFromChannel( SystemProcess * );
-		std::shared_ptr<HandshakeCandidate> pickCandidate(double &, double , double );
+		const std::vector< std::string > &getChannelName( void ) const { return _channelName; }
+		std::shared_ptr<HandshakeCandidate> buildHandshakeCandidate( std::shared_ptr<Candidate> , std::shared_ptr<Candidate> , std::vector<int>, TransitionScheduler & );
+		void updateHandshakeCandidates( TransitionScheduler & );
+		void cleanSPFromChannel( SystemProcess *, TransitionScheduler & );
 		void addSendCandidate( std::shared_ptr<Candidate> );
 		void addReceiveCandidate( std::shared_ptr<Candidate> );
 };
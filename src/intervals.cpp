@@ -0,0 +1,42 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include "intervals.h"
+
+
+bool boundsContain( const Bounds &bounds, const std::vector< int > &value ){
+
+	if ( bounds.size() != value.size() ) return false;
+	for ( unsigned int i = 0; i < value.size(); i++ ){
+
+		bool inRange = false;
+		for ( auto b = bounds[i].begin(); b < bounds[i].end(); b++ ){
+
+			if ( b -> first <= value[i] and value[i] <= b -> second ){
+
+				inRange = true;
+				break;
+			}
+		}
+		if ( not inRange ) return false;
+	}
+	return true;
+}
+
+
+bool exactValue( const Bounds &bounds, std::vector< int > &value ){
+//true if the bounds only contain one tuple, which is then put in value
+
+	value.clear();
+	for ( auto b = bounds.begin(); b < bounds.end(); b++ ){
+
+		if ( b -> size() != 1 or (*b)[0].first != (*b)[0].second ) return false;
+		value.push_back( (*b)[0].first );
+	}
+	return true;
+}
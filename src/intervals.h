@@ -0,0 +1,148 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef INTERVALS_H
+#define INTERVALS_H
+
+#include <vector>
+#include <map>
+#include <list>
+#include <climits>
+#include <algorithm>
+
+typedef std::vector< std::vector< std::pair<int, int> > > Bounds; //sorted, disjoint intervals on each dimension of a message
+
+
+/*function prototypes */
+bool boundsContain( const Bounds &, const std::vector< int > & );
+bool exactValue( const Bounds &, std::vector< int > & );
+
+
+template< typename Entries >
+bool searchRange( const Entries &entries, const Bounds &bounds, std::vector< int > &prefix, unsigned int dim, std::vector< typename Entries::const_iterator > *matches ){
+//find the entries of a map keyed on int tuples that start with the first dim values of prefix and are within bounds on every dimension
+//from dim onwards.  for each value in range on this dimension, jump straight to it in the sorted entries and recurse on the next
+//dimension, so we only touch the values that are in range.  if matches is NULL, return true as soon as anything is found
+
+	unsigned int arity = bounds.size();
+	for ( auto b = bounds[dim].begin(); b < bounds[dim].end(); b++ ){
+
+		//smallest possible entry with this prefix and a value of at least the lower bound on this dimension
+		prefix.resize( dim );
+		prefix.push_back( b -> first );
+		prefix.resize( arity, INT_MIN );
+		auto entry = entries.lower_bound( prefix );
+
+		while ( entry != entries.end() ){
+
+			const std::vector< int > &e = entry -> first;
+			if ( not std::equal( prefix.begin(), prefix.begin() + dim, e.begin() ) or e[dim] > b -> second ) break;
+
+			if ( dim + 1 == arity ){
+
+				if ( matches == NULL ) return true;
+				matches -> push_back( entry );
+				entry++;
+			}
+			else{
+
+				int value = e[dim];
+				prefix.resize( dim );
+				prefix.push_back( value );
+				if ( searchRange( entries, bounds, prefix, dim + 1, matches ) and matches == NULL ) return true;
+				if ( value == INT_MAX ) break;
+
+				//skip past every entry with this value to the next value on this dimension
+				prefix.resize( dim );
+				prefix.push_back( value + 1 );
+				prefix.resize( arity, INT_MIN );
+				entry = entries.lower_bound( prefix );
+			}
+		}
+	}
+	return false;
+}
+
+
+template< typename T >
+class IntervalIndex{
+//interval stabbing index on the first dimension of each item's bounds.  the interval spanning them is filed under its lower bound in
+//the class for its length rounded up to a power of two, so the intervals that contain a value are found by looking in each class only
+//at lower bounds at most that class's length below the value
+
+	private:
+		typedef std::pair< T *, const Bounds * > Item;
+		std::vector< std::multimap< int, Item > > _lengthClasses;
+		std::list< Item > _dimensionless; //bounds with no dimensions contain the empty tuple
+
+	public:
+		class Filing{
+		//where an item was filed, so it can be taken out again
+
+			friend class IntervalIndex;
+			unsigned int _lengthClass = UINT_MAX;
+			bool _dimensionless = false;
+			typename std::multimap< int, Item >::iterator _position;
+			typename std::list< Item >::iterator _dimensionlessPosition;
+		};
+
+		Filing insert( T *item, const Bounds &bounds ){
+		//bounds has to stay valid until the item is erased
+
+			Filing f;
+			if ( bounds.empty() ){
+
+				f._dimensionless = true;
+				f._dimensionlessPosition = _dimensionless.insert( _dimensionless.end(), Item( item, &bounds ) );
+				return f;
+			}
+
+			//an empty set on the first dimension never contains anything, so there is nothing to file
+			const std::vector< std::pair<int, int> > &first = bounds[0];
+			if ( first.empty() ) return f;
+
+			//class k holds intervals whose upper bound is less than 2^k past the lower bound
+			long long length = (long long) first.back().second - (long long) first.front().first;
+			unsigned int k = 0;
+			while ( (1LL << k) <= length ) k++;
+
+			if ( k >= _lengthClasses.size() ) _lengthClasses.resize( k + 1 );
+			f._lengthClass = k;
+			f._position = _lengthClasses[k].insert( std::make_pair( first.front().first, Item( item, &bounds ) ) );
+			return f;
+		}
+
+		void erase( const Filing &f ){
+
+			if ( f._dimensionless ) _dimensionless.erase( f._dimensionlessPosition );
+			else if ( f._lengthClass != UINT_MAX ) _lengthClasses[f._lengthClass].erase( f._position );
+		}
+
+		std::vector< T * > stab( const std::vector< int > &value ) const {
+		//the items whose bounds contain value
+
+			std::vector< T * > out;
+			if ( value.empty() ){
+
+				for ( auto i = _dimensionless.begin(); i != _dimensionless.end(); i++ ) out.push_back( i -> first );
+				return out;
+			}
+
+			for ( unsigned int k = 0; k < _lengthClasses.size(); k++ ){
+
+				long long lowest = std::max( (long long) value[0] - ((1LL << k) - 1), (long long) INT_MIN );
+				for ( auto f = _lengthClasses[k].lower_bound( (int) lowest ); f != _lengthClasses[k].end() and f -> first <= value[0]; f++ ){
+
+					if ( boundsContain( *((f -> second).second), value ) ) out.push_back( (f -> second).first );
+				}
+			}
+			return out;
+		}
+};
+
+#endif
@@ -11,12 +11,45 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <map>
 #include <assert.h>
 #include "lexer.h"
 #include "error_handling.h"
 #include "parser.h"
 
 
+/*TOKEN METHODS------------------------------------------------------------------------------------------------------------------------------------------------------*/
+TokenKind Token::kindOf( const std::string &identity ){
+//the lexer names token types with strings, which we map once to a kind so that later passes can switch on it
+
+	static const std::map< std::string, TokenKind > kinds = {{"BeaconCheck", TOKEN_BEACON_CHECK},
+								{"BeaconKill", TOKEN_BEACON_KILL},
+								{"MessageSend", TOKEN_MESSAGE_SEND},
+								{"MessageReceive", TOKEN_MESSAGE_RECEIVE},
+								{"Action", TOKEN_ACTION},
+								{"Process", TOKEN_PROCESS},
+								{"SetOperation", TOKEN_SET_OPERATION},
+								{"Variable", TOKEN_VARIABLE},
+								{"DoubleLiteral", TOKEN_DOUBLE_LITERAL},
+								{"IntLiteral", TOKEN_INT_LITERAL},
+								{"Whitespace", TOKEN_WHITESPACE},
+								{"Gate", TOKEN_GATE},
+								{"ParameterCondition", TOKEN_PARAMETER_CONDITION},
+								{"Operator", TOKEN_OPERATOR},
+								{"Comparison", TOKEN_COMPARISON},
+								{"Assignment", TOKEN_ASSIGNMENT},
+								{"Parentheses", TOKEN_PARENTHESES},
+								{"Comma", TOKEN_COMMA},
+								{"MessagePrimitive", TOKEN_MESSAGE_PRIMITIVE},
+								{"Semicolon", TOKEN_SEMICOLON},
+								{"Function", TOKEN_FUNCTION}};
+
+	auto k = kinds.find( identity );
+	assert( k != kinds.end() );
+	return k -> second;
+}
+
+
 /*AUTOMATON METHODS--------------------------------------------------------------------------------------------------------------------------------------------------*/
 void FiniteStateAutomaton::add_edge( std::string inState, std::set< char > acceptingChars, std::string outState ){
 //adds an edge to a finite state automaton
@@ -517,7 +550,7 @@ std::vector< std::vector< Token * > > scanSource( std::string &sourceFilename ){
 	std::vector< Token * > running;
 	for ( auto t = tokenisation.begin(); t < tokenisation.end(); t++ ){
 
-		if ( (*t) -> identify() == "Semicolon" ){
+		if ( (*t) -> kind() == TOKEN_SEMICOLON ){
 			
 			parsedTokenisation.push_back(running);
 			running.clear();
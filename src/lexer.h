@@ -14,20 +14,29 @@
 #include <tuple>
 #include <set>
 
+enum TokenKind { TOKEN_BEACON_CHECK, TOKEN_BEACON_KILL, TOKEN_MESSAGE_SEND, TOKEN_MESSAGE_RECEIVE, TOKEN_ACTION, TOKEN_PROCESS,
+		 TOKEN_SET_OPERATION, TOKEN_VARIABLE, TOKEN_DOUBLE_LITERAL, TOKEN_INT_LITERAL, TOKEN_WHITESPACE, TOKEN_GATE,
+		 TOKEN_PARAMETER_CONDITION, TOKEN_OPERATOR, TOKEN_COMPARISON, TOKEN_ASSIGNMENT, TOKEN_PARENTHESES, TOKEN_COMMA,
+		 TOKEN_MESSAGE_PRIMITIVE, TOKEN_SEMICOLON, TOKEN_FUNCTION };
+
 class Token{
 	
 	protected:
 		std::string _raw, _identity;
+		TokenKind _kind;
 		unsigned int _lineNumber, _column;
 
 	public:
-		std::string identify( void ) { return _identity; }
-		std::string value( void ) { return _raw; }
-		unsigned int getLine( void ) { return _lineNumber; }
-		unsigned int getColumn( void ) { return _column; }
+		static TokenKind kindOf( const std::string & );
+		const std::string &identify( void ) const { return _identity; }
+		TokenKind kind( void ) const { return _kind; }
+		const std::string &value( void ) const { return _raw; }
+		unsigned int getLine( void ) const { return _lineNumber; }
+		unsigned int getColumn( void ) const { return _column; }
 		Token( std::string identity, std::string raw, unsigned int lineNumber, unsigned int column ){
 
 			_identity = identity;
+			_kind = kindOf( identity );
 			_raw = raw;
 			_lineNumber = lineNumber;
 			_column = column;
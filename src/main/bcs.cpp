@@ -12,6 +12,7 @@
 #include <tuple>
 #include <utility>
 #include <iostream>
+#include <cstdio>
 #include "../lexer.h"
 #include "../parser.h"
 #include "../simulator.h"
@@ -29,6 +30,27 @@ static const char *help=
 "  -t,--threads              number of threads to use (default: 1),\n"
 "  -m,--maxTrans             maximum number of transitions allowed per simulation (default: 1000000),\n"
 "  -d,--maxDuration          maximum duration of each simulation(default: Inf),\n"
+"  --seed                    seed for the random number generator, so that simulations can be reproduced (default: random),\n"
+"  -e,--engine               simulation algorithm: direct (Gillespie direct method), nrm (next reaction method), crn (direct method on\n"
+"                            species counts, for models without beacons or handshakes), or tau (tau-leaping on species counts, an\n"
+"                            approximation for the same models) (default: direct),\n"
+"  --fast                    write each run of transitions at this rate or faster as its last transition.  the simulation is still\n"
+"                            exact and takes as long; only the output is shorter.  always uses -e nrm, so -e direct is switched\n"
+"                            to nrm, and can't be used with --summary or --record-* (default: none),\n"
+"  --tau-epsilon             with -e tau, the largest relative change in a species count expected over one leap (default: 0.03),\n"
+"  --format                  output format: text or bin (compact binary, written to a .simulation.bcsb file that bcs-convert turns back into text) (default: text),\n"
+"  --ordered                 write simulations in order, so the output is the same for any number of threads,\n"
+"  --buffer                  kilobytes of each simulation's output held in memory while another is being written, before the rest is\n"
+"                            set aside in a temporary file (default: 2048),\n"
+"  --lump                    simulate identical processes as one process with a count, which is faster for models with many copies of a process,\n"
+"  --index                   also write a .idx sidecar index of where each simulation is in the output, for bcs-extract,\n"
+"  --summary                 instead of trajectories, write time-binned statistics of the transitions matching name[:process[:parameter]]\n"
+"                            to a .summary.tsv file (can be given more than once),\n"
+"  --grid                    time bins for --summary as start:stop:width (default: 100 bins up to --maxDuration),\n"
+"  --record-actions          only write transitions of these actions, comma-separated (default: all),\n"
+"  --record-channels         only write transitions on these channels, by name and comma-separated (default: all),\n"
+"  --record-processes        only write transitions of these processes, comma-separated (default: all),\n"
+"  --sampleEvery             instead of each transition, write the state of every process at multiples of this time to a .samples.bcs file,\n"
 "  -h,--help                 show useage information,\n"
 "  -v,--version              show version.\n";
 
@@ -36,11 +58,7 @@ static const char *help=
 struct Arguments {
 
 	std::string targetFilename;
-	std::string outputFilename;
-	int threads;
-	int numOfSimulations;
-	int maxTrans;
-	double maxDuration;
+	SimulationOptions options;
 };
 
 
@@ -61,6 +79,19 @@ void showVersion(){
 }
 
 
+void splitNames( const std::string &list, std::vector< std::string > &names ){
+
+	size_t start = 0;
+	while ( start <= list.size() ){
+
+		size_t end = list.find( ',', start );
+		if ( end == std::string::npos ) end = list.size();
+		if ( end > start ) names.push_back( list.substr( start, end - start ) );
+		start = end + 1;
+	}
+}
+
+
 Arguments parseArguments( int argc, char** argv ){
 
 	if( argc < 2 ){
@@ -85,11 +116,8 @@ Arguments parseArguments( int argc, char** argv ){
 	Arguments args;
 
 	/*defaults - we'll override these if the option was specified by the user */
-	args.outputFilename = "simulationOutput";
-	args.threads = 1;
-	args.numOfSimulations = 1;
-	args.maxTrans = 1000000;
-	args.maxDuration = std::numeric_limits<double>::max();
+	args.options.outputFilename = "simulationOutput";
+	std::string outputPrefix;
 
 	/*parse the command line arguments */
 	for ( int i = 1; i < argc; ){
@@ -99,33 +127,166 @@ Arguments parseArguments( int argc, char** argv ){
 		if ( flag == "-o" or flag == "--output" ){
 
 			std::string strArg( argv[ i + 1 ] );
-			args.outputFilename = strArg + ".simulation.bcs";
+			outputPrefix = strArg;
 			i+=2;	
 		}
 		else if ( flag == "-s" or flag == "--simulations" ){
 
 			std::string strArg( argv[ i + 1 ] );
-			args.numOfSimulations = atoi( strArg.c_str() );
+			args.options.numOfSimulations = atoi( strArg.c_str() );
 			i+=2;	
 		}
 		else if ( flag == "-m" or flag == "--maxTrans" ){
 
 			std::string strArg( argv[ i + 1 ] );
-			args.maxTrans = atoi( strArg.c_str() );
+			args.options.maxTransitions = atoi( strArg.c_str() );
 			i+=2;	
 		}
 		else if ( flag == "-d" or flag == "--maxDuration" ){
 
 			std::string strArg( argv[ i + 1 ] );
-			args.maxDuration = atof( strArg.c_str() );
+			args.options.maxDuration = atof( strArg.c_str() );
 			i+=2;	
 		}
 		else if ( flag == "-t" or flag == "--threads" ){
 
 			std::string strArg( argv[ i + 1 ] );
-			args.threads = atoi( strArg.c_str() );
+			args.options.threads = atoi( strArg.c_str() );
 			i+=2;	
 		}
+		else if ( flag == "--seed" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			args.options.seed = strtoull( strArg.c_str(), NULL, 10 );
+			args.options.seedSpecified = true;
+			i+=2;
+		}
+		else if ( flag == "-e" or flag == "--engine" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			if ( strArg == "direct" ) args.options.engine = ENGINE_DIRECT;
+			else if ( strArg == "nrm" ) args.options.engine = ENGINE_NRM;
+			else if ( strArg == "crn" ) args.options.engine = ENGINE_CRN;
+			else if ( strArg == "tau" ) args.options.engine = ENGINE_TAU;
+			else{
+
+				std::cout << "Exiting with error.  Unknown simulation engine: " << strArg << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
+		else if ( flag == "--fast" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			args.options.fastRate = atof( strArg.c_str() );
+			if ( not ( args.options.fastRate > 0.0 ) ){
+
+				std::cout << "Exiting with error.  Fast rate should be positive, but got: " << strArg << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
+		else if ( flag == "--tau-epsilon" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			args.options.tauEpsilon = atof( strArg.c_str() );
+			if ( not ( args.options.tauEpsilon > 0.0 and args.options.tauEpsilon < 1.0 ) ){
+
+				std::cout << "Exiting with error.  Tau-leaping epsilon should be between 0 and 1, but got: " << strArg << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
+		else if ( flag == "--ordered" ){
+
+			args.options.ordered = true;
+			i+=1;
+		}
+		else if ( flag == "--buffer" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			args.options.outputBuffer = strtoull( strArg.c_str(), NULL, 10 ) * 1024;
+			if ( args.options.outputBuffer == 0 ){
+
+				std::cout << "Exiting with error.  --buffer must be a positive number of kilobytes." << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
+		else if ( flag == "--index" ){
+
+			args.options.writeIndex = true;
+			i+=1;
+		}
+		else if ( flag == "--summary" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			args.options.summarySelectors.push_back( strArg );
+			i+=2;
+		}
+		else if ( flag == "--grid" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			if ( sscanf( strArg.c_str(), "%lf:%lf:%lf", &args.options.gridStart, &args.options.gridStop, &args.options.gridWidth ) != 3 or not ( args.options.gridWidth > 0.0 ) ){
+
+				std::cout << "Exiting with error.  Time grid should be start:stop:width, e.g. 0:100:1, but got: " << strArg << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
+		else if ( flag == "--record-actions" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			splitNames( strArg, args.options.recordActions );
+			i+=2;
+		}
+		else if ( flag == "--record-channels" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			splitNames( strArg, args.options.recordChannels );
+			i+=2;
+		}
+		else if ( flag == "--record-processes" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			splitNames( strArg, args.options.recordProcesses );
+			i+=2;
+		}
+		else if ( flag == "--lump" ){
+
+			args.options.lump = true;
+			i+=1;
+		}
+		else if ( flag == "--sampleEvery" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			args.options.sampleEvery = atof( strArg.c_str() );
+			if ( not ( args.options.sampleEvery > 0.0 ) ){
+
+				std::cout << "Exiting with error.  Sampling interval should be a positive time, but got: " << strArg << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
+		else if ( flag == "--format" ){
+
+			std::string strArg( argv[ i + 1 ] );
+			if ( strArg == "text" ) args.options.format = FORMAT_TEXT;
+			else if ( strArg == "bin" ) args.options.format = FORMAT_BIN;
+			else{
+
+				std::cout << "Exiting with error.  Unknown output format: " << strArg << std::endl;
+				showHelp();
+				exit(EXIT_FAILURE);
+			}
+			i+=2;
+		}
 		else if ( flag == "-h" or flag == "--help" ){
 
 			showHelp();
@@ -151,6 +312,34 @@ Arguments parseArguments( int argc, char** argv ){
 		}
 	}
 
+	if ( args.options.fastRate < std::numeric_limits<double>::infinity() and ( not args.options.summarySelectors.empty() or not args.options.recordActions.empty() or not args.options.recordChannels.empty() or not args.options.recordProcesses.empty() ) ){
+
+		std::cout << "Exiting with error.  --fast only writes the last transition of each run of fast transitions, so it can't be used with --summary or --record-actions, --record-channels, or --record-processes." << std::endl;
+		showHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	if ( not args.options.summarySelectors.empty() and args.options.gridWidth == 0.0 and args.options.maxDuration == std::numeric_limits<double>::max() ){
+
+		std::cout << "Exiting with error.  --summary needs a time grid from --grid or --maxDuration." << std::endl;
+		showHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	if ( args.options.sampleEvery > 0.0 and ( args.options.format == FORMAT_BIN or not args.options.summarySelectors.empty() ) ){
+
+		std::cout << "Exiting with error.  --sampleEvery writes text, so it can't be used with --format bin or --summary." << std::endl;
+		showHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	if ( not outputPrefix.empty() ){
+
+		if ( not args.options.summarySelectors.empty() ) args.options.outputFilename = outputPrefix + ".summary.tsv";
+		else if ( args.options.sampleEvery > 0.0 ) args.options.outputFilename = outputPrefix + ".samples.bcs";
+		else args.options.outputFilename = outputPrefix + ( args.options.format == FORMAT_BIN ? ".simulation.bcsb" : ".simulation.bcs" );
+	}
+
 	return args;
 }
 
@@ -181,7 +370,7 @@ std::cout << "Finished block parser." << std::endl;
 #endif
 
 	/*call the simulator */
-	simulateSystem( blockParsed.first, blockParsed.second, std::get<2>(parsedSource), args.numOfSimulations, args.threads, args.outputFilename, args.maxTrans, args.maxDuration );
+	simulateSystem( blockParsed.first, blockParsed.second, std::get<2>(parsedSource), args.options );
 
 #if DEBUG
 std::cout << "Finished simulation." << std::endl;
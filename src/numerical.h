@@ -26,13 +26,6 @@ class Numerical{
 			isDouble_b = false;
 			isInt_b = false;
 		}
-		Numerical(const Numerical &n){
-
-			dVal = n.dVal;
-			iVal = n.iVal;
-			isDouble_b = n.isDouble_b;
-			isInt_b = n.isInt_b;
-		}
 		inline void setDouble(double d){
 
 			assert(not isDouble_b and not isInt_b); //not already set
@@ -68,6 +61,10 @@ class Numerical{
 			assert(isDouble_b or isInt_b); //is already set
 			return isInt_b;
 		}
+		inline bool isSet(void) const{
+
+			return isDouble_b or isInt_b;
+		}
 		inline bool isDouble(void){
 
 			assert(isDouble_b or isInt_b); //is already set
@@ -0,0 +1,304 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include "lexer.h"
+#include "error_handling.h"
+#include "output.h"
+
+
+static void backOff( unsigned int &attempt ){
+//wait for the other side of a queue: yield a few times, then sleep for longer and longer up to a millisecond
+
+	if ( attempt < 16 ) std::this_thread::yield();
+	else std::this_thread::sleep_for( std::chrono::microseconds( std::min( 50u << std::min( ( attempt - 16 ) / 8, 5u ), 1000u ) ) );
+	if ( attempt < 64 ) attempt++;
+}
+
+
+/*SPILL FILES---------------------------------------------------------------------------------------------------------------------------------------------------*/
+SpillFile::~SpillFile(){
+
+	if ( fd >= 0 ) ::close( fd );
+}
+
+
+SpillFile *TrajectoryWriter::spillFile( void ){
+//the calling thread's spill file, made the first time it needs one.  returns NULL if a temporary file can't be made, and the
+//simulation just waits for the writer instead
+
+	std::lock_guard< std::mutex > lock( _spillMutex );
+	std::unique_ptr< SpillFile > &file = _spillFiles[ std::this_thread::get_id() ];
+	if ( file == NULL ){
+
+		const char *dir = getenv( "TMPDIR" );
+		std::string path = std::string( dir != NULL ? dir : "/tmp" ) + "/bcs-spill-XXXXXX";
+		int fd = mkstemp( &path[0] );
+		if ( fd < 0 ) return NULL;
+		unlink( path.c_str() );
+		file.reset( new SpillFile() );
+		file -> fd = fd;
+	}
+	return file.get();
+}
+
+
+void TrajectoryWriter::copySpill( const ChunkQueue &stream, std::string &chunk ){
+//write out the part of a simulation that was set aside, reading it back a chunk at a time
+
+	chunk.resize( _chunkSize );
+	uint64_t done = 0;
+	while ( done < stream.spillLength ){
+
+		ssize_t n = pread( (stream.spill) -> fd, &chunk[0], std::min( (uint64_t) _chunkSize, stream.spillLength - done ), stream.spillOffset + done );
+		if ( n <= 0 ) throw BadOutputPath();
+		_outFile.write( chunk.data(), n );
+		done += n;
+	}
+	_bytesWritten += done;
+
+	//the disk space is given back now where that's possible, since the thread may keep setting output aside after it and
+	//only empties the file when nothing in it is waiting
+#ifdef FALLOC_FL_PUNCH_HOLE
+	fallocate( (stream.spill) -> fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, stream.spillOffset, stream.spillLength );
+#endif
+	(stream.spill) -> waiting.fetch_sub( done, std::memory_order_release );
+}
+
+
+/*CHUNK QUEUE-----------------------------------------------------------------------------------------------------------------------------------------------------*/
+bool ChunkQueue::tryPush( std::string &chunk ){
+
+	unsigned long tail = _tail.load( std::memory_order_relaxed );
+	if ( tail - _head.load( std::memory_order_acquire ) == _slots.size() ) return false;
+
+	_slots[ tail % _slots.size() ].swap( chunk );
+	_tail.store( tail + 1, std::memory_order_release );
+	return true;
+}
+
+
+bool ChunkQueue::tryPop( std::string &chunk ){
+
+	unsigned long head = _head.load( std::memory_order_relaxed );
+	if ( head == _tail.load( std::memory_order_acquire ) ) return false;
+
+	chunk.swap( _slots[ head % _slots.size() ] );
+	_head.store( head + 1, std::memory_order_release );
+	return true;
+}
+
+
+/*TRAJECTORY WRITER-----------------------------------------------------------------------------------------------------------------------------------------------*/
+TrajectoryWriter::TrajectoryWriter( const std::string &filename, const std::string &indexFilename, bool binary, bool ordered, uint64_t buffer ) : _outFile( filename, std::ios::binary ), _closing( false ), _ordered( ordered ), _indexFilename( indexFilename ), _binary( binary ){
+
+	//each simulation holds up to buffer bytes in its queue before setting the rest aside
+	_chunkSize = (unsigned int) std::max( std::min( buffer / chunksPerStream, (uint64_t) maxChunkSize ), (uint64_t) 1 );
+
+	_thread = std::thread( &TrajectoryWriter::run, this );
+}
+
+
+std::shared_ptr< ChunkQueue > TrajectoryWriter::open( long simulation ){
+//start the output of a new simulation, or of something else in the file if simulation is -1
+
+	std::shared_ptr< ChunkQueue > stream = std::make_shared< ChunkQueue >( chunksPerStream, simulation );
+	std::lock_guard< std::mutex > lock( _streamsMutex );
+	_streams.push_back( stream );
+	return stream;
+}
+
+
+void TrajectoryWriter::close( void ){
+//write out everything that's left and stop the thread, once every simulation has closed its stream
+
+	if ( not _thread.joinable() ) return;
+	_closing.store( true, std::memory_order_release );
+	_thread.join();
+	_outFile.flush();
+	if ( not _indexFilename.empty() ) writeIndex( _indexFilename, _binary, _dataStart, _bytesWritten, _index );
+}
+
+
+void TrajectoryWriter::run( void ){
+
+	std::string chunk;
+	unsigned int attempt = 0;
+	while ( true ){
+
+		//check for closing first, so that every stream opened before it was set is seen below
+		bool closing = _closing.load( std::memory_order_acquire );
+		std::shared_ptr< ChunkQueue > current;
+		{
+			std::lock_guard< std::mutex > lock( _streamsMutex );
+			auto next = _streams.begin();
+			if ( _ordered ){
+
+				while ( next != _streams.end() and (*next) -> simulation >= 0 and (*next) -> simulation != _nextSimulation ) next++;
+
+				//only if a simulation never started, so nothing is lost
+				if ( next == _streams.end() and closing ) next = _streams.begin();
+			}
+			else if ( next != _streams.end() and (*next) -> simulation >= 0 ){
+
+				//a finished simulation can be written straight through, and otherwise the one with the most waiting is furthest along.
+				//one that's setting its output aside is left until it finishes, and nothing is picked until some simulation has output
+				auto ready = _streams.end();
+				unsigned long most = 0;
+				for ( auto s = _streams.begin(); s != _streams.end(); s++ ){
+
+					if ( (*s) -> isClosed() ){
+
+						ready = s;
+						break;
+					}
+					if ( not (*s) -> isSpilling() and (*s) -> pending() > most ){
+
+						ready = s;
+						most = (*s) -> pending();
+					}
+				}
+				next = ( ready == _streams.end() and closing ) ? _streams.begin() : ready;
+			}
+			if ( next != _streams.end() ){
+
+				current = *next;
+				_streams.erase( next );
+			}
+		}
+
+		if ( current == NULL ){
+
+			if ( closing ) return;
+			backOff( attempt );
+			continue;
+		}
+		current -> startWriting();
+
+		//write this simulation's chunks as they come until it's closed and there are none left
+		uint64_t start = _bytesWritten;
+		while ( true ){
+
+			if ( current -> tryPop( chunk ) ){
+
+				_outFile.write( chunk.data(), chunk.size() );
+				_bytesWritten += chunk.size();
+				attempt = 0;
+			}
+			else if ( current -> isClosed() ){
+
+				//the last chunk is pushed before the stream is closed, so check again now that we know it's closed
+				if ( not current -> tryPop( chunk ) ) break;
+				_outFile.write( chunk.data(), chunk.size() );
+				_bytesWritten += chunk.size();
+			}
+			else backOff( attempt );
+		}
+		if ( current -> spillLength > 0 ) copySpill( *current, chunk );
+
+		if ( current -> simulation < 0 ) _dataStart = _bytesWritten;
+		else{
+
+			_nextSimulation = current -> simulation + 1;
+
+			IndexEntry e;
+			e.simulation = current -> simulation;
+			e.offset = start;
+			e.length = _bytesWritten - start;
+			e.transitions = current -> transitions;
+			e.finalTime = current -> finalTime;
+			_index.push_back( e );
+		}
+	}
+}
+
+
+/*TRAJECTORY STREAM-----------------------------------------------------------------------------------------------------------------------------------------------*/
+TrajectoryStream::TrajectoryStream( TrajectoryWriter &writer, long simulation ) : _writer( writer ){
+
+	_queue = writer.open( simulation );
+	startChunk();
+}
+
+
+void TrajectoryStream::startChunk( void ){
+
+	_chunk.resize( _writer.chunkSize() );
+	setp( &_chunk[0], &_chunk[0] + _chunk.size() );
+}
+
+
+void TrajectoryStream::pushChunk( void ){
+//hand what's been written so far to the writer, waiting for space in the queue if the writer is behind
+
+	_chunk.resize( pptr() - pbase() );
+	unsigned int attempt = 0;
+	while ( _queue -> spill == NULL and not _queue -> tryPush( _chunk ) ){
+
+		//the writer is on another simulation that may be slow, so set this one aside rather than wait for it
+		if ( not _queue -> isBeingWritten() ){
+
+			_queue -> spill = _writer.spillFile();
+			if ( _queue -> spill != NULL ){
+
+				//start the file again if the writer has read back everything set aside in it before, so it doesn't keep growing
+				SpillFile &file = *( _queue -> spill );
+				if ( file.size > 0 and file.waiting.load( std::memory_order_acquire ) == 0 ){
+
+					if ( ftruncate( file.fd, 0 ) != 0 ) throw BadOutputPath();
+					file.size = 0;
+				}
+				_queue -> spillOffset = file.size;
+				_queue -> startSpilling();
+			}
+		}
+		if ( _queue -> spill == NULL ) backOff( attempt );
+	}
+
+	if ( _queue -> spill != NULL ){
+
+		SpillFile &file = *( _queue -> spill );
+		size_t done = 0;
+		while ( done < _chunk.size() ){
+
+			ssize_t n = pwrite( file.fd, _chunk.data() + done, _chunk.size() - done, file.size + done );
+			if ( n <= 0 ) throw BadOutputPath();
+			done += n;
+		}
+		file.size += done;
+		file.waiting.fetch_add( done, std::memory_order_relaxed );
+		_queue -> spillLength += done;
+	}
+	startChunk();
+}
+
+
+TrajectoryStream::int_type TrajectoryStream::overflow( int_type c ){
+
+	pushChunk();
+	if ( not traits_type::eq_int_type( c, traits_type::eof() ) ){
+
+		*pptr() = traits_type::to_char_type( c );
+		pbump( 1 );
+	}
+	return traits_type::not_eof( c );
+}
+
+
+void TrajectoryStream::close( uint64_t transitions, double finalTime ){
+//hand over whatever is left and let the writer move on to the next simulation
+
+	if ( pptr() > pbase() ) pushChunk();
+	_queue -> transitions = transitions;
+	_queue -> finalTime = finalTime;
+	_queue -> close();
+}
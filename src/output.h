@@ -0,0 +1,131 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <streambuf>
+#include "trajectory_index.h"
+
+enum OutputFormat { FORMAT_TEXT, FORMAT_BIN };
+
+
+struct SpillFile{
+//an unlinked temporary file that one thread appends set-aside output to, and that the writer thread reads back from.  the writer
+//frees each part of it once read back, and the thread that owns it empties it before setting more aside once nothing is waiting, so
+//it only takes up as much disk as the output that hasn't been written yet
+
+	int fd = -1;
+	uint64_t size = 0; //only changed by the thread that owns the file
+	std::atomic< uint64_t > waiting; //bytes set aside that the writer hasn't read back yet
+	SpillFile() : waiting( 0 ) {}
+	~SpillFile();
+};
+
+
+class ChunkQueue{
+//bounded lock-free queue of output chunks from one simulation (the only producer) to the writer thread (the only consumer).
+//chunks are swapped in and out of the slots rather than copied, so the producer gets back a buffer the writer has finished with
+
+	private:
+		std::vector< std::string > _slots;
+		std::atomic< unsigned long > _head, _tail; //next slot to pop and next slot to push
+		std::atomic< bool > _closed, _writing, _spilling;
+
+	public:
+		long simulation; //-1 for output that isn't a simulation, like the binary header
+		uint64_t transitions = 0; //set by the simulation before it closes the queue, for the index
+		double finalTime = 0.0;
+
+		//once a simulation starts setting its output aside, the rest of it goes to this file after whatever is in the queue
+		SpillFile *spill = NULL;
+		uint64_t spillOffset = 0, spillLength = 0;
+
+		ChunkQueue( unsigned int capacity, long sim ) : _slots( capacity ), _head( 0 ), _tail( 0 ), _closed( false ), _writing( false ), _spilling( false ), simulation( sim ) {}
+		bool tryPush( std::string & );
+		bool tryPop( std::string & );
+		void close( void ){ _closed.store( true, std::memory_order_release ); }
+		bool isClosed( void ) const { return _closed.load( std::memory_order_acquire ); }
+		void startWriting( void ){ _writing.store( true, std::memory_order_release ); }
+		bool isBeingWritten( void ) const { return _writing.load( std::memory_order_acquire ); }
+		void startSpilling( void ){ _spilling.store( true, std::memory_order_release ); }
+		bool isSpilling( void ) const { return _spilling.load( std::memory_order_acquire ); }
+		unsigned long pending( void ) const { return _tail.load( std::memory_order_acquire ) - _head.load( std::memory_order_acquire ); }
+};
+
+
+class TrajectoryWriter{
+//owns the output file and a thread that writes simulations to it as they run.  the chunks of one simulation are written
+//together, so while the writer is on one simulation, the others fill their queues.  a simulation that fills its queue before the
+//writer gets to it sets the rest of its output aside in its thread's spill file instead of waiting, so a slow simulation doesn't
+//hold up the others.  if given an index filename, it also writes the sidecar index once every simulation is done.
+//the writer takes whichever simulation is ready first: one that has finished, or else the one with the most output waiting in its
+//queue.  if the output is ordered, simulations are instead written by index so the file doesn't depend on the number of threads
+
+	private:
+		std::ofstream _outFile;
+		std::mutex _streamsMutex;
+		std::deque< std::shared_ptr< ChunkQueue > > _streams; //in the order the simulations started
+		std::atomic< bool > _closing;
+		std::thread _thread;
+		bool _ordered;
+		unsigned int _chunkSize;
+		long _nextSimulation = 0;
+		std::mutex _spillMutex;
+		std::map< std::thread::id, std::unique_ptr< SpillFile > > _spillFiles;
+		void copySpill( const ChunkQueue &, std::string & );
+
+		//where each simulation ended up in the file, for the sidecar index
+		std::string _indexFilename;
+		bool _binary;
+		uint64_t _bytesWritten = 0, _dataStart = 0;
+		std::vector< IndexEntry > _index;
+		void run( void );
+
+	public:
+		static const unsigned int maxChunkSize = 1 << 18;
+		static const unsigned int chunksPerStream = 8;
+		TrajectoryWriter( const std::string &, const std::string &, bool, bool = false, uint64_t = (uint64_t) maxChunkSize * chunksPerStream );
+		~TrajectoryWriter(){ close(); }
+		std::shared_ptr< ChunkQueue > open( long );
+		bool isOrdered( void ) const { return _ordered; }
+		unsigned int chunkSize( void ) const { return _chunkSize; }
+		SpillFile *spillFile( void );
+		void close( void );
+};
+
+
+class TrajectoryStream : public std::streambuf {
+//buffer for a simulation's output that hands it to the writer a chunk at a time, so memory doesn't grow with the simulation's length
+
+	private:
+		TrajectoryWriter &_writer;
+		std::shared_ptr< ChunkQueue > _queue;
+		std::string _chunk;
+		void startChunk( void );
+		void pushChunk( void );
+
+	protected:
+		int_type overflow( int_type );
+		int sync( void ){ return 0; } //only full chunks are handed over, so flushing a line does nothing
+
+	public:
+		TrajectoryStream( TrajectoryWriter &, long );
+		void close( uint64_t, double );
+};
+
+#endif
@@ -61,7 +61,7 @@ void checkProcessGrammar( Tree<Token> pt, Token *t ){
 
 		//leaves must be messages, actions, or processes 
 		if ( std::find( ut.begin(), ut.end(), t -> identify() ) == ut.end() ) throw SyntaxError( t, "Thrown by parser: Leaf nodes must be messages, actions, or processes." );
-		if ( t -> identify() == "Gate" ) throw SyntaxError( t, "Thrown by parser: This gate does not guard an action." );
+		if ( t -> kind() == TOKEN_GATE ) throw SyntaxError( t, "Thrown by parser: This gate does not guard an action." );
 		return;
 	}
 
@@ -73,7 +73,7 @@ void checkProcessGrammar( Tree<Token> pt, Token *t ){
 		if ( children.size() != 2 ) throw SyntaxError( t, "Thrown by parser: Assignment must have two arguments." );
 
 		/*LHS must be process, RHS must be +, ||, or action */
-		if ( children[0] -> identify() != "Process" ) throw SyntaxError( children[0], "Thrown by parser: Left hand side of this assignment must be a process." );
+		if ( children[0] -> kind() != TOKEN_PROCESS ) throw SyntaxError( children[0], "Thrown by parser: Left hand side of this assignment must be a process." );
 		if ( std::find( ut.begin(), ut.end(), children[1] -> identify() ) == ut.end() and std::find( bt.begin(), bt.end(), children[1] -> value() ) == bt.end() ){
 
 			throw SyntaxError( children[1], "Thrown by parser: Right hand side of this assignment must be an action, unary, or binary operator." ); 
@@ -101,7 +101,7 @@ void checkProcessGrammar( Tree<Token> pt, Token *t ){
 		checkProcessGrammar( pt, children[0] );
 		checkProcessGrammar( pt, children[1] );
 	}
-	else if ( t -> identify() == "Process" ){
+	else if ( t -> kind() == TOKEN_PROCESS ){
 	
 		//processes must be leaves
 		if ( not pt.isLeaf( t ) ) throw SyntaxError( t, "Thrown by parser: A process can not be used as prefix." );
@@ -131,11 +131,11 @@ void matchParentheses( std::vector< Token * > tokenisedLine ){
 
 	for ( auto i = tokenisedLine.begin(); i < tokenisedLine.end(); i++ ){
 
-		if ( ( (*i) -> identify() == "Parentheses" ) and ( (*i) -> value() == "(" ) ) {
+		if ( ( (*i) -> kind() == TOKEN_PARENTHESES ) and ( (*i) -> value() == "(" ) ) {
 
 			parenStack.push( *i );
 		}
-		else if ( ( (*i) -> identify() == "Parentheses" ) and ( (*i) -> value() == ")" ) ) {
+		else if ( ( (*i) -> kind() == TOKEN_PARENTHESES ) and ( (*i) -> value() == ")" ) ) {
 
 			if ( parenStack.empty() ) throw UnbalancedParentheses( *i );
 
@@ -153,7 +153,7 @@ std::vector< Token * > parseSystemLine( std::vector< Token * > &tokenisedLine ){
 	int flip = 0;
 
 	/*check the end to make sure we trail with a process */
-	if ( tokenisedLine.back() -> identify() != "Process" ){
+	if ( tokenisedLine.back() -> kind() != TOKEN_PROCESS ){
 
 		throw SyntaxError ( tokenisedLine.back(), "Thrown by parser: System line must trail with a process or local variable assignment." );
 	}
@@ -161,18 +161,18 @@ std::vector< Token * > parseSystemLine( std::vector< Token * > &tokenisedLine ){
 	/*make sure process and parallel operators alternate */
 	for ( auto t = tokenisedLine.begin(); t < tokenisedLine.end(); t++ ){
 
-		if ( (*t) -> identify() == "Process" and flip == 0 ){
+		if ( (*t) -> kind() == TOKEN_PROCESS and flip == 0 ){
 
 			flip++; flip %= 2;
 			tokenisedSystemLine.push_back( *t );
 			continue;
 		} 
-		else if ( ((*t) -> identify() == "Variable" or (*t) -> identify() == "IntLiteral") and (*(t+1)) -> value() == "*" and (*(t+2)) -> identify() == "Process" ){
+		else if ( ((*t) -> kind() == TOKEN_VARIABLE or (*t) -> kind() == TOKEN_INT_LITERAL) and (*(t+1)) -> value() == "*" and (*(t+2)) -> kind() == TOKEN_PROCESS ){
 
 			tokenisedSystemLine.push_back( *t );
 			continue;
 		}
-		else if ( (*t) -> value() == "*" and ( (*(t-1)) -> identify() == "Variable" or (*(t-1)) -> identify() == "IntLiteral") and (*(t+1)) -> identify() == "Process" ){
+		else if ( (*t) -> value() == "*" and ( (*(t-1)) -> kind() == TOKEN_VARIABLE or (*(t-1)) -> kind() == TOKEN_INT_LITERAL) and (*(t+1)) -> kind() == TOKEN_PROCESS ){
 
 			continue;
 		}
@@ -234,13 +234,13 @@ void parseDefLine( Token *parentToken, std::vector< Token * > &tokenisedLine, Tr
 		else if ( (*t) -> value() == ")" ) parenStack.pop();
 
 		/*find pivot using reverse iterators */
-		if ( ( (*t) -> value() == "." or (*t) -> identify() == "Gate" ) and parenStack.empty() ){
+		if ( ( (*t) -> value() == "." or (*t) -> kind() == TOKEN_GATE ) and parenStack.empty() ){
 
 			/*separate into LHS and RHS of pivot */
 			RHS.insert( RHS.end(), std::next(t), tokenisedLine.end() );
 			LHS.insert( LHS.end(), tokenisedLine.begin(), t );
 
-			if ( (*t) -> identify() == "Gate" ){
+			if ( (*t) -> kind() == TOKEN_GATE ){
 
 				/*at this point, the tokenised line should look something like [g] -> B.C so make sure LHS is empty*/
 				if ( LHS.size() != 0 ) throw SyntaxError( LHS[0], "Thrown by parser: Could not parse gate - check syntax." );
@@ -323,7 +323,7 @@ std::tuple< std::vector< Tree<Token> >, std::vector<Token *>, GlobalVariables >
 				if ( RHS.size() == 0 ) throw SyntaxError( *token, "Thrown by parser: Right hand side of assignment cannot be empty." );
 
 				/*if the LHS is a process, parse this definition as a process definition */
-				if ( LHS[0] -> identify() == "Process" ){
+				if ( LHS[0] -> kind() == TOKEN_PROCESS ){
 
 					/*recurse */
 					parseDefLine( *token, LHS, treeForLine );
@@ -337,18 +337,18 @@ printTree( treeForLine, treeForLine.getRoot() );
 #endif
 				}
 				/*if the LHS is a variable, parse this definition as a variable definition */
-				else if ( LHS[0] -> identify() == "Variable" ){
+				else if ( LHS[0] -> kind() == TOKEN_VARIABLE ){
 
 					/*we need an int literal or double literal on the RHS of the equal sign */
 					if ( RHS.size() != 1 ) throw SyntaxError( *token, "Thrown by parser: Right hand side of variable assignment must be an int literal or double literal." );
 
-					if ( RHS[0] -> identify() == "DoubleLiteral"){
+					if ( RHS[0] -> kind() == TOKEN_DOUBLE_LITERAL){
 
 						Numerical n;
 						n.setDouble(std::stod(RHS[0] -> value()));
 						variableName2Value.updateValue(	LHS[0] -> value(), n );						
 					}
-					else if ( RHS[0] -> identify() == "IntLiteral"){
+					else if ( RHS[0] -> kind() == TOKEN_INT_LITERAL){
 
 						Numerical n;
 						n.setInt(std::stoi(RHS[0] -> value()));
@@ -19,6 +19,7 @@
 #include "lexer.h"
 #include "error_handling.h"
 #include "numerical.h"
+#include "frame.h"
 
 template <class T>
 class Tree {
@@ -164,43 +165,7 @@ class Tree {
 };
 
 
-class GlobalVariables{
-
-	public:
-		std::map< std::string, Numerical > values;
-	
-	GlobalVariables(){}
-	GlobalVariables( const GlobalVariables &pv ){
-
-		values = pv.values;
-	}
-	void updateValue(std::string pName, Numerical value){
-
-		if ( values.count(pName) > 0 ) values.erase(values.find(pName));
-		values[pName] = value;
-	}
-	std::vector<std::string> getNames(){
-		std::vector<std::string> variableNames;
-		for ( auto i = values.begin(); i != values.end(); i++){
-
-			variableNames.push_back( i -> first);
-		}
-		return variableNames;
-	}
-	void printValues(){
-		for ( auto i = values.begin(); i != values.end(); i++){
-
-			if ((i->second).isDouble()){
-
-				std::cout << i -> first << " " << (i -> second).getDouble() << " Double" << std::endl;
-			}
-			else{
-
-				std::cout << i -> first << " " << (i -> second).getInt() << " Int" << std::endl;
-			}
-		}
-	}
-};
+class GlobalVariables : public VariableFrame {};
 
 /*function prototypes */
 std::tuple< std::vector< Tree<Token> >, std::vector<Token *>, GlobalVariables > parseSource( std::vector< std::vector< Token * > > & );
@@ -0,0 +1,111 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <cmath>
+#include <random>
+#include "random.h"
+
+
+RandomStream::RandomStream( uint64_t seed, uint64_t stream ){
+
+	_key[0] = (uint32_t) seed;
+	_key[1] = (uint32_t) (seed >> 32);
+	_stream[0] = (uint32_t) stream;
+	_stream[1] = (uint32_t) (stream >> 32);
+}
+
+
+void RandomStream::refill( void ){
+//encrypt the next batch of counters in one go
+
+	const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+	const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+	for ( unsigned int b = 0; b < _batchBlocks; b++ ){
+
+		uint32_t c[4] = { (uint32_t) _block, (uint32_t) (_block >> 32), _stream[0], _stream[1] };
+		uint32_t k[2] = { _key[0], _key[1] };
+		_block++;
+
+		for ( unsigned int round = 0; round < 10; round++ ){
+
+			uint64_t p0 = (uint64_t) M0 * c[0];
+			uint64_t p1 = (uint64_t) M1 * c[2];
+			uint32_t hi0 = p0 >> 32, lo0 = (uint32_t) p0;
+			uint32_t hi1 = p1 >> 32, lo1 = (uint32_t) p1;
+
+			c[0] = hi1 ^ c[1] ^ k[0];
+			c[1] = lo1;
+			c[2] = hi0 ^ c[3] ^ k[1];
+			c[3] = lo0;
+
+			k[0] += W0;
+			k[1] += W1;
+		}
+
+		for ( unsigned int i = 0; i < 4; i++ ) _buffer[ 4*b + i ] = c[i];
+	}
+	_next = 0;
+}
+
+
+double RandomStream::uniform( void ){
+//53-bit uniform draw on [0,1)
+
+	uint32_t a = nextWord() >> 5;
+	uint32_t b = nextWord() >> 6;
+	return ( a * 67108864.0 + b ) * ( 1.0 / 9007199254740992.0 );
+}
+
+
+double RandomStream::exponential( double rate ){
+
+	return -std::log( 1.0 - uniform() ) / rate;
+}
+
+
+uint64_t RandomStream::poisson( double mean ){
+//inversion for small means, and otherwise Hormann's transformed rejection (PTRS), which takes about one pair of uniforms per draw
+
+	if ( mean <= 0.0 ) return 0;
+	if ( mean < 10.0 ){
+
+		double p = std::exp( -mean ), cumulative = p, u = uniform();
+		uint64_t k = 0;
+		while ( u > cumulative and p > 0.0 ){
+
+			k++;
+			p *= mean / k;
+			cumulative += p;
+		}
+		return k;
+	}
+
+	double slam = std::sqrt( mean ), loglam = std::log( mean );
+	double b = 0.931 + 2.53 * slam;
+	double a = -0.059 + 0.02483 * b;
+	double invalpha = 1.1239 + 1.1328 / ( b - 3.4 );
+	double vr = 0.9277 - 3.6224 / ( b - 2.0 );
+	while ( true ){
+
+		double u = uniform() - 0.5, v = uniform();
+		double us = 0.5 - std::fabs( u );
+		double k = std::floor( ( 2.0 * a / us + b ) * u + mean + 0.43 );
+		if ( us >= 0.07 and v <= vr ) return k;
+		if ( k < 0.0 or ( us < 0.013 and v > us ) ) continue;
+		if ( std::log( v ) + std::log( invalpha ) - std::log( a / ( us * us ) + b ) <= -mean + k * loglam - std::lgamma( k + 1.0 ) ) return k;
+	}
+}
+
+
+uint64_t randomSeed( void ){
+//used when the user doesn't specify a seed
+
+	std::random_device rd;
+	return ( (uint64_t) rd() << 32 ) | rd();
+}
@@ -0,0 +1,41 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+class RandomStream{
+//counter-based Philox4x32-10 generator (Salmon et al., SC 2011) keyed on the user's seed, with the simulation index in the
+//upper half of the counter so that every simulation draws from its own independent stream regardless of which thread runs it
+
+	private:
+		static const unsigned int _batchBlocks = 64;
+		uint32_t _key[2];
+		uint32_t _stream[2];
+		uint64_t _block = 0;
+		uint32_t _buffer[ 4 * _batchBlocks ];
+		unsigned int _next = 4 * _batchBlocks;
+		void refill( void );
+		uint32_t nextWord( void ){
+
+			if ( _next == 4 * _batchBlocks ) refill();
+			return _buffer[ _next++ ];
+		}
+
+	public:
+		RandomStream( uint64_t, uint64_t );
+		double uniform( void );
+		double exponential( double );
+		uint64_t poisson( double );
+};
+
+uint64_t randomSeed( void );
+
+#endif
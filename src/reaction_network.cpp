@@ -0,0 +1,164 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <set>
+#include "reaction_network.h"
+
+
+static bool onlyActions( const CompiledProcess *definition, std::set< const CompiledProcess * > &visited ){
+//whether every block of this definition, and of every definition it calls, can be part of a reaction network
+
+	if ( not visited.insert( definition ).second ) return true;
+
+	for ( unsigned int i = 0; i < definition -> numberOfNodes(); i++ ){
+
+		Block *b = definition -> block( i );
+		switch ( b -> kind() ){
+
+			case BLOCK_MESSAGE_SEND:
+			case BLOCK_MESSAGE_RECEIVE:
+				return false;
+			case BLOCK_PROCESS:
+				if ( not onlyActions( static_cast< ProcessBlock * >( b ) -> getTarget(), visited ) ) return false;
+				break;
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+
+bool isReactionNetwork( std::map< std::string, ProcessDefinition > &name2ProcessDef, std::list< SystemProcess > &system ){
+//beacons and handshakes make a process's transitions depend on other processes, so only models without them reduce to reactions
+
+	std::set< const CompiledProcess * > visited;
+	for ( auto sp = system.begin(); sp != system.end(); sp++ ){
+
+		if ( not onlyActions( sp -> definition, visited ) ) return false;
+	}
+	return true;
+}
+
+
+int ReactionNetwork::findSpecies( const std::string &key ) const {
+
+	auto s = _speciesIndex.find( key );
+	if ( s == _speciesIndex.end() ) return -1;
+	return s -> second;
+}
+
+
+unsigned int ReactionNetwork::addSpecies( const std::string &key, SystemProcess *sp ){
+
+	sp -> count = 0;
+	unsigned int s;
+	if ( _freeSpecies.empty() ){
+
+		s = _species.size();
+		_species.push_back( sp );
+		_reactionsOf.push_back( std::vector< unsigned int >() );
+		_expanded.push_back( false );
+		_madeBy.push_back( 0 );
+		_keys.push_back( key );
+	}
+	else{
+
+		s = _freeSpecies.back();
+		_freeSpecies.pop_back();
+		_species[s] = sp;
+		_keys[s] = key;
+	}
+	_speciesIndex[key] = s;
+	return s;
+}
+
+
+void ReactionNetwork::addReactions( unsigned int s, std::vector< Reaction > &reactions ){
+//the reactions a species can do, which are only worked out once it has copies
+
+	_expanded[s] = true;
+	for ( auto r = reactions.begin(); r < reactions.end(); r++ ){
+
+		//a reaction that makes a copy of its reactant doesn't change its count, and the changes only list species that do change
+		std::map< unsigned int, int > change;
+		change[ r -> reactant ]--;
+		for ( auto p = ( r -> products ).begin(); p < ( r -> products ).end(); p++ ) change[*p]++;
+		for ( auto c = change.begin(); c != change.end(); c++ ){
+
+			if ( c -> second != 0 ) ( r -> changes ).push_back( *c );
+		}
+		for ( auto p = ( r -> products ).begin(); p < ( r -> products ).end(); p++ ){
+
+			if ( *p != s ) _madeBy[*p]++;
+		}
+
+		unsigned int slot;
+		if ( _freeReactions.empty() ){
+
+			slot = _reactions.size();
+			_reactions.push_back( *r );
+		}
+		else{
+
+			slot = _freeReactions.back();
+			_freeReactions.pop_back();
+			_reactions[slot] = *r;
+		}
+		_reactionsOf[s].push_back( slot );
+		_propensities.set( slot, propensity( slot ) );
+	}
+}
+
+
+void ReactionNetwork::changeCount( unsigned int s, int64_t delta ){
+
+	_species[s] -> count += delta;
+	if ( _species[s] -> count == 0 ) _emptied.push_back( s );
+	for ( auto r = _reactionsOf[s].begin(); r < _reactionsOf[s].end(); r++ ) _propensities.set( *r, propensity( *r ) );
+}
+
+
+void ReactionNetwork::freeSpecies( unsigned int s, std::vector< SystemProcess * > &freed ){
+//drop a species and its reactions, which can leave species they made with nothing to make them either
+
+	for ( auto r = _reactionsOf[s].begin(); r < _reactionsOf[s].end(); r++ ){
+
+		Reaction &reaction = _reactions[*r];
+		for ( auto p = reaction.products.begin(); p < reaction.products.end(); p++ ){
+
+			if ( *p == s ) continue;
+			_madeBy[*p]--;
+			if ( _madeBy[*p] == 0 and count( *p ) == 0 ) _emptied.push_back( *p );
+		}
+		_reactions[*r] = Reaction();
+		_reactions[*r].reactant = s;
+		_reactions[*r].rate = 0.0;
+		_propensities.set( *r, 0.0 );
+		_freeReactions.push_back( *r );
+	}
+	_reactionsOf[s].clear();
+	_expanded[s] = false;
+	_speciesIndex.erase( _keys[s] );
+	_keys[s].clear();
+	freed.push_back( _species[s] );
+	_species[s] = NULL;
+	_freeSpecies.push_back( s );
+}
+
+
+void ReactionNetwork::collect( std::vector< SystemProcess * > &freed ){
+//free the species that ran out of copies since the last call and can't be made again, and hand back their processes to be deleted
+
+	while ( not _emptied.empty() ){
+
+		unsigned int s = _emptied.back();
+		_emptied.pop_back();
+		if ( _species[s] != NULL and _species[s] -> count == 0 and _madeBy[s] == 0 ) freeSpecies( s, freed );
+	}
+}
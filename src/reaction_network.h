@@ -0,0 +1,74 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef REACTION_NETWORK_H
+#define REACTION_NETWORK_H
+
+#include <vector>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "blockParser.h"
+#include "scheduler.h"
+
+//a model where processes only ever do actions (no beacons or handshakes) is a chemical reaction network.  each species is a process in
+//some state, in the same sense as --lump: the same node of the same definition with the same parameters and bindings.  each action a
+//species can do is a reaction that turns one copy of it into whatever runs next, so -e crn can keep a count for each species and a
+//propensity for each reaction instead of a system process and candidates for every copy
+bool isReactionNetwork( std::map< std::string, ProcessDefinition > &, std::list< SystemProcess > & );
+
+
+struct Reaction{
+
+	unsigned int reactant;
+	double rate; //for one copy of the reactant, so the propensity is this times its count
+	std::vector< unsigned int > products; //a species once for each copy made
+	std::vector< std::pair< unsigned int, int > > changes; //net change in the count of each species it changes, for leaping
+	std::shared_ptr< Candidate > transition; //the action and parameter values written when it fires
+};
+
+
+class ReactionNetwork{
+//species and their reactions, filled in as the simulation first reaches each species.  a reaction only has one reactant, so firing one
+//only changes the propensities of the reactions of the species it consumed and made, which are updated in a sum tree.  a species with no
+//copies that no reaction of another species makes can't come back, so it's freed along with its reactions and its slots are reused
+
+	private:
+		std::vector< SystemProcess * > _species; //not owned: the system keeps them with its processes, so sampling writes them as usual
+		std::vector< std::vector< unsigned int > > _reactionsOf;
+		std::vector< bool > _expanded;
+		std::vector< unsigned int > _madeBy; //number of products of reactions of other species that are this species
+		std::vector< Reaction > _reactions;
+		std::unordered_map< std::string, unsigned int > _speciesIndex;
+		std::vector< std::string > _keys;
+		std::vector< unsigned int > _freeSpecies, _freeReactions, _emptied;
+		SumTree _propensities;
+		void freeSpecies( unsigned int, std::vector< SystemProcess * > & );
+
+	public:
+		static const unsigned int maxSpecies = 10000; //more than this many reachable species and the model isn't simulated as a network
+		int findSpecies( const std::string & ) const;
+		unsigned int addSpecies( const std::string &, SystemProcess * );
+		unsigned int numberOfSpecies( void ) const { return _species.size(); }
+		SystemProcess *species( unsigned int s ) const { return _species[s]; }
+		unsigned int count( unsigned int s ) const { return _species[s] == NULL ? 0 : _species[s] -> count; }
+		bool isExpanded( unsigned int s ) const { return _expanded[s]; }
+		void addReactions( unsigned int, std::vector< Reaction > & );
+		void changeCount( unsigned int, int64_t );
+		void collect( std::vector< SystemProcess * > & );
+		unsigned int numberOfReactions( void ) const { return _reactions.size(); }
+		const Reaction &reaction( unsigned int r ) const { return _reactions[r]; }
+		double propensity( unsigned int r ) const { return _reactions[r].rate * count( _reactions[r].reactant ); }
+		double totalPropensity( void ) const { return _propensities.total(); }
+		unsigned int pick( double target ) const { return _propensities.find( target ); }
+};
+
+#endif
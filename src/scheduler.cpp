@@ -0,0 +1,259 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <cassert>
+#include <algorithm>
+#include "scheduler.h"
+#include "handshake.h"
+
+
+/*INDEXED HEAP-------------------------------------------------------------------------------------------------------------------------------------------------------*/
+void IndexedHeap::swapNodes( unsigned int i, unsigned int j ){
+
+	std::swap( _heap[i], _heap[j] );
+	_position[ _heap[i].second ] = i;
+	_position[ _heap[j].second ] = j;
+}
+
+
+void IndexedHeap::siftUp( unsigned int i ){
+
+	while ( i > 0 ){
+
+		unsigned int parent = (i - 1) / 2;
+		if ( _heap[parent].first <= _heap[i].first ) break;
+		swapNodes( i, parent );
+		i = parent;
+	}
+}
+
+
+void IndexedHeap::siftDown( unsigned int i ){
+
+	while ( true ){
+
+		unsigned int smallest = i;
+		unsigned int left = 2*i + 1;
+		unsigned int right = 2*i + 2;
+		if ( left < _heap.size() and _heap[left].first < _heap[smallest].first ) smallest = left;
+		if ( right < _heap.size() and _heap[right].first < _heap[smallest].first ) smallest = right;
+		if ( smallest == i ) break;
+		swapNodes( i, smallest );
+		i = smallest;
+	}
+}
+
+
+void IndexedHeap::push( unsigned int slot, double time ){
+
+	if ( slot >= _position.size() ) _position.resize( slot + 1, -1 );
+	assert( _position[slot] == -1 );
+
+	_heap.push_back( std::make_pair( time, slot ) );
+	_position[slot] = _heap.size() - 1;
+	siftUp( _heap.size() - 1 );
+}
+
+
+void IndexedHeap::erase( unsigned int slot ){
+
+	assert( slot < _position.size() and _position[slot] != -1 );
+
+	unsigned int i = _position[slot];
+	unsigned int last = _heap.size() - 1;
+	if ( i != last ){
+
+		swapNodes( i, last );
+		_heap.pop_back();
+		siftUp( i );
+		siftDown( i );
+	}
+	else _heap.pop_back();
+	_position[slot] = -1;
+}
+
+
+/*SUM TREE-----------------------------------------------------------------------------------------------------------------------------------------------------------*/
+void SumTree::grow( unsigned int minCapacity ){
+
+	unsigned int newCapacity = std::max( _capacity, (unsigned int) 1 );
+	while ( newCapacity < minCapacity ) newCapacity *= 2;
+
+	//copy the leaves over and rebuild the internal nodes
+	std::vector< double > newTree( 2 * newCapacity, 0.0 );
+	for ( unsigned int i = 0; i < _capacity; i++ ) newTree[ newCapacity + i ] = _tree[ _capacity + i ];
+	for ( unsigned int i = newCapacity - 1; i > 0; i-- ) newTree[i] = newTree[2*i] + newTree[2*i + 1];
+
+	_tree.swap( newTree );
+	_capacity = newCapacity;
+}
+
+
+void SumTree::set( unsigned int slot, double rate ){
+
+	if ( slot >= _capacity ) grow( slot + 1 );
+
+	//recompute the sums on the path to the root from scratch so that no error accumulates
+	unsigned int i = _capacity + slot;
+	_tree[i] = rate;
+	for ( i /= 2; i > 0; i /= 2 ) _tree[i] = _tree[2*i] + _tree[2*i + 1];
+}
+
+
+unsigned int SumTree::find( double target ) const {
+//return the slot whose cumulative rate interval contains target, where 0 <= target < total()
+
+	assert( _capacity > 0 and _tree[1] > 0.0 );
+
+	unsigned int i = 1;
+	while ( i < _capacity ){
+
+		double left = _tree[2*i];
+
+		//never walk into an empty subtree, which can otherwise happen when target is rounded up to the boundary
+		if ( ( target < left or _tree[2*i + 1] <= 0.0 ) and left > 0.0 ) i = 2*i;
+		else{
+
+			target -= left;
+			i = 2*i + 1;
+		}
+	}
+	return i - _capacity;
+}
+
+
+/*TRANSITION SCHEDULER-----------------------------------------------------------------------------------------------------------------------------------------------*/
+TransitionScheduler::TransitionScheduler( int engine, double fastRate, RandomStream &rng ) : _rng( rng ){
+
+	_engine = engine;
+	_fastRate = fastRate;
+}
+
+
+unsigned int TransitionScheduler::claimSlot( ScheduledTransition &st, double rate ){
+
+	unsigned int slot;
+	if ( _freeSlots.empty() ){
+
+		slot = _slots.size();
+		_slots.push_back( st );
+	}
+	else{
+
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		_slots[slot] = st;
+	}
+
+	_candidatesLeft++;
+
+	//fast transitions are kept apart, and have no firing time of their own since they share one clock at the sum of their rates
+	if ( st.fast ){
+
+		_fastLeft++;
+		_fastRates.set( slot, rate );
+		return slot;
+	}
+	_rates.set( slot, rate );
+
+	//next reaction method: each candidate keeps its own absolute firing time until it is removed
+	if ( _engine == ENGINE_NRM ) _firingTimes.push( slot, _currentTime + _rng.exponential( rate ) );
+	return slot;
+}
+
+
+void TransitionScheduler::releaseSlot( int slot ){
+
+	assert( slot >= 0 and (unsigned int) slot < _slots.size() );
+
+	if ( _slots[slot].fast ){
+
+		_fastLeft--;
+		_fastRates.set( slot, 0.0 );
+	}
+	else{
+
+		if ( _engine == ENGINE_NRM ) _firingTimes.erase( slot );
+		_rates.set( slot, 0.0 );
+	}
+
+	_slots[slot] = ScheduledTransition();
+	_freeSlots.push_back( slot );
+	_candidatesLeft--;
+}
+
+
+void TransitionScheduler::add( std::shared_ptr<Candidate> cand, BeaconChannel *channel ){
+
+	assert( cand -> slot == -1 );
+	ScheduledTransition st;
+	st.candidate = cand;
+	st.beaconChannel = channel;
+
+	//with --lump, the rate is for every copy of the process, but whether a transition is fast only depends on the rate of one
+	st.fast = cand -> rate / ( cand -> processInSystem ) -> count >= _fastRate;
+	cand -> slot = claimSlot( st, cand -> rate );
+}
+
+
+void TransitionScheduler::add( std::shared_ptr<HandshakeCandidate> hsCand ){
+
+	assert( hsCand -> slot == -1 );
+	ScheduledTransition st;
+	st.handshake = hsCand;
+
+	//the rate for one pair of copies, as for other candidates.  a process can't handshake with itself, so a single copy has no pairs
+	const SystemProcess *sender = ( hsCand -> hsSendCand ) -> processInSystem, *receiver = ( hsCand -> hsReceiveCand ) -> processInSystem;
+	double pairs = (double) sender -> count * ( (double) receiver -> count - ( sender == receiver ? 1.0 : 0.0 ) );
+	st.fast = pairs > 0.0 and hsCand -> rate / pairs >= _fastRate;
+	hsCand -> slot = claimSlot( st, hsCand -> rate );
+}
+
+
+void TransitionScheduler::remove( Candidate &cand ){
+
+	int slot = cand.slot;
+	cand.slot = -1;
+	releaseSlot( slot );
+}
+
+
+void TransitionScheduler::remove( HandshakeCandidate &hsCand ){
+
+	int slot = hsCand.slot;
+	hsCand.slot = -1;
+	releaseSlot( slot );
+}
+
+
+ScheduledTransition TransitionScheduler::nextReaction( double &time ){
+//next reaction method: the candidate with the earliest firing time goes next
+
+	assert( _engine == ENGINE_NRM );
+	assert( not _firingTimes.empty() );
+
+	time = _firingTimes.topTime();
+	_currentTime = time;
+	return _slots[ _firingTimes.topSlot() ];
+}
+
+
+ScheduledTransition TransitionScheduler::pickDirect( double uniformDraw ){
+//direct method: pick a candidate with probability proportional to its rate, where uniformDraw is in [0,1)
+
+	assert( _candidatesLeft > 0 );
+	return _slots[ _rates.find( uniformDraw * _rates.total() ) ];
+}
+
+
+ScheduledTransition TransitionScheduler::pickFast( double uniformDraw ){
+//pick a fast candidate with probability proportional to its rate, where uniformDraw is in [0,1).  the time it fires at is up to the caller
+
+	assert( fastPending() );
+	return _slots[ _fastRates.find( uniformDraw * _fastRates.total() ) ];
+}
@@ -0,0 +1,104 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include "blockParser.h"
+#include "random.h"
+
+class HandshakeCandidate;
+class BeaconChannel;
+
+enum SimulationEngine { ENGINE_DIRECT, ENGINE_NRM, ENGINE_CRN, ENGINE_TAU };
+
+
+class IndexedHeap{
+//binary min-heap on firing times, with an index from slot to heap position so that any slot can be removed in O(log n)
+
+	private:
+		std::vector< std::pair< double, unsigned int > > _heap;
+		std::vector< int > _position;
+		void swapNodes( unsigned int, unsigned int );
+		void siftUp( unsigned int );
+		void siftDown( unsigned int );
+
+	public:
+		void push( unsigned int, double );
+		void erase( unsigned int );
+		bool empty( void ) const { return _heap.empty(); }
+		unsigned int topSlot( void ) const { return _heap[0].second; }
+		double topTime( void ) const { return _heap[0].first; }
+};
+
+
+class SumTree{
+//complete binary tree over slot rates where each internal node holds the sum of its children, so the total rate is exact at the root
+//and picking a slot in proportion to its rate is a single descent from the root
+
+	private:
+		std::vector< double > _tree;
+		unsigned int _capacity = 0;
+		void grow( unsigned int );
+
+	public:
+		void set( unsigned int, double );
+		unsigned int find( double ) const;
+		double total( void ) const { return _capacity == 0 ? 0.0 : _tree[1]; }
+};
+
+
+class ScheduledTransition{
+//what a slot in the scheduler points to: a non-messaging candidate, a beacon candidate on a channel, or a handshake
+
+	public:
+		std::shared_ptr<Candidate> candidate;
+		std::shared_ptr<HandshakeCandidate> handshake;
+		BeaconChannel *beaconChannel = NULL;
+		bool fast = false;
+};
+
+
+class TransitionScheduler{
+//every candidate that can fire is registered here, and the engine decides which one fires next
+
+	private:
+		int _engine;
+		double _fastRate; //transitions at this rate per copy or faster are kept apart from the slower ones and written in chains
+		int _candidatesLeft = 0, _fastLeft = 0;
+		double _currentTime = 0.0;
+		std::vector< ScheduledTransition > _slots;
+		std::vector< unsigned int > _freeSlots;
+		SumTree _rates, _fastRates;
+		IndexedHeap _firingTimes;
+		RandomStream &_rng;
+		unsigned int claimSlot( ScheduledTransition &, double );
+		void releaseSlot( int );
+
+	public:
+		TransitionScheduler( int, double, RandomStream & );
+		void add( std::shared_ptr<Candidate>, BeaconChannel * );
+		void add( std::shared_ptr<HandshakeCandidate> );
+		void remove( Candidate & );
+		void remove( HandshakeCandidate & );
+		ScheduledTransition nextReaction( double & );
+		ScheduledTransition pickDirect( double );
+		ScheduledTransition pickFast( double );
+		bool fastPending( void ) const { return _fastRates.total() > 0.0; }
+		double fastRateSum( void ) const { return _fastRates.total(); }
+		int fastLeft( void ) const { return _fastLeft; }
+		void advanceTo( double time ){ _currentTime = time; }
+		double nextSlowTime( void ) const { return _firingTimes.empty() ? std::numeric_limits< double >::infinity() : _firingTimes.topTime(); }
+		int candidatesLeft( void ) const { return _candidatesLeft; }
+		double rateSum( void ) const { return _rates.total(); }
+};
+
+#endif
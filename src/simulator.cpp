@@ -12,19 +12,24 @@
 #include <cassert>
 #include <fstream>
 #include <sstream>
-#include <random>
 #include <algorithm>
+#include <cmath>
 #include "blockParser.h"
 #include "error_handling.h"
 #include "simulator.h"
 #include "evaluate_trees.h"
 
-System::System( std::list< SystemProcess > &s, std::map< std::string, ProcessDefinition > &processDefs, int mT, double mD, GlobalVariables &globalVars ){
+System::System( std::list< SystemProcess > &s, const SimulationOptions &options, GlobalVariables &globalVars, uint64_t seed, uint64_t simulationIndex, std::streambuf *output, const BinaryDictionary *binary, SummaryAccumulator *summary ) : _rng( seed, simulationIndex ), _scheduler( options.engine, options.fastRate, _rng ), _outputStream( output ), _binary( binary ), _summary( summary ){
 
-	_name2ProcessDef = processDefs;
-	_maxTransitions = mT;
-	_maxDuration = mD;
+	_maxTransitions = options.maxTransitions;
+	_maxDuration = options.maxDuration;
+	_sampleEvery = options.sampleEvery;
+	_engine = options.engine;
+	_lump = options.lump;
+	_tauEpsilon = options.tauEpsilon;
 	_globalVars = globalVars;
+	_constantBeaconChannels.resize( ChannelNames::count(), NULL );
+	_constantHandshakeChannels.resize( ChannelNames::count(), NULL );
 
 	for ( auto i = s.begin(); i != s.end(); i++ ){
 
@@ -36,40 +41,91 @@ System::System( std::list< SystemProcess > &s, std::map< std::string, ProcessDef
 	for ( auto sp = _currentProcesses.begin(); sp != _currentProcesses.end(); sp++ ){
 
 		//see if we can make multiple system processes out of this one by splitting on parallel operators
-		if ( ((*sp) -> parseTree).getRoot() -> identify() == "Parallel" ){
+		if ( (*sp) -> currentBlock() -> kind() == BLOCK_PARALLEL ){
 
-			splitOnParallel( *sp, ((*sp) -> parseTree).getRoot(), newProcesses );
+			splitOnParallel( *sp, (*sp) -> node, newProcesses );
 			delete *sp;
 			sp = _currentProcesses.erase( sp );
 		}
 	}
 	_currentProcesses.insert( _currentProcesses.end(), newProcesses.begin(), newProcesses.end() );
 
+	//a reaction network starts with a count for each species on the system line, and only works out the reactions of those it has
+	if ( _engine == ENGINE_CRN or _engine == ENGINE_TAU ){
+
+		_network.reset( new ReactionNetwork() );
+		std::list< SystemProcess * > initial;
+		initial.swap( _currentProcesses );
+		std::vector< unsigned int > copies;
+		toSpecies( initial, copies );
+		for ( auto s = copies.begin(); s < copies.end(); s++ ){
+
+			if ( not _network -> isExpanded( *s ) ) expandSpecies( *s );
+			_network -> changeCount( *s, 1 );
+		}
+		return;
+	}
+	if ( _lump ) lumpProcesses( _currentProcesses );
+
 	//sum the transition rates for non-handshake candidates while buildling a list of handshake candidates
-	std::list< SystemProcess > parallelProcesses;
+	std::shared_ptr< const ParallelContinuation > noContinuations;
 	for ( auto s = _currentProcesses.begin(); s != _currentProcesses.end(); s++ ){
 
-		sumTransitionRates( *s, (*s) -> parseTree, ((*s) -> parseTree).getRoot(), parallelProcesses, (*s) -> parameterValues );
+		(*s) -> id = _nextProcessId++;
+		(*s) -> position = s;
+		sumTransitionRates( *s, (*s) -> definition, (*s) -> node, noContinuations, (*s) -> parameterValues );
 	}
 
 	//sum handshake transitions
-	for ( auto chan = _handshakes_Name2Channel.begin(); chan != _handshakes_Name2Channel.end(); chan++ ){
+	updateHandshakes();
+}
+
+
+BeaconChannel *System::beaconChannel( int constantChannel, const std::vector< Bytecode > &channelExpressions, ParameterValues &currentParameters, VariableFrame &localVariables ){
+//get the beacon channel a block uses, opening it if it doesn't exist yet
+
+	if ( constantChannel >= 0 and _constantBeaconChannels[constantChannel] != NULL ) return _constantBeaconChannels[constantChannel];
+
+	const ChannelKey &key = ( constantChannel >= 0 ) ? ChannelNames::key( constantChannel ) : channelKey( channelExpressions, currentParameters, localVariables );
+	std::shared_ptr< BeaconChannel > &chan = _beaconChannels[key];
+	if ( chan == NULL ) chan.reset( new BeaconChannel( ChannelNames::spell( key ), _globalVars ) );
+
+	if ( constantChannel >= 0 ) _constantBeaconChannels[constantChannel] = chan.get();
+	return chan.get();
+}
+
 
-		int newHandshakesAdded;
-		double rateSumIncrease;
-		std::tie(newHandshakesAdded,rateSumIncrease) = (chan -> second) -> updateHandshakeCandidates();
-		_candidatesLeft += newHandshakesAdded;
-		_rateSum += rateSumIncrease;
+HandshakeChannel *System::handshakeChannel( int constantChannel, const std::vector< Bytecode > &channelExpressions, ParameterValues &currentParameters, VariableFrame &localVariables ){
+//get the handshake channel a block uses, opening it if it doesn't exist yet
+
+	if ( constantChannel >= 0 and _constantHandshakeChannels[constantChannel] != NULL ) return _constantHandshakeChannels[constantChannel];
+
+	const ChannelKey &key = ( constantChannel >= 0 ) ? ChannelNames::key( constantChannel ) : channelKey( channelExpressions, currentParameters, localVariables );
+	std::shared_ptr< HandshakeChannel > &chan = _handshakeChannels[key];
+	if ( chan == NULL ) chan.reset( new HandshakeChannel( ChannelNames::spell( key ), _globalVars ) );
+
+	if ( constantChannel >= 0 ) _constantHandshakeChannels[constantChannel] = chan.get();
+	return chan.get();
+}
+
+
+void System::updateHandshakes( void ){
+//match up the handshake sends and receives added since the last update, which only happens on channels that had candidates added to them
+
+	for ( auto chan = _handshakesToUpdate.begin(); chan != _handshakesToUpdate.end(); chan++ ){
+
+		(*chan) -> updateHandshakeCandidates( _scheduler );
 	}
+	_handshakesToUpdate.clear();
 }
 
 
-std::string System::writeChannelName( std::vector< std::vector< Token * > > channelName ){
+std::string System::writeChannelName( const std::vector< Bytecode > &channelName ){
 
 	std::string out;
 	for ( auto i = channelName.begin(); i < channelName.end(); i++ ){ //for each comma-separated value
 
-		for ( auto j = (*i).begin(); j < (*i).end(); j++ ){ //for each token in that value
+		for ( auto j = i -> rpn().begin(); j < i -> rpn().end(); j++ ){ //for each token in that value
 
 			out += (*j) -> value();
 		}
@@ -79,256 +135,317 @@ std::string System::writeChannelName( std::vector< std::vector< Token * > > chan
 }
 
 
-void System::writeTransition( double time, std::shared_ptr<Candidate> chosen, std::stringstream &ss ){
+void System::writeTransition( double time, std::shared_ptr<Candidate> chosen, std::ostream &ss ){
+
+	if ( _sampleEvery > 0.0 ) return;
 
 	Block *actionDone = chosen -> actionCandidate;
-	std::vector< std::string > parameterNames = _name2ProcessDef[ actionDone -> getOwningProcess()].parameters;
 
-	if ( actionDone -> identify() == "Action" ){
+	//a chain of fast transitions is written as one transition when it's done
+	if ( _inFastChain ){
 
-		ActionBlock *ab = static_cast< ActionBlock * >( actionDone );
-		ss << time << '\t' << ab -> actionName << '\t' << actionDone -> getOwningProcess();
+		_chainOutcome = chosen;
+		return;
 	}
-	else if ( actionDone -> identify() == "MessageSend" ){
+	if ( _summary != NULL ){
 
-		MessageSendBlock *msb = static_cast< MessageSendBlock * >( actionDone );
-		ss << time << '\t' << writeChannelName(msb -> getChannelName()) << '\t' << actionDone -> getOwningProcess();
+		_summary -> record( time, actionDone, chosen -> parameterValues );
+		return;
 	}
-	else if ( actionDone -> identify() == "MessageReceive" ){
+	if ( not actionDone -> isRecorded() ) return;
+	if ( _binary != NULL ){
 
-		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( actionDone );
-		ss << time << '\t' << writeChannelName(mrb -> getChannelName())  << '\t' << actionDone -> getOwningProcess();
+		_binary -> writeRecord( ss, time, _lastTimeWritten, actionDone, chosen -> parameterValues );
+		return;
 	}
 
-	for ( auto p = parameterNames.begin(); p < parameterNames.end(); p++ ){
+	const CompiledProcess &pd = *( actionDone -> getDefinition() );
+
+	switch ( actionDone -> kind() ){
+
+		case BLOCK_ACTION:
+			ss << time << '\t' << static_cast< ActionBlock * >( actionDone ) -> actionName << '\t' << actionDone -> getOwningProcess();
+			break;
+		case BLOCK_MESSAGE_SEND:
+			ss << time << '\t' << writeChannelName( static_cast< MessageSendBlock * >( actionDone ) -> getChannelName() ) << '\t' << actionDone -> getOwningProcess();
+			break;
+		case BLOCK_MESSAGE_RECEIVE:
+			ss << time << '\t' << writeChannelName( static_cast< MessageReceiveBlock * >( actionDone ) -> getChannelName() ) << '\t' << actionDone -> getOwningProcess();
+			break;
+		default:
+			assert( false );
+	}
 
-		if ( (chosen -> parameterValues).values.count(*p) > 0 ){
+	for ( unsigned int i = 0; i < pd.parameters.size(); i++ ){
+
+		if ( (chosen -> parameterValues).isDefined( pd.parameterSlots[i] ) ){
 	
-			Numerical val = (chosen -> parameterValues).values[*p];
+			Numerical val = (chosen -> parameterValues).getValue( pd.parameterSlots[i] );
 
-			if (val.isInt()) ss << '\t' << *p << '\t' << val.getInt();
-			else ss << '\t' << *p << '\t' << val.getDouble();
+			if (val.isInt()) ss << '\t' << pd.parameters[i] << '\t' << val.getInt();
+			else ss << '\t' << pd.parameters[i] << '\t' << val.getDouble();
 		}
 	}
 	ss << std::endl;
 }
 
 
-//for debugging
-void System::printTransition(double time, std::shared_ptr<Candidate> chosen){
+void System::writeSamples( double time ){
+//write the state of every process at each sample time before this one that hasn't been written yet.  this is called before a transition
+//at this time changes anything, so the state at a sample time includes every transition at or before it
 
-	Block *actionDone = chosen -> actionCandidate;
-	std::vector< std::string > parameterNames = _name2ProcessDef[ actionDone -> getOwningProcess()].parameters;
+	while ( true ){
 
-	if ( actionDone -> identify() == "Action" ){
+		double sampleTime = _nextSample * _sampleEvery;
+		if ( sampleTime >= time or sampleTime > _maxDuration ) break;
 
-		ActionBlock *ab = static_cast< ActionBlock * >( actionDone );
-		std::cout << time << '\t' << ab -> actionName << '\t' << actionDone -> getOwningProcess();
-	}
-	else if ( actionDone -> identify() == "MessageSend" ){
+		for ( auto sp = _currentProcesses.begin(); sp != _currentProcesses.end(); sp++ ){
+
+			//a lumped process is written once for each copy it stands for
+			for ( unsigned int copy = 0; copy < (*sp) -> count; copy++ ){
+
+				//a process waiting at a call is in the state of the process it calls, whose parameters were filled in when its rates were summed
+				const CompiledProcess *definition = (*sp) -> definition;
+				Block *b = (*sp) -> currentBlock();
+				while ( b -> kind() == BLOCK_PROCESS ){
+
+					definition = static_cast< ProcessBlock * >( b ) -> getTarget();
+					b = definition -> block( 0 );
+				}
+
+				_outputStream << sampleTime << '\t';
+				switch ( b -> kind() ){
+
+					case BLOCK_ACTION:
+						_outputStream << static_cast< ActionBlock * >( b ) -> actionName;
+						break;
+					case BLOCK_MESSAGE_SEND:
+						_outputStream << writeChannelName( static_cast< MessageSendBlock * >( b ) -> getChannelName() );
+						break;
+					case BLOCK_MESSAGE_RECEIVE:
+						_outputStream << writeChannelName( static_cast< MessageReceiveBlock * >( b ) -> getChannelName() );
+						break;
+					default:
+						_outputStream << b -> identify();
+				}
+				_outputStream << '\t' << b -> getOwningProcess();
+
+				const CompiledProcess &pd = *definition;
+				for ( unsigned int i = 0; i < pd.parameters.size(); i++ ){
+
+					if ( ( (*sp) -> parameterValues ).isDefined( pd.parameterSlots[i] ) ){
 
-		MessageSendBlock *msb = static_cast< MessageSendBlock * >( actionDone );
-		std::cout << time << '\t' << writeChannelName(msb -> getChannelName()) << '\t' << actionDone -> getOwningProcess();
+						Numerical val = ( (*sp) -> parameterValues ).getValue( pd.parameterSlots[i] );
+
+						if (val.isInt()) _outputStream << '\t' << pd.parameters[i] << '\t' << val.getInt();
+						else _outputStream << '\t' << pd.parameters[i] << '\t' << val.getDouble();
+					}
+				}
+				_outputStream << std::endl;
+			}
+		}
+		_nextSample++;
 	}
-	else if ( actionDone -> identify() == "MessageReceive" ){
+}
+
 
-		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( actionDone );
-		std::cout << time << '\t' << writeChannelName(mrb -> getChannelName())  << '\t' << actionDone -> getOwningProcess();
+//for debugging
+void System::printTransition(double time, std::shared_ptr<Candidate> chosen){
+
+	Block *actionDone = chosen -> actionCandidate;
+	const CompiledProcess &pd = *( actionDone -> getDefinition() );
+
+	switch ( actionDone -> kind() ){
+
+		case BLOCK_ACTION:
+			std::cout << time << '\t' << static_cast< ActionBlock * >( actionDone ) -> actionName << '\t' << actionDone -> getOwningProcess();
+			break;
+		case BLOCK_MESSAGE_SEND:
+			std::cout << time << '\t' << writeChannelName( static_cast< MessageSendBlock * >( actionDone ) -> getChannelName() ) << '\t' << actionDone -> getOwningProcess();
+			break;
+		case BLOCK_MESSAGE_RECEIVE:
+			std::cout << time << '\t' << writeChannelName( static_cast< MessageReceiveBlock * >( actionDone ) -> getChannelName() ) << '\t' << actionDone -> getOwningProcess();
+			break;
+		default:
+			assert( false );
 	}
 
-	for ( auto p = parameterNames.begin(); p < parameterNames.end(); p++ ){
+	for ( unsigned int i = 0; i < pd.parameters.size(); i++ ){
 
-		if ( (chosen -> parameterValues).values.count(*p) > 0 ){
+		if ( (chosen -> parameterValues).isDefined( pd.parameterSlots[i] ) ){
 	
-			Numerical val = (chosen -> parameterValues).values[*p];
+			Numerical val = (chosen -> parameterValues).getValue( pd.parameterSlots[i] );
 
-			if (val.isInt()) std::cout << '\t' << *p << '\t' << val.getInt();
-			else std::cout << '\t' << *p << '\t' << val.getDouble();
+			if (val.isInt()) std::cout << '\t' << pd.parameters[i] << '\t' << val.getInt();
+			else std::cout << '\t' << pd.parameters[i] << '\t' << val.getDouble();
 		}
 	}
 	std::cout << std::endl;
 }
 
 
-bool System::variableIsDefined(std::string varName, ParameterValues &currentParameters, std::map< std::string, Numerical > &localVariables){
+bool System::variableIsDefined(unsigned int slot, ParameterValues &currentParameters, VariableFrame &localVariables){
 
-	bool inGlobal =  _globalVars.values.count(varName) > 0;
-	bool inParams =  currentParameters.values.count(varName) > 0;
-	bool inLocal = localVariables.count(varName) > 0;
+	bool inGlobal =  _globalVars.isDefined(slot);
+	bool inParams =  currentParameters.isDefined(slot);
+	bool inLocal = localVariables.isDefined(slot);
 	if (not inGlobal and not inParams and not inLocal) return false;
 	else return true;
 }
 
 
-std::vector< std::string > System::substituteChannelName( std::vector< std::vector< Token * > > channelExpressions, ParameterValues &currentParameters, std::map< std::string, Numerical > &localVariables ){
-
-	std::vector< std::string > channelName;
+const ChannelKey &System::channelKey( const std::vector< Bytecode > &channelExpressions, ParameterValues &currentParameters, VariableFrame &localVariables ){
+//work out a channel name that depends on parameters or bindings.  a variable with no value is part of the name as it's written
 
+	_channelKey.clear();
 	for (auto exp = channelExpressions.begin(); exp < channelExpressions.end(); exp++ ){
 
-		if ( (*exp).size() == 1 and (*exp)[0] -> identify() == "Variable" and not variableIsDefined( (*exp)[0] -> value(), currentParameters, localVariables) ){
+		const std::vector< Instruction > &code = exp -> code();
+		if ( code.size() == 1 and code[0].op == OP_LOAD_VARIABLE and not variableIsDefined( code[0].operand, currentParameters, localVariables) ){
 
-			channelName.push_back( (*exp)[0] -> value() );
+			_channelKey.push_back( CHANNEL_NAME );
+			_channelKey.push_back( code[0].operand );
 		}
 
 		else{ //this is an expression or variable that should be substituted
 		
 			Numerical evalIdx = evalRPN_numerical(*exp, currentParameters, _globalVars, localVariables);
-			if (evalIdx.isDouble()) throw WrongType((*exp)[0], "Channel name expressions must evaluate to ints, not doubles (either through explicit or implicit casting).");
-			channelName.push_back( std::to_string(evalIdx.getInt()) );
+			if (evalIdx.isDouble()) throw WrongType(exp -> rpn()[0], "Channel name expressions must evaluate to ints, not doubles (either through explicit or implicit casting).");
+			_channelKey.push_back( CHANNEL_INDEX );
+			_channelKey.push_back( evalIdx.getInt() );
 		}
 	}
-	return channelName;
+	return _channelKey;
 }
 
 
 void System::sumTransitionRates( SystemProcess *sp,
-			 Tree<Block> &bt,
-			 Block *current,
-			 std::list< SystemProcess > parallelProcesses,
+			 const CompiledProcess *definition,
+			 unsigned int node,
+			 const std::shared_ptr< const ParallelContinuation > &parallelContinuations,
 			 ParameterValues &currentParameters ){
 
-	if ( current -> identify() == "Action" ){
-
-		Numerical rate = evalRPN_numerical( current -> getRate(), currentParameters, _globalVars, sp -> localVariables );
-		if ( rate.doubleCast() <= 0 ) throw BadRate( current -> getToken() );
-		std::shared_ptr<Candidate> cand( new Candidate( current, currentParameters, sp -> localVariables, sp, parallelProcesses ) );
-		cand -> rate = rate.doubleCast();
-		_nonMsgCandidates[sp].push_back( cand );
-		_candidatesLeft++;
-		_rateSum += rate.doubleCast();
-	}
-	else if ( current -> identify() == "MessageSend" ){
-
-		MessageSendBlock *msb = static_cast< MessageSendBlock * >( current );
-		std::vector< std::string > channelName = substituteChannelName( msb -> getChannelName(), currentParameters, sp -> localVariables );
+	Block *current = definition -> block( node );
+	switch ( current -> kind() ){
 
-		if ( msb -> isHandshake() ){
+		case BLOCK_ACTION:{
 
-			Numerical rate = evalRPN_numerical( msb -> getRate(), currentParameters, _globalVars, sp -> localVariables );
+			Numerical rate = evalRPN_numerical( current -> getRate(), currentParameters, _globalVars, sp -> localVariables );
 			if ( rate.doubleCast() <= 0 ) throw BadRate( current -> getToken() );
+			std::shared_ptr<Candidate> cand( new Candidate( current, currentParameters, sp -> localVariables, sp, parallelContinuations ) );
+			if ( _network != NULL ){
 
-			std::shared_ptr< Candidate > cand( new Candidate( msb, currentParameters, sp -> localVariables, sp, parallelProcesses) );
-
-			cand -> rate = rate.doubleCast();
-
-			//evaluate each parameter expression
-			std::vector< std::vector< Token * > > parameterExpressions = msb -> getParameterExpression();
-			for ( auto exp = parameterExpressions.begin(); exp < parameterExpressions.end(); exp++ ){
-
-				Numerical paramEval = evalRPN_numerical( *exp, currentParameters, _globalVars, sp -> localVariables );
-				(cand -> rangeEvaluation).push_back(paramEval);
-			}
-
-			if ( _handshakes_Name2Channel.find( channelName ) != _handshakes_Name2Channel.end() ){
-
-				_handshakes_Name2Channel[channelName] -> addSendCandidate(cand);
-			}
-			else{
-				std::shared_ptr< HandshakeChannel > newChannel(new HandshakeChannel(channelName, _globalVars));
-				_handshakes_Name2Channel[channelName] = newChannel;
-				_handshakes_Name2Channel[channelName] -> addSendCandidate(cand);
+				//a species keeps the rate for one copy, and the network multiplies it by the count
+				cand -> rate = rate.doubleCast();
+				_speciesActions.push_back( cand );
+				break;
 			}
+			cand -> rate = rate.doubleCast() * sp -> count;
+			_nonMsgCandidates[sp].push_back( cand );
+			_scheduler.add( cand, NULL );
+			break;
 		}
-		else{//beacon launch or kill
+		case BLOCK_MESSAGE_SEND:{
 
-			if ( _beacons_Name2Channel.find( channelName ) != _beacons_Name2Channel.end() ){
+			MessageSendBlock *msb = static_cast< MessageSendBlock * >( current );
+			if ( msb -> isHandshake() ){
 
-				_beacons_Name2Channel[channelName] -> addCandidate( current, sp, parallelProcesses, currentParameters, _candidatesLeft, _rateSum );
-			}
-			else{
-				std::shared_ptr< BeaconChannel > newChannel( new BeaconChannel(channelName, _globalVars) );
-				_beacons_Name2Channel[channelName] = newChannel;
-				_beacons_Name2Channel[channelName] -> addCandidate( current, sp, parallelProcesses, currentParameters, _candidatesLeft, _rateSum );
-			}
-		}
-	}
-	else if ( current -> identify() == "MessageReceive" ){
+				HandshakeChannel *channel = handshakeChannel( msb -> getConstantChannel(), msb -> getChannelName(), currentParameters, sp -> localVariables );
+				Numerical rate = evalRPN_numerical( msb -> getRate(), currentParameters, _globalVars, sp -> localVariables );
+				if ( rate.doubleCast() <= 0 ) throw BadRate( current -> getToken() );
 
-		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( current );
-		std::vector< std::string > channelName = substituteChannelName( mrb -> getChannelName(), currentParameters, sp -> localVariables );
+				std::shared_ptr< Candidate > cand( new Candidate( msb, currentParameters, sp -> localVariables, sp, parallelContinuations) );
 
-		if ( mrb -> isHandshake() ){
+				cand -> rate = rate.doubleCast() * sp -> count;
 
-			std::shared_ptr< Candidate > cand( new Candidate( mrb, currentParameters, sp -> localVariables, sp, parallelProcesses) );
+				//evaluate each parameter expression
+				const std::vector< Bytecode > &parameterExpressions = msb -> getParameterExpression();
+				for ( auto exp = parameterExpressions.begin(); exp < parameterExpressions.end(); exp++ ){
 
-			if ( _handshakes_Name2Channel.find( channelName ) != _handshakes_Name2Channel.end() ){
+					Numerical paramEval = evalRPN_numerical( *exp, currentParameters, _globalVars, sp -> localVariables );
+					(cand -> rangeEvaluation).push_back(paramEval);
+				}
 
-				_handshakes_Name2Channel[channelName] -> addReceiveCandidate(cand);
+				channel -> addSendCandidate( cand );
+				_sp2HandshakeChannels[sp].insert( channel );
+				_handshakesToUpdate.insert( channel );
 			}
-			else{
-				std::shared_ptr< HandshakeChannel > newChannel( new HandshakeChannel(channelName, _globalVars) );
-				_handshakes_Name2Channel[channelName] = newChannel;
-				_handshakes_Name2Channel[channelName] -> addReceiveCandidate(cand);
+			else{//beacon launch or kill
+
+				BeaconChannel *channel = beaconChannel( msb -> getConstantChannel(), msb -> getChannelName(), currentParameters, sp -> localVariables );
+				channel -> addCandidate( current, sp, parallelContinuations, currentParameters, _scheduler );
+				_sp2BeaconChannels[sp].insert( channel );
 			}
+			break;
 		}
-		else{//beacon receive or beacon check
+		case BLOCK_MESSAGE_RECEIVE:{
+
+			MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( current );
+			if ( mrb -> isHandshake() ){
 
-			if ( _beacons_Name2Channel.find( channelName ) != _beacons_Name2Channel.end() ){
+				HandshakeChannel *channel = handshakeChannel( mrb -> getConstantChannel(), mrb -> getChannelName(), currentParameters, sp -> localVariables );
+				std::shared_ptr< Candidate > cand( new Candidate( mrb, currentParameters, sp -> localVariables, sp, parallelContinuations) );
 
-				_beacons_Name2Channel[channelName] -> addCandidate( current, sp, parallelProcesses, currentParameters, _candidatesLeft, _rateSum );
+				channel -> addReceiveCandidate( cand );
+				_sp2HandshakeChannels[sp].insert( channel );
+				_handshakesToUpdate.insert( channel );
 			}
-			else{
+			else{//beacon receive or beacon check
 
-				std::shared_ptr< BeaconChannel > newChannel( new BeaconChannel(channelName, _globalVars) );
-				_beacons_Name2Channel[channelName] = newChannel;
-				_beacons_Name2Channel[channelName] -> addCandidate( current, sp, parallelProcesses, currentParameters, _candidatesLeft, _rateSum );
+				BeaconChannel *channel = beaconChannel( mrb -> getConstantChannel(), mrb -> getChannelName(), currentParameters, sp -> localVariables );
+				channel -> addCandidate( current, sp, parallelContinuations, currentParameters, _scheduler );
+				_sp2BeaconChannels[sp].insert( channel );
 			}
+			break;
 		}
-	}
-	else if ( current -> identify() == "Gate" ){
+		case BLOCK_GATE:{
 
-		GateBlock *gb = static_cast< GateBlock * >( current );
-		bool gateConditionHolds = evalRPN_condition( gb -> getConditionExpression(), currentParameters, _globalVars, sp -> localVariables );
-		if ( gateConditionHolds ){
+			GateBlock *gb = static_cast< GateBlock * >( current );
+			bool gateConditionHolds = evalRPN_condition( gb -> getConditionExpression(), currentParameters, _globalVars, sp -> localVariables );
+			if ( gateConditionHolds ){
 
-			std::vector< Block * > children = bt.getChildren(current);
-			assert( children.size() == 1 );//gates are unary
-			sumTransitionRates( sp, bt, children[0], parallelProcesses, currentParameters );
+				assert( definition -> numberOfChildren( node ) == 1 );//gates are unary
+				sumTransitionRates( sp, definition, definition -> child( node, 0 ), parallelContinuations, currentParameters );
+			}
+			break;
 		}
-	}
-	else if ( current -> identify() == "Process" ){
+		case BLOCK_PROCESS:{
 
-		ProcessBlock *pb = static_cast< ProcessBlock * >(current);
+			ProcessBlock *pb = static_cast< ProcessBlock * >(current);
+			const CompiledProcess *called = pb -> getTarget();
 
-		//update the parameter values based on any process arithmetic we're doing
-		ParameterValues oldParameterValues = currentParameters;
-		std::vector< std::string > parameterNames = _name2ProcessDef[ pb -> getProcessName()].parameters;
-		for ( unsigned int i = 0; i < parameterNames.size(); i++ ){
+			//update the parameter values based on any process arithmetic we're doing
+			ParameterValues oldParameterValues = currentParameters;
+			const std::vector< unsigned int > &parameterSlots = called -> parameterSlots;
+			for ( unsigned int i = 0; i < parameterSlots.size(); i++ ){
 
-			currentParameters.updateValue( parameterNames[i], evalRPN_numerical(pb -> getParameterExpressions()[i], oldParameterValues , _globalVars, sp -> localVariables) );
+				currentParameters.updateValue( parameterSlots[i], evalRPN_numerical(pb -> getParameterExpressions()[i], oldParameterValues , _globalVars, sp -> localVariables) );
+			}
+			//recurse down from the root of this process's definition with the updated parameter values
+			sumTransitionRates( sp, called, 0, parallelContinuations, currentParameters );
+			break;
 		}
-		//recurse down using this process's tree and the updated parameter values
-		Tree<Block> newTree = _name2ProcessDef[ pb -> getProcessName()].parseTree;
-		sumTransitionRates( sp, newTree, newTree.getRoot(), parallelProcesses, currentParameters );
-	}
-	else if ( current -> identify() == "Parallel" ){
+		case BLOCK_PARALLEL:{
 
-		std::vector< Block * > children = bt.getChildren( current );
+			unsigned int leftChild = definition -> child( node, 0 );
+			unsigned int rightChild = definition -> child( node, 1 );
 
-		//left child
-		std::list< SystemProcess > forLeft = parallelProcesses;
-		SystemProcess left_sp = SystemProcess( *sp );
-		left_sp.parseTree = bt.getSubtree( children[1] );
-		//printBlockTree(left_sp.parseTree,left_sp.parseTree.getRoot());
-		//std::cout << children[1] -> identify() << std::endl;
-		forLeft.push_back( left_sp );
-		sumTransitionRates( sp, bt, children[0], forLeft, currentParameters );
+			//each side continues with the other side running in parallel to it
+			std::shared_ptr< const ParallelContinuation > forLeft( new ParallelContinuation( definition, rightChild, currentParameters, parallelContinuations ) );
+			sumTransitionRates( sp, definition, leftChild, forLeft, currentParameters );
 
-		//right child
-		SystemProcess right_sp = SystemProcess( *sp );
-		right_sp.parseTree = bt.getSubtree( children[0] );
-		//printBlockTree(right_sp.parseTree,right_sp.parseTree.getRoot());
-		//std::cout << children[0] -> identify() << std::endl;
-		parallelProcesses.push_back( right_sp );
-		sumTransitionRates( sp, bt, children[1], parallelProcesses, currentParameters );
-		//NOTE: the indexing for children looks weird, but it's fine and it's also checked by the process-parallelTreeRecursion.bc test
-	}
-	else {
-		std::vector< Block * > children = bt.getChildren(current);
-		for ( auto c = children.begin(); c < children.end(); c++ ){
+			std::shared_ptr< const ParallelContinuation > forRight( new ParallelContinuation( definition, leftChild, currentParameters, parallelContinuations ) );
+			sumTransitionRates( sp, definition, rightChild, forRight, currentParameters );
+			//NOTE: the indexing for children looks weird, but it's fine and it's also checked by the process-parallelTreeRecursion.bc test
+			break;
+		}
+		default:{
 
-			sumTransitionRates( sp, bt, *c, parallelProcesses, currentParameters );
+			for ( unsigned int i = 0; i < definition -> numberOfChildren( node ); i++ ){
+
+				sumTransitionRates( sp, definition, definition -> child( node, i ), parallelContinuations, currentParameters );
+			}
+			break;
 		}
 	}
 }
@@ -337,10 +454,19 @@ void System::sumTransitionRates( SystemProcess *sp,
 void System::getParallelProcesses( std::shared_ptr<Candidate> chosen, std::list< SystemProcess * > &toAdd ){
 //if we choose this candidate, get the processes that would act in parallel to this one
 
+	//the chain runs from the innermost parallel operator outwards, so walk it back to add processes in the order the operators were found
+	std::vector< const ParallelContinuation * > chain;
+	for ( const ParallelContinuation *pc = (chosen -> parallelContinuations).get(); pc != NULL; pc = (pc -> previous).get() ) chain.push_back( pc );
+
 	//add parallel processes to the system
-	for ( auto pp = (chosen -> parallelProcesses).begin(); pp != (chosen -> parallelProcesses).end(); pp++ ){
+	for ( auto pc = chain.rbegin(); pc != chain.rend(); pc++ ){
 
-		toAdd.push_back( new SystemProcess( *pp ) );
+		SystemProcess *newSp = new SystemProcess();
+		newSp -> definition = (*pc) -> definition;
+		newSp -> node = (*pc) -> node;
+		newSp -> parameterValues = (*pc) -> parameterValues;
+		newSp -> localVariables = (chosen -> processInSystem) -> localVariables;
+		toAdd.push_back( newSp );
 	}
 }
 
@@ -351,16 +477,16 @@ SystemProcess * System::updateSpForTransition( std::shared_ptr<Candidate> chosen
 
 	//get the child of the chosen action, and update the current system process so that it starts from there
 	Block *actionDone = chosen -> actionCandidate;
-	Tree<Block> treeForAction = _name2ProcessDef[ actionDone -> getOwningProcess() ].parseTree;
+	const CompiledProcess *definition = actionDone -> getDefinition();
 
-	if ( treeForAction.isLeaf( actionDone ) ) return NULL;
+	if ( definition -> isLeaf( actionDone -> getNode() ) ) return NULL;
 	else {
 
 		SystemProcess *newSp = new SystemProcess( *SPtoModify );
 		newSp -> parameterValues = chosen -> parameterValues; //inherit the parameter variables from the candidate
-		std::vector< Block * > children = treeForAction.getChildren( actionDone );
-		assert( children.size() == 1 );
-		newSp -> parseTree = treeForAction.getSubtree( children[0] );
+		assert( definition -> numberOfChildren( actionDone -> getNode() ) == 1 );
+		newSp -> definition = definition;
+		newSp -> node = definition -> child( actionDone -> getNode(), 0 );
 #if DEBUG
 std::cout << "   Update for transition: killed " << SPtoModify << " and added " << newSp << std::endl;
 #endif
@@ -369,143 +495,286 @@ std::cout << "   Update for transition: killed " << SPtoModify << " and added "
 }
 
 
-void System::splitOnParallel(SystemProcess *sp, Block *currentNode, std::list< SystemProcess * > &toAdd ){
+void System::splitOnParallel(SystemProcess *sp, unsigned int node, std::list< SystemProcess * > &toAdd ){
 //recurse down a parse tree, get the first blocks that aren't parallel operators, and make separate system processes for them
 //prevents issues in situations where we have handshakes between two message actions within a single system process
 
-	if ( currentNode -> identify() == "Parallel" ){
+	const CompiledProcess *definition = sp -> definition;
+	if ( definition -> block( node ) -> kind() == BLOCK_PARALLEL ){
 
-		std::vector< Block * > children = (sp -> parseTree).getChildren( currentNode );
-		for ( auto c = children.begin(); c < children.end(); c++ ){
+		for ( unsigned int i = 0; i < definition -> numberOfChildren( node ); i++ ){
 
-			splitOnParallel(sp, *c, toAdd );
+			splitOnParallel(sp, definition -> child( node, i ), toAdd );
 		}
 	}
 	else {
 
 		SystemProcess *newSp = new SystemProcess( *sp );
-		newSp -> parseTree = (sp -> parseTree).getSubtree( currentNode );
+		newSp -> node = node;
 		toAdd.push_back( newSp );
 		return;
 	}
 }
 
 
-void System::removeChosenFromSystem( std::shared_ptr<Candidate> candToRemove, bool databaseUpdated ){
+void System::withdrawCandidates( SystemProcess *sp ){
+//take every candidate a system process has out of the scheduler and off the channels it's on
 
-	SystemProcess *sp = candToRemove -> processInSystem;
+	//take the candidates for this system process out of the scheduler
+	auto locInNonMsg = _nonMsgCandidates.find( sp );
+	if ( locInNonMsg != _nonMsgCandidates.end() ){
 
-	//take away all the rates that this system contributed to the rateSum
-	bool inNonMsgCandidates = false;
-	for ( auto c = _nonMsgCandidates[sp].begin(); c != _nonMsgCandidates[sp].end(); c++ ){
+		for ( auto c = (locInNonMsg -> second).begin(); c != (locInNonMsg -> second).end(); c++ ){
 
-		_rateSum -= (*c) -> rate;
-		_candidatesLeft--;
-		inNonMsgCandidates = true;
+			_scheduler.remove( **c );
+		}
+		_nonMsgCandidates.erase( locInNonMsg );
 	}
 
-	//erase from candidates
-	if ( inNonMsgCandidates ) _nonMsgCandidates.erase( _nonMsgCandidates.find( sp ) );
+	//erase any beacon candidate that pertains to sp from the channels sp has candidates on
+	auto beaconDeps = _sp2BeaconChannels.find( sp );
+	if ( beaconDeps != _sp2BeaconChannels.end() ){
 
-	//erase any beacon candidate that pertains to sp
-	for ( auto be = _beacons_Name2Channel.begin(); be != _beacons_Name2Channel.end(); be++ ){
+		for ( auto be = (beaconDeps -> second).begin(); be != (beaconDeps -> second).end(); be++ ){
 
-		(be -> second) -> cleanSPFromChannel(sp,_candidatesLeft,_rateSum);
+			(*be) -> cleanSPFromChannel( sp, _scheduler );
+		}
+		_sp2BeaconChannels.erase( beaconDeps );
 	}
 
 	//erase any handshake candidate that could be sent or received from sp
-	for ( auto hs = _handshakes_Name2Channel.begin(); hs != _handshakes_Name2Channel.end(); hs++ ){
+	auto handshakeDeps = _sp2HandshakeChannels.find( sp );
+	if ( handshakeDeps != _sp2HandshakeChannels.end() ){
 
-		int handshakesRemoved;
-		double rateSumDecrease; 
-		std::tie(handshakesRemoved,rateSumDecrease) = (hs -> second) -> cleanSPFromChannel(sp);
-		_rateSum -= rateSumDecrease;
-		_candidatesLeft -= handshakesRemoved;
+		for ( auto hs = (handshakeDeps -> second).begin(); hs != (handshakeDeps -> second).end(); hs++ ){
+
+			(*hs) -> cleanSPFromChannel( sp, _scheduler );
+		}
+		_sp2HandshakeChannels.erase( handshakeDeps );
 	}
+}
 
-	//reshuffle potential vs active beacon receives, but only do this if database was updated
-	if (databaseUpdated){
 
-		for ( auto be = _beacons_Name2Channel.begin(); be != _beacons_Name2Channel.end(); be++ ){
+/*LUMPING---------------------------------------------------------------------------------------------------------------------------------------------------------*/
+void System::resolveCalls( SystemProcess *sp ){
+//move a process waiting at a call to the root of the process it calls, so that it's lumped with processes already in that state
 
-			(be -> second) -> updateBeaconCandidates(_candidatesLeft,_rateSum);
+	Block *b = sp -> currentBlock();
+	while ( b -> kind() == BLOCK_PROCESS ){
+
+		ProcessBlock *pb = static_cast< ProcessBlock * >( b );
+		const CompiledProcess *called = pb -> getTarget();
+
+		ParameterValues oldParameterValues = sp -> parameterValues;
+		const std::vector< unsigned int > &parameterSlots = called -> parameterSlots;
+		for ( unsigned int i = 0; i < parameterSlots.size(); i++ ){
+
+			(sp -> parameterValues).updateValue( parameterSlots[i], evalRPN_numerical( pb -> getParameterExpressions()[i], oldParameterValues, _globalVars, sp -> localVariables ) );
 		}
+		sp -> definition = called;
+		sp -> node = 0;
+		b = sp -> currentBlock();
 	}
+}
 
-	//remove the system process from the system
-	_currentProcesses.erase( std::find(_currentProcesses.begin(), _currentProcesses.end(), sp ) ); 
-#if DEBUG
-std::cout << "   Removing chosen from system: deleting system process pointer " << sp << std::endl;
-#endif
-	delete sp;
+
+bool System::lumpable( const CompiledProcess *definition, unsigned int node ){
+//whether copies of a process at this node can be lumped.  a process waiting at a beacon receive only has candidates for the beacons that
+//matched when it got there, so copies that got there at different times aren't the same, and any node where one might be next isn't lumped
+
+	Block *b = definition -> block( node );
+	auto found = _lumpable.find( b );
+	if ( found != _lumpable.end() ) return found -> second;
+	_lumpable[b] = true; //in case a call leads back here
+
+	bool out = true;
+	switch ( b -> kind() ){
+
+		case BLOCK_ACTION:
+		case BLOCK_MESSAGE_SEND:
+			break;
+		case BLOCK_MESSAGE_RECEIVE:{
+
+			MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( b );
+			out = mrb -> isHandshake() or mrb -> isCheck();
+			break;
+		}
+		case BLOCK_PROCESS:{
+
+			out = lumpable( static_cast< ProcessBlock * >( b ) -> getTarget(), 0 );
+			break;
+		}
+		default:{
+
+			for ( unsigned int i = 0; i < definition -> numberOfChildren( node ) and out; i++ ){
+
+				out = lumpable( definition, definition -> child( node, i ) );
+			}
+			break;
+		}
+	}
+	_lumpable[b] = out;
+	return out;
 }
 
 
-void System::simulate(void){
+static void appendValue( std::string &key, Numerical v ){
 
-	while ( _candidatesLeft > 0 and _transitionsTaken < _maxTransitions and _totalTime <= _maxDuration ){
+	if ( v.isInt() ){
 
-		/*draw time of next transition */
-		std::random_device rd;
-		std::mt19937 rnd_gen( rd() );
-		std::exponential_distribution< double > expDist(_rateSum);
-		double exponentialDraw = expDist(rnd_gen);
-		_totalTime += exponentialDraw;
+		int i = v.getInt();
+		key += 'i';
+		key.append( reinterpret_cast< const char * >( &i ), sizeof( i ) );
+	}
+	else{
 
-#if DEBUG
-std::cout << "-----------------" << std::endl;
-std::cout << "Candidates left: " << _candidatesLeft << std::endl;
-std::cout << "Transitions taken: " << _transitionsTaken << std::endl;
-std::cout << "Rate sum: " << _rateSum << std::endl;
-std::cout << "Total time elapsed: " << _totalTime << std::endl;
-#endif
+		double d = v.getDouble();
+		key += 'd';
+		key.append( reinterpret_cast< const char * >( &d ), sizeof( d ) );
+	}
+}
 
-		/*monte carlo step to decide next transition */
-		std::uniform_real_distribution< double > uniDist(0.0, 1.0);
-		double uniformDraw = uniDist(rnd_gen);
 
-		/*go through all the transition candidates and stop when we find the correct one */
-		double runningTotal = 0.0;
-		bool found = false;
-		std::list< SystemProcess * > toAdd;
+std::string System::lumpKey( SystemProcess *sp ){
+//processes with the same key are in the same state: at the same node of the same definition, with the same parameters and bindings.
+//only the definition's own parameters count, since any other process's are filled in again by the call that starts it
 
-		/*non-messaging choice */
-		for ( auto s = _nonMsgCandidates.begin(); s != _nonMsgCandidates.end(); s++ ){
+	std::string key;
+	key.append( reinterpret_cast< const char * >( &( sp -> definition ) ), sizeof( sp -> definition ) );
+	key.append( reinterpret_cast< const char * >( &( sp -> node ) ), sizeof( sp -> node ) );
 
-			for ( auto tc = (s -> second).begin(); tc < (s -> second).end(); tc++ ){
+	const std::vector< unsigned int > &parameterSlots = ( sp -> definition ) -> parameterSlots;
+	for ( auto s = parameterSlots.begin(); s < parameterSlots.end(); s++ ){
+
+		if ( (sp -> parameterValues).isDefined( *s ) ) appendValue( key, (sp -> parameterValues).getValue( *s ) );
+		else key += 'u';
+	}
+
+	for ( unsigned int s = 0; s < (sp -> localVariables).size(); s++ ){
+
+		if ( not (sp -> localVariables).isDefined( s ) ) continue;
+		key.append( reinterpret_cast< const char * >( &s ), sizeof( s ) );
+		appendValue( key, (sp -> localVariables).getValue( s ) );
+	}
+	return key;
+}
+
+
+void System::lumpProcesses( std::list< SystemProcess * > &toAdd ){
+//fold each new process into a lumped process in the same state if there is one, then sum the rates of lumped processes whose count
+//changed.  what's left in toAdd are processes in a state nothing else is in, whose rates are summed as usual
+
+	std::set< SystemProcess * > unsummed( toAdd.begin(), toAdd.end() );
+	for ( auto s = toAdd.begin(); s != toAdd.end(); ){
+
+		resolveCalls( *s );
+
+		//the process called might start by going parallel, in which case each side is a new process of its own
+		if ( (*s) -> currentBlock() -> kind() == BLOCK_PARALLEL ){
+
+			std::list< SystemProcess * > sides;
+			splitOnParallel( *s, (*s) -> node, sides );
+			unsummed.erase( *s );
+			unsummed.insert( sides.begin(), sides.end() );
+			toAdd.insert( toAdd.end(), sides.begin(), sides.end() );
+			delete *s;
+			s = toAdd.erase( s );
+			continue;
+		}
 
-				double lower = runningTotal / _rateSum;
-				double upper = (runningTotal + ( (*tc) -> rate)) / _rateSum;
+		if ( not lumpable( (*s) -> definition, (*s) -> node ) ){
+
+			s++;
+			continue;
+		}
+
+		std::string key = lumpKey( *s );
+		auto existing = _lumps.find( key );
+		if ( existing == _lumps.end() ){
+
+			_lumps[key] = *s;
+			_sp2Lump[*s] = std::make_pair( key, (*s) -> parameterValues );
+			s++;
+			continue;
+		}
+
+		//a lumped process that's already in the system has its candidates replaced by ones for the new count
+		SystemProcess *lump = existing -> second;
+		lump -> count++;
+		if ( unsummed.count( lump ) == 0 ){
+
+			withdrawCandidates( lump );
+			_lumpsToResum.insert( lump );
+		}
+		unsummed.erase( *s );
+		delete *s;
+		s = toAdd.erase( s );
+	}
+
+	std::shared_ptr< const ParallelContinuation > noContinuations;
+	for ( auto l = _lumpsToResum.begin(); l != _lumpsToResum.end(); l++ ){
+
+		(*l) -> parameterValues = _sp2Lump[*l].second;
+		sumTransitionRates( *l, (*l) -> definition, (*l) -> node, noContinuations, (*l) -> parameterValues );
+	}
+	_lumpsToResum.clear();
+}
+
+
+void System::removeChosenFromSystem( std::shared_ptr<Candidate> candToRemove, BeaconChannel *updatedChannel ){
+
+	SystemProcess *sp = candToRemove -> processInSystem;
+	withdrawCandidates( sp );
+
+	//reshuffle potential vs active beacon receives on the channel whose database was updated; receives on other channels can't have changed
+	if ( updatedChannel != NULL ) updatedChannel -> updateBeaconCandidates( _scheduler );
+
+	//one copy of a lumped process moved on, so the rest stay with their rates summed again for the smaller count
+	if ( sp -> count > 1 ){
+
+		sp -> count--;
+		_lumpsToResum.insert( sp );
+		return;
+	}
+	auto lump = _sp2Lump.find( sp );
+	if ( lump != _sp2Lump.end() ){
+
+		_lumps.erase( ( lump -> second ).first );
+		_sp2Lump.erase( lump );
+		_lumpsToResum.erase( sp );
+	}
+
+	//remove the system process from the system
+	_currentProcesses.erase( sp -> position );
+#if DEBUG
+std::cout << "   Removing chosen from system: deleting system process pointer " << sp << std::endl;
+#endif
+	delete sp;
+}
+
+
+void System::fireNonMsg( std::shared_ptr<Candidate> chosen, std::list< SystemProcess * > &toAdd ){
 
-				if ( uniformDraw > lower and uniformDraw <= upper ){
 #if DEBUG
 std::cout << ">Candidate picked: non-msg action ";
-Block *b = (*tc) -> actionCandidate;
+Block *b = chosen -> actionCandidate;
 Token *t = b -> getToken();
 std::cout << t -> value();
-std::cout << " at rate " << (*tc) -> rate << std::endl;
+std::cout << " at rate " << chosen -> rate << std::endl;
 #endif
-					//designate the chosen one
-					getParallelProcesses( *tc, toAdd );
-					SystemProcess *newSp = updateSpForTransition( *tc );
-					if ( newSp ) toAdd.push_back(newSp);
-					writeTransition( _totalTime, *tc, _outputStream );
+
+	getParallelProcesses( chosen, toAdd );
+	SystemProcess *newSp = updateSpForTransition( chosen );
+	if ( newSp ) toAdd.push_back(newSp);
+	writeTransition( _totalTime, chosen, _outputStream );
 #if DEBUG
-printTransition(_totalTime, *tc);
+printTransition(_totalTime, chosen);
 #endif
-					removeChosenFromSystem(*tc, false);
-					found = true;
-					goto foundCand;
-				}
-				else runningTotal += (*tc) -> rate;
-			}
-		}
+	removeChosenFromSystem(chosen, NULL);
+}
 
-		/*if we haven't chosen from the non-messaging choices, look at beacon action */
-		for ( auto chanPair = _beacons_Name2Channel.begin(); chanPair != _beacons_Name2Channel.end(); chanPair++ ){ 
-			
-			std::shared_ptr<Candidate> beaconCand = (chanPair -> second) -> pickCandidate(runningTotal, uniformDraw, _rateSum);
-			if ( beaconCand != NULL ){
+
+void System::fireBeacon( std::shared_ptr<Candidate> beaconCand, BeaconChannel *channel, std::list< SystemProcess * > &toAdd ){
 
 #if DEBUG
 std::cout << ">Candidate picked: beacon ";
@@ -515,42 +784,38 @@ std::cout << t -> value();
 std::cout << " at rate " << beaconCand -> rate << std::endl;
 #endif
 
-				getParallelProcesses( beaconCand, toAdd );
-				SystemProcess *newSp = updateSpForTransition( beaconCand );
+	//launch or kill the beacon for the send that we chose
+	channel -> updateDatabase( beaconCand );
 
-				if ( newSp and (beaconCand -> actionCandidate) -> identify() == "MessageReceive" ){
+	getParallelProcesses( beaconCand, toAdd );
+	SystemProcess *newSp = updateSpForTransition( beaconCand );
 
-					//bind a new variable if applicable
-					MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( beaconCand -> actionCandidate );
-					if ( mrb -> bindsVariable() ){
+	if ( newSp and (beaconCand -> actionCandidate) -> kind() == BLOCK_MESSAGE_RECEIVE ){
 
-						std::vector< std::string > bindingVars = mrb -> getBindingVariable();
-						for ( unsigned int i = 0; i < bindingVars.size(); i++ ){
-						
-							newSp -> localVariables[ bindingVars[i] ] = (beaconCand -> rangeEvaluation)[i];
-						}
-					}
-				}
+		//bind a new variable if applicable
+		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( beaconCand -> actionCandidate );
+		if ( mrb -> bindsVariable() ){
 
-				if ( newSp ) toAdd.push_back(newSp);
-				writeTransition( _totalTime, beaconCand, _outputStream );
+			const std::vector< unsigned int > &bindingSlots = mrb -> getBindingSlots();
+			for ( unsigned int i = 0; i < bindingSlots.size(); i++ ){
+			
+				newSp -> localVariables.updateValue( bindingSlots[i], (beaconCand -> rangeEvaluation)[i] );
+			}
+		}
+	}
+
+	if ( newSp ) toAdd.push_back(newSp);
+	writeTransition( _totalTime, beaconCand, _outputStream );
 #if DEBUG
 printTransition(_totalTime, beaconCand);
 #endif
 
-				bool databaseUpdated = (beaconCand -> actionCandidate) -> identify() == "MessageSend";
-				removeChosenFromSystem(beaconCand, databaseUpdated);
-				found = true;
-				goto foundCand;
-			}
-		}
+	bool databaseUpdated = (beaconCand -> actionCandidate) -> kind() == BLOCK_MESSAGE_SEND;
+	removeChosenFromSystem(beaconCand, databaseUpdated ? channel : NULL);
+}
 
-		/*if we haven't chosen from the beacon actions, look at the handshakes */
-		for ( auto chanPair = _handshakes_Name2Channel.begin(); chanPair != _handshakes_Name2Channel.end(); chanPair++ ){ 
-			
-			std::shared_ptr<HandshakeCandidate> hsCand = (chanPair -> second) -> pickCandidate(runningTotal, uniformDraw, _rateSum);
-			
-			if ( hsCand != NULL ){
+
+void System::fireHandshake( std::shared_ptr<HandshakeCandidate> hsCand, std::list< SystemProcess * > &toAdd ){
 
 #if DEBUG
 std::cout << ">Candidate picked: handshake ";
@@ -563,125 +828,650 @@ std::cout << t -> value();
 std::cout << " at rate " << hsCand -> rate << std::endl;
 #endif
 
-				//handshake send
-				getParallelProcesses( hsCand -> hsSendCand, toAdd );
-				SystemProcess *newSp_send = updateSpForTransition( hsCand -> hsSendCand );
-				if ( newSp_send ) toAdd.push_back(newSp_send);
+	//handshake send
+	getParallelProcesses( hsCand -> hsSendCand, toAdd );
+	SystemProcess *newSp_send = updateSpForTransition( hsCand -> hsSendCand );
+	if ( newSp_send ) toAdd.push_back(newSp_send);
 
-				//handshake receive
-				getParallelProcesses( hsCand -> hsReceiveCand, toAdd );
-				SystemProcess *newSp_receive = updateSpForTransition( hsCand -> hsReceiveCand );
+	//handshake receive
+	getParallelProcesses( hsCand -> hsReceiveCand, toAdd );
+	SystemProcess *newSp_receive = updateSpForTransition( hsCand -> hsReceiveCand );
 
-				if ( newSp_receive ){
+	if ( newSp_receive ){
 
-					//bind a new variable if applicable
-					MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( (hsCand -> hsReceiveCand) -> actionCandidate );
-					if ( mrb -> bindsVariable() ){
+		//bind a new variable if applicable
+		MessageReceiveBlock *mrb = static_cast< MessageReceiveBlock * >( (hsCand -> hsReceiveCand) -> actionCandidate );
+		if ( mrb -> bindsVariable() ){
 
-						std::vector< std::string > bindingVars = mrb -> getBindingVariable();
-						std::vector< int > receivedParams = hsCand -> getReceivedParam();
-						for ( unsigned int i = 0; i < bindingVars.size(); i++ ){
+			const std::vector< unsigned int > &bindingSlots = mrb -> getBindingSlots();
+			std::vector< int > receivedParams = hsCand -> getReceivedParam();
+			for ( unsigned int i = 0; i < bindingSlots.size(); i++ ){
 
-							Numerical  n;
-							n.setInt(receivedParams[i]);
-							newSp_receive -> localVariables[ bindingVars[i] ] = n;
-						}
-					}
-					toAdd.push_back(newSp_receive);
-				}
+				Numerical  n;
+				n.setInt(receivedParams[i]);
+				newSp_receive -> localVariables.updateValue( bindingSlots[i], n );
+			}
+		}
+		toAdd.push_back(newSp_receive);
+	}
 
-				writeTransition( _totalTime, hsCand -> hsSendCand, _outputStream );
-				writeTransition( _totalTime, hsCand -> hsReceiveCand, _outputStream );
+	writeTransition( _totalTime, hsCand -> hsSendCand, _outputStream );
+	writeTransition( _totalTime, hsCand -> hsReceiveCand, _outputStream );
 #if DEBUG
 printTransition(_totalTime, hsCand -> hsSendCand);
 printTransition(_totalTime, hsCand -> hsReceiveCand);
 #endif
-				//remove handshake from the system
-				removeChosenFromSystem( hsCand -> hsSendCand, false );
-				removeChosenFromSystem( hsCand -> hsReceiveCand, false );
+	//remove handshake from the system
+	removeChosenFromSystem( hsCand -> hsSendCand, NULL );
+	removeChosenFromSystem( hsCand -> hsReceiveCand, NULL );
+}
 
-				found = true;
-				goto foundCand;
-			}
-		}
 
-		foundCand:
-		assert( found );
-		_transitionsTaken++;
+void System::addProcesses( std::list< SystemProcess * > &toAdd ){
+//bring the processes a transition made into the system, with their candidates
 
 #if DEBUG
 std::cout << "   Reformatting system... ";
 #endif
 
-		//re-format the system
-		std::list< SystemProcess * > newProcesses;
-		for ( auto s = toAdd.begin(); s != toAdd.end(); ){
+	//re-format the system
+	std::list< SystemProcess * > newProcesses;
+	for ( auto s = toAdd.begin(); s != toAdd.end(); ){
 
-			//see if we can make multiple system processes out of this one by splitting on parallel operators
-			if ( ( (*s) -> parseTree).getRoot() -> identify() == "Parallel" ){				
+		//see if we can make multiple system processes out of this one by splitting on parallel operators
+		if ( (*s) -> currentBlock() -> kind() == BLOCK_PARALLEL ){
 
-				splitOnParallel( *s, ((*s) -> parseTree).getRoot(), newProcesses );
-				delete *s;
-				s = toAdd.erase( s );
-			}
-			else s++;
+			splitOnParallel( *s, (*s) -> node, newProcesses );
+			delete *s;
+			s = toAdd.erase( s );
 		}
-		toAdd.insert( toAdd.end(), newProcesses.begin(), newProcesses.end() );
+		else s++;
+	}
+	toAdd.insert( toAdd.end(), newProcesses.begin(), newProcesses.end() );
+	if ( _lump ) lumpProcesses( toAdd );
 
 #if DEBUG
 std::cout << "Done." << std::endl;
 std::cout << "   Re-summing transitions... ";
 #endif
 
-		//sum the transition rates for non-handshake candidates while buildling a list of candshake candidates
-		std::list< SystemProcess > parallelProcesses;
-		for ( auto s = toAdd.begin(); s != toAdd.end(); s++ ){
+	//sum the transition rates for non-handshake candidates while buildling a list of candshake candidates
+	std::shared_ptr< const ParallelContinuation > noContinuations;
+	for ( auto s = toAdd.begin(); s != toAdd.end(); s++ ){
 
-			sumTransitionRates( *s, (*s) -> parseTree, ((*s) -> parseTree).getRoot(), parallelProcesses, (*s) -> parameterValues );
-		}
+		(*s) -> id = _nextProcessId++;
+		sumTransitionRates( *s, (*s) -> definition, (*s) -> node, noContinuations, (*s) -> parameterValues );
+	}
 
 #if DEBUG
 std::cout << "Done." << std::endl;
 std::cout << "   Re-summing handshakes... ";
 #endif
 
-		//sum handshake transitions
-		for ( auto chan = _handshakes_Name2Channel.begin(); chan != _handshakes_Name2Channel.end(); chan++ ){
-
-			int newHandshakesAdded;
-			double rateSumIncrease;
-			std::tie(newHandshakesAdded,rateSumIncrease) = (chan -> second) -> updateHandshakeCandidates();
-			_candidatesLeft += newHandshakesAdded;
-			_rateSum += rateSumIncrease;
-		}
-		_currentProcesses.insert( _currentProcesses.end(), toAdd.begin(), toAdd.end() );
+	//sum handshake transitions
+	updateHandshakes();
+	for ( auto s = toAdd.begin(); s != toAdd.end(); s++ ) (*s) -> position = _currentProcesses.insert( _currentProcesses.end(), *s );
 #if DEBUG
 std::cout << "Done." << std::endl;
 #endif
+}
+
+
+void System::fireTransition( ScheduledTransition &next, std::list< SystemProcess * > &toAdd ){
+
+	if ( _sampleEvery > 0.0 ) writeSamples( _totalTime );
+	if ( next.handshake ) fireHandshake( next.handshake, toAdd );
+	else if ( next.beaconChannel ) fireBeacon( next.candidate, next.beaconChannel, toAdd );
+	else fireNonMsg( next.candidate, toAdd );
+}
+
+
+void System::stepDirect( std::list< SystemProcess * > &toAdd ){
+//Gillespie's direct method: draw the time to the next transition from the total rate, then pick a candidate in proportion to its rate
+
+	double rateSum = _scheduler.rateSum();
+
+	/*draw time of next transition */
+	_totalTime += _rng.exponential( rateSum );
+
+#if DEBUG
+std::cout << "-----------------" << std::endl;
+std::cout << "Candidates left: " << _scheduler.candidatesLeft() << std::endl;
+std::cout << "Transitions taken: " << _transitionsTaken << std::endl;
+std::cout << "Rate sum: " << rateSum << std::endl;
+std::cout << "Total time elapsed: " << _totalTime << std::endl;
+#endif
+
+	/*monte carlo step to decide next transition */
+	double uniformDraw = _rng.uniform();
+
+	/*the scheduler's sum tree finds the candidate whose share of the rate sum contains the draw */
+	ScheduledTransition next = _scheduler.pickDirect( uniformDraw );
+	fireTransition( next, toAdd );
+}
+
+
+void System::stepNextReaction( std::list< SystemProcess * > &toAdd ){
+//Gibson and Bruck's next reaction method: every candidate holds an absolute firing time in the scheduler's heap and the earliest one fires
+
+	ScheduledTransition next = _scheduler.nextReaction( _totalTime );
+
+#if DEBUG
+std::cout << "-----------------" << std::endl;
+std::cout << "Candidates left: " << _scheduler.candidatesLeft() << std::endl;
+std::cout << "Transitions taken: " << _transitionsTaken << std::endl;
+std::cout << "Total time elapsed: " << _totalTime << std::endl;
+#endif
+
+	fireTransition( next, toAdd );
+}
+
+
+void System::resolveFastChain( void ){
+//with --fast, transitions at or above the fast rate run one after another for as long as each comes before the next slow transition,
+//and the chain is written as the last transition in it, at the time it ended.  the fast transitions share one clock at the sum of their
+//rates, raced against the firing times of the slow ones.  the clock is memoryless, so a draw that loses the race is dropped and the slow
+//transition fires as it would have anyway, which keeps the simulation exact.  each transition in the chain counts towards -m
+
+	_inFastChain = true;
+	while ( _scheduler.fastPending() and _transitionsTaken < _maxTransitions and _totalTime <= _maxDuration ){
+
+		double time = _totalTime + _rng.exponential( _scheduler.fastRateSum() );
+		if ( time > _scheduler.nextSlowTime() ) break;
+
+		_totalTime = time;
+		_scheduler.advanceTo( _totalTime );
+		ScheduledTransition next = _scheduler.pickFast( _scheduler.fastLeft() > 1 ? _rng.uniform() : 0.0 );
+
+		std::list< SystemProcess * > toAdd;
+		fireTransition( next, toAdd );
+		addProcesses( toAdd );
+		_transitionsTaken++;
+	}
+	_inFastChain = false;
+
+	if ( _chainOutcome ) writeTransition( _totalTime, _chainOutcome, _outputStream );
+	_chainOutcome.reset();
+}
+
+
+/*REACTION NETWORK----------------------------------------------------------------------------------------------------------------------------------------------------*/
+void System::toSpecies( std::list< SystemProcess * > &processes, std::vector< unsigned int > &species ){
+//the species of each process, which are added to the network and the system if they're new.  processes are deleted or kept as species
+
+	for ( auto s = processes.begin(); s != processes.end(); s++ ){
+
+		resolveCalls( *s );
+
+		//the process called might start by going parallel, in which case each side is a process of its own
+		if ( (*s) -> currentBlock() -> kind() == BLOCK_PARALLEL ){
+
+			splitOnParallel( *s, (*s) -> node, processes );
+			delete *s;
+			continue;
+		}
+
+		std::string key = lumpKey( *s );
+		int found = _network -> findSpecies( key );
+		if ( found < 0 ){
+
+			found = _network -> addSpecies( key, *s );
+			(*s) -> id = _nextProcessId++;
+			(*s) -> position = _currentProcesses.insert( _currentProcesses.end(), *s );
+		}
+		else delete *s;
+		species.push_back( found );
+	}
+	processes.clear();
+}
+
+
+void System::expandSpecies( unsigned int s ){
+//work out the reactions of a species the first time it has copies, and the species each one makes
+
+	SystemProcess *sp = _network -> species( s );
+	ParameterValues parameterValues = sp -> parameterValues;
+	std::shared_ptr< const ParallelContinuation > noContinuations;
+	_speciesActions.clear();
+	sumTransitionRates( sp, sp -> definition, sp -> node, noContinuations, parameterValues );
+
+	std::vector< Reaction > reactions( _speciesActions.size() );
+	for ( unsigned int i = 0; i < _speciesActions.size(); i++ ){
+
+		reactions[i].reactant = s;
+		reactions[i].rate = _speciesActions[i] -> rate;
+		reactions[i].transition = _speciesActions[i];
+
+		std::list< SystemProcess * > products;
+		getParallelProcesses( _speciesActions[i], products );
+		SystemProcess *next = updateSpForTransition( _speciesActions[i] );
+		if ( next ) products.push_back( next );
+		toSpecies( products, reactions[i].products );
+	}
+	_network -> addReactions( s, reactions );
+}
+
+
+void System::stepNetwork( void ){
+//the direct method on the reaction network: the same draws as stepDirect, but a reaction moves one copy of its reactant to its products
+
+	double propensitySum = _network -> totalPropensity();
+	_totalTime += _rng.exponential( propensitySum );
+	unsigned int r = _network -> pick( _rng.uniform() * propensitySum );
+
+	if ( _sampleEvery > 0.0 ) writeSamples( _totalTime );
+	writeTransition( _totalTime, _network -> reaction( r ).transition, _outputStream );
+
+	//products are looked up by index, since working out the reactions of a new species can move the reactions in memory
+	_network -> changeCount( _network -> reaction( r ).reactant, -1 );
+	for ( unsigned int i = 0; i < _network -> reaction( r ).products.size(); i++ ){
+
+		unsigned int p = _network -> reaction( r ).products[i];
+		if ( not _network -> isExpanded( p ) ) expandSpecies( p );
+		_network -> changeCount( p, 1 );
+	}
+	collectSpecies();
+}
+
+
+void System::collectSpecies( void ){
+//species that ran out of copies for good are freed, so a model that keeps making new species doesn't keep every one it ever made
+
+	std::vector< SystemProcess * > freed;
+	_network -> collect( freed );
+	for ( auto sp = freed.begin(); sp < freed.end(); sp++ ){
+
+		_currentProcesses.erase( (*sp) -> position );
+		delete *sp;
+	}
+}
+
+
+bool System::exploreNetwork( void ){
+//work out the reactions of every species reachable from the system line, and whether there are few enough of them to simulate as a network
+
+	for ( unsigned int s = 0; s < _network -> numberOfSpecies() and s <= ReactionNetwork::maxSpecies; s++ ){
+
+		if ( not _network -> isExpanded( s ) ) expandSpecies( s );
+	}
+	return _network -> numberOfSpecies() <= ReactionNetwork::maxSpecies;
+}
+
+
+void System::leapNetwork( void ){
+//one tau-leap with Cao, Gillespie and Petzold's step size selection (J Chem Phys 124:044109, 2006), or a run of exact steps if a leap
+//wouldn't be worth it.  every reaction here has one reactant, so each reaction is first order in the sense of their bounds
+
+	const unsigned int criticalCopies = 10, exactSteps = 100;
+	double a0 = _network -> totalPropensity();
+
+	//reactions that could use up their reactant in a few firings are critical, and fire at most once per leap
+	std::vector< unsigned int > critical, nonCritical;
+	std::vector< double > mean( _network -> numberOfSpecies(), 0.0 ), variance( _network -> numberOfSpecies(), 0.0 );
+	std::vector< bool > reactant( _network -> numberOfSpecies(), false );
+	double criticalSum = 0.0;
+	for ( unsigned int r = 0; r < _network -> numberOfReactions(); r++ ){
+
+		double a = _network -> propensity( r );
+		if ( a <= 0.0 ) continue;
+
+		const Reaction &reaction = _network -> reaction( r );
+		bool consumes = false;
+		for ( auto c = reaction.changes.begin(); c < reaction.changes.end(); c++ ) consumes = consumes or ( c -> first == reaction.reactant and c -> second < 0 );
+
+		if ( consumes and _network -> count( reaction.reactant ) < criticalCopies ){
+
+			critical.push_back( r );
+			criticalSum += a;
+			continue;
+		}
+		nonCritical.push_back( r );
+		reactant[ reaction.reactant ] = true;
+		for ( auto c = reaction.changes.begin(); c < reaction.changes.end(); c++ ){
+
+			mean[ c -> first ] += c -> second * a;
+			variance[ c -> first ] += (double) c -> second * c -> second * a;
+		}
+	}
+
+	//the largest leap over which the expected change in each reactant, and its standard deviation, is at most epsilon of its count.  it's
+	//also kept short enough that it isn't expected to go over the maximum number of transitions, which ends in exact steps
+	double tauNonCritical = ( _maxTransitions - _transitionsTaken ) / a0;
+	for ( unsigned int s = 0; s < reactant.size(); s++ ){
+
+		if ( not reactant[s] ) continue;
+		double bound = std::max( _tauEpsilon * _network -> count( s ), 1.0 );
+		if ( mean[s] != 0.0 ) tauNonCritical = std::min( tauNonCritical, bound / std::fabs( mean[s] ) );
+		if ( variance[s] > 0.0 ) tauNonCritical = std::min( tauNonCritical, bound * bound / variance[s] );
+	}
+
+	std::vector< int64_t > change( _network -> numberOfSpecies() );
+	std::vector< uint64_t > firings( _network -> numberOfReactions() );
+	double tau;
+	while ( true ){
+
+		//a leap this short does no better than exact steps, which are cheaper and don't have to be checked for negative counts
+		if ( tauNonCritical < 10.0 / a0 ){
+
+			for ( unsigned int i = 0; i < exactSteps and _network -> totalPropensity() > 0.0 and _transitionsTaken < _maxTransitions and _totalTime <= _maxDuration; i++ ){
+
+				stepNetwork();
+				_transitionsTaken++;
+			}
+			return;
+		}
+
+		//the time to the next critical firing, which is the leap if it comes first.  a leap can always be cut short at the maximum duration
+		int criticalFired = -1;
+		double tauCritical = criticalSum > 0.0 ? _rng.exponential( criticalSum ) : HUGE_VAL;
+		if ( tauNonCritical < tauCritical ) tau = tauNonCritical;
+		else{
+
+			tau = tauCritical;
+			double target = _rng.uniform() * criticalSum;
+			for ( auto r = critical.begin(); r < critical.end(); r++ ){
+
+				criticalFired = *r;
+				target -= _network -> propensity( *r );
+				if ( target < 0.0 ) break;
+			}
+		}
+		if ( _maxDuration - _totalTime < tau ){
+
+			tau = _maxDuration - _totalTime;
+			criticalFired = -1;
+		}
+
+		std::fill( change.begin(), change.end(), 0 );
+		std::fill( firings.begin(), firings.end(), 0 );
+		if ( criticalFired >= 0 ) firings[criticalFired] = 1;
+		for ( auto r = nonCritical.begin(); r < nonCritical.end(); r++ ) firings[*r] = _rng.poisson( _network -> propensity( *r ) * tau );
+
+		for ( unsigned int r = 0; r < firings.size(); r++ ){
+
+			if ( firings[r] == 0 ) continue;
+			const Reaction &reaction = _network -> reaction( r );
+			for ( auto c = reaction.changes.begin(); c < reaction.changes.end(); c++ ) change[ c -> first ] += c -> second * (int64_t) firings[r];
+		}
+
+		//counts are unsigned ints, so a count that would go past what one can hold is as bad as one that would go negative
+		bool outOfRange = false;
+		for ( unsigned int s = 0; s < change.size(); s++ ){
+
+			int64_t after = (int64_t) _network -> count( s ) + change[s];
+			outOfRange = outOfRange or after < 0 or after > std::numeric_limits< unsigned int >::max();
+		}
+
+		//too long a leap for the populations involved, so try again with half of it
+		if ( not outOfRange ) break;
+		tauNonCritical /= 2.0;
+	}
+
+	//propensities are taken as constant over the leap, so each firing happens at a uniform time in it
+	if ( _sampleEvery > 0.0 ) writeSamples( _totalTime + tau );
+	else{
+
+		std::vector< std::pair< double, unsigned int > > events;
+		for ( unsigned int r = 0; r < firings.size(); r++ ){
+
+			for ( uint64_t k = 0; k < firings[r]; k++ ) events.push_back( std::make_pair( _totalTime + _rng.uniform() * tau, r ) );
+		}
+		std::sort( events.begin(), events.end() );
+		for ( auto e = events.begin(); e < events.end(); e++ ) writeTransition( e -> first, _network -> reaction( e -> second ).transition, _outputStream );
 	}
+	for ( unsigned int r = 0; r < firings.size(); r++ ) _transitionsTaken += firings[r];
+	_totalTime += tau;
+
+	for ( unsigned int s = 0; s < change.size(); s++ ){
+
+		if ( change[s] == 0 ) continue;
+		if ( not _network -> isExpanded( s ) ) expandSpecies( s );
+		_network -> changeCount( s, change[s] );
+	}
+	collectSpecies();
 }
 
 
-void simulateSystem( std::map< std::string, ProcessDefinition > &name2ProcessDef, std::list< SystemProcess > &system, GlobalVariables &globalVars, int numOfSimulations, int threads, std::string outputFilename, int maxTransitions, double maxDuration ){
+void System::simulate(void){
+
+	if ( _network != NULL and _engine == ENGINE_TAU ){
+
+		while ( _network -> totalPropensity() > 0.0 and _transitionsTaken < _maxTransitions and _totalTime < _maxDuration ) leapNetwork();
+
+		//a leap can end exactly at the maximum duration, where there's still a sample to write
+		if ( _sampleEvery > 0.0 and ( _network -> totalPropensity() == 0.0 or _totalTime >= _maxDuration ) and _maxDuration < std::numeric_limits<double>::max() ) writeSamples( std::nextafter( _maxDuration, HUGE_VAL ) );
+		return;
+	}
+	if ( _network != NULL ){
+
+		while ( _network -> totalPropensity() > 0.0 and _transitionsTaken < _maxTransitions and _totalTime <= _maxDuration ){
+
+			stepNetwork();
+			_transitionsTaken++;
+		}
+		if ( _sampleEvery > 0.0 and _network -> totalPropensity() == 0.0 and _maxDuration < std::numeric_limits<double>::max() ) writeSamples( std::nextafter( _maxDuration, HUGE_VAL ) );
+		return;
+	}
+
+	while ( _scheduler.candidatesLeft() > 0 and _transitionsTaken < _maxTransitions and _totalTime <= _maxDuration ){
+
+		//with --fast, fast transitions go first for as long as they come before the next slow one, which then fires
+		if ( _scheduler.fastPending() ){
+
+			resolveFastChain();
+			if ( _scheduler.candidatesLeft() == _scheduler.fastLeft() or _transitionsTaken >= _maxTransitions or _totalTime > _maxDuration ) continue;
+		}
+
+		std::list< SystemProcess * > toAdd;
+		if ( _engine == ENGINE_NRM ) stepNextReaction( toAdd );
+		else stepDirect( toAdd );
+		addProcesses( toAdd );
+		_transitionsTaken++;
+	}
+
+	//a deadlocked system stays as it is, so its state is known at every sample time up to the maximum duration
+	if ( _sampleEvery > 0.0 and _scheduler.candidatesLeft() == 0 and _maxDuration < std::numeric_limits<double>::max() ) writeSamples( std::nextafter( _maxDuration, HUGE_VAL ) );
+}
+
+
+static void selectRecordedBlocks( std::map< std::string, ProcessDefinition > &name2ProcessDef, const SimulationOptions &options ){
+//work out once which blocks' transitions are written, so that writing a transition only has to check a bit on its block.
+//with action or channel filters, only the actions and channels named are written, and process filters narrow that to the processes named
+
+	bool filterNames = not options.recordActions.empty() or not options.recordChannels.empty();
+	bool filterProcesses = not options.recordProcesses.empty();
+	std::set< std::string > actions( options.recordActions.begin(), options.recordActions.end() );
+	std::set< std::string > channels( options.recordChannels.begin(), options.recordChannels.end() );
+	std::set< std::string > processes( options.recordProcesses.begin(), options.recordProcesses.end() );
+	std::set< std::string > actionsFound, channelsFound, processesFound;
+
+	for ( auto pd = name2ProcessDef.begin(); pd != name2ProcessDef.end(); pd++ ){
+
+		const CompiledProcess *cp = (pd -> second).compiled.get();
+		bool processRecorded = not filterProcesses or processes.count( pd -> first ) > 0;
+		if ( processes.count( pd -> first ) > 0 ) processesFound.insert( pd -> first );
+
+		for ( unsigned int i = 0; i < cp -> numberOfNodes(); i++ ){
+
+			Block *b = cp -> block( i );
+			bool nameRecorded = not filterNames;
+			switch ( b -> kind() ){
+
+				case BLOCK_ACTION:{
+
+					const std::string &name = static_cast< ActionBlock * >( b ) -> actionName;
+					if ( actions.count( name ) > 0 ){
+
+						nameRecorded = true;
+						actionsFound.insert( name );
+					}
+					break;
+				}
+				case BLOCK_MESSAGE_SEND:
+				case BLOCK_MESSAGE_RECEIVE:{
+
+					std::string name = System::writeChannelName( b -> kind() == BLOCK_MESSAGE_SEND ? static_cast< MessageSendBlock * >( b ) -> getChannelName() : static_cast< MessageReceiveBlock * >( b ) -> getChannelName() );
+					name = name.substr( 0, name.find( ',' ) );
+					if ( channels.count( name ) > 0 ){
+
+						nameRecorded = true;
+						channelsFound.insert( name );
+					}
+					break;
+				}
+				default:
+					break;
+			}
+			b -> setRecorded( nameRecorded and processRecorded );
+		}
+	}
+
+	//a name that isn't in the model is almost certainly a typo, and would otherwise quietly write nothing for it
+	for ( auto a = actions.begin(); a != actions.end(); a++ ) if ( actionsFound.count( *a ) == 0 ) throw BadRecordFilter( "action", *a );
+	for ( auto c = channels.begin(); c != channels.end(); c++ ) if ( channelsFound.count( *c ) == 0 ) throw BadRecordFilter( "channel", *c );
+	for ( auto p = processes.begin(); p != processes.end(); p++ ) if ( processesFound.count( *p ) == 0 ) throw BadRecordFilter( "process", *p );
+}
+
+
+static void summarizeSystem( std::map< std::string, ProcessDefinition > &name2ProcessDef, std::list< SystemProcess > &system, GlobalVariables &globalVars, const SimulationOptions &options ){
+//run the simulations without writing them out, keeping only the time-binned statistics that the summary selectors ask for
+
+	double gridStop = options.gridStop, gridWidth = options.gridWidth;
+	if ( gridWidth == 0.0 ){
+
+		if ( options.maxDuration == std::numeric_limits<double>::max() ) throw BadSummaryGrid();
+		gridStop = options.maxDuration;
+		gridWidth = ( gridStop - options.gridStart ) / 100.0;
+	}
+	SummaryPlan plan( name2ProcessDef, options.summarySelectors, options.gridStart, gridStop, gridWidth );
+	SummaryAccumulator total( plan );
+
+	std::ofstream outFile( options.outputFilename );
+	if ( not outFile.is_open() ) throw BadOutputPath();
+
+	int numOfSimulations = options.numOfSimulations;
+	progressBar pb( numOfSimulations );
+	uint64_t seed = options.seedSpecified ? options.seed : randomSeed();
+	int numCompleted = 0;
+
+	//each thread keeps its own statistics and they're merged at the end, so threads never wait on each other
+	#pragma omp parallel shared(pb, system, globalVars, numCompleted, total) num_threads( options.threads )
+	{
+		SummaryAccumulator local( plan );
+
+		#pragma omp for schedule(dynamic)
+		for ( int i = 0; i < numOfSimulations; i++ ){
+
+			System systemLocal( system, options, globalVars, seed, i, NULL, NULL, &local );
+			systemLocal.simulate();
+			local.endSimulation();
+
+			#pragma omp critical
+			{
+			numCompleted++;
+			pb.displayProgress( numCompleted );
+			}
+		}
+
+		#pragma omp critical
+		total.merge( local );
+	}
+
+	plan.write( outFile, total );
+	std::cout << std::endl;
+}
+
+
+static std::string networkFallback( std::map< std::string, ProcessDefinition > &name2ProcessDef, std::list< SystemProcess > &system, GlobalVariables &globalVars, const SimulationOptions &options ){
+//why the model can't be simulated as a reaction network, or empty if it can.  counters and the like can keep making new species, each
+//of which is kept until it runs out, so the species reachable from the system line are worked out first
+
+	if ( not isReactionNetwork( name2ProcessDef, system ) ) return "Model uses beacons or handshakes, so it isn't a reaction network.";
+
+	bool finite;
+	try{
+
+		System network( system, options, globalVars, 0, 0, NULL, NULL );
+		finite = network.exploreNetwork();
+	}
+	catch ( const std::exception &e ){
+
+		return "Could not work out every reaction of the model (" + std::string( e.what() ) + "), so it isn't simulated as a reaction network.";
+	}
+	if ( not finite ) return "Model reaches more than " + std::to_string( ReactionNetwork::maxSpecies ) + " species (processes in distinct states), so it isn't simulated as a reaction network.";
+	return "";
+}
+
+
+void simulateSystem( std::map< std::string, ProcessDefinition > &name2ProcessDef, std::list< SystemProcess > &system, GlobalVariables &globalVars, const SimulationOptions &requestedOptions ){
+
+	//only models without beacons or handshakes that reach a limited number of species are simulated as reaction networks, and anything
+	//else is simulated by the direct method
+	SimulationOptions options = requestedOptions;
+	if ( options.engine == ENGINE_CRN or options.engine == ENGINE_TAU ){
+
+		std::string reason = networkFallback( name2ProcessDef, system, globalVars, options );
+		if ( not reason.empty() ){
+
+			std::cout << reason << "  Simulating with the direct method instead." << std::endl;
+			options.engine = ENGINE_DIRECT;
+		}
+	}
+
+	//fast transitions are raced against the firing time of each slow transition, which only the next reaction method keeps
+	if ( options.fastRate < std::numeric_limits<double>::infinity() and options.engine == ENGINE_DIRECT ){
+
+		std::cout << "Fast transitions need the next reaction method.  Simulating with -e nrm instead." << std::endl;
+		options.engine = ENGINE_NRM;
+	}
+
+	if ( not options.summarySelectors.empty() ){
+
+		summarizeSystem( name2ProcessDef, system, globalVars, options );
+		return;
+	}
+
+	selectRecordedBlocks( name2ProcessDef, options );
+
+	TrajectoryWriter writer( options.outputFilename, options.writeIndex ? options.outputFilename + ".idx" : "", options.format == FORMAT_BIN, options.ordered, options.outputBuffer );
+	int numOfSimulations = options.numOfSimulations;
+
+	//binary output starts with a dictionary of the names in the model
+	std::unique_ptr< BinaryDictionary > binary;
+	if ( options.format == FORMAT_BIN ){
+
+		binary.reset( new BinaryDictionary( name2ProcessDef ) );
+		TrajectoryStream header( writer, -1 );
+		std::ostream headerStream( &header );
+		binary -> writeHeader( headerStream );
+		header.close( 0, 0.0 );
+	}
 
-	std::ofstream outFile( outputFilename );
 	progressBar pb( numOfSimulations );
+
+	//each simulation gets its own random stream from the seed and its index, so results don't depend on the number of threads
+	uint64_t seed = options.seedSpecified ? options.seed : randomSeed();
 	int numCompleted = 0;
 
 	/*each simulation */
-	#pragma omp parallel for schedule(dynamic) shared(pb, system, globalVars, numCompleted) num_threads( threads )
+	#pragma omp parallel for schedule(dynamic) shared(pb, system, globalVars, numCompleted) num_threads( options.threads )
 	for ( int i = 0; i < numOfSimulations; i++ ){
 
-		System systemLocal( system, name2ProcessDef, maxTransitions, maxDuration, globalVars );
+		//the trajectory goes to the writer thread in chunks while the simulation runs
+		TrajectoryStream trajectory( writer, i );
+		std::ostream start( &trajectory );
+		if ( binary != NULL ) binary -> writeSimulationStart( start );
+		else start << ">=======" << std::endl;
+		System systemLocal( system, options, globalVars, seed, i, &trajectory, binary.get() );
 		systemLocal.simulate();
-		numCompleted++;
+		trajectory.close( systemLocal.transitionsTaken(), systemLocal.totalTime() );
 
 		#pragma omp critical 
 		{
+		numCompleted++;
 		pb.displayProgress( numCompleted );
-		outFile << ">=======" << std::endl;
-		outFile << systemLocal.write();
 		}
 	}
+	writer.close();
 	std::cout << std::endl;
 }
@@ -12,32 +12,131 @@
 #include <memory>
 #include <chrono>
 #include <list>
+#include <set>
 #include <iomanip>
 #include <sstream>
 #include <iterator>
+#include <limits>
 #include "error_handling.h"
 #include "handshake.h"
 #include "beacon.h"
+#include "scheduler.h"
+#include "random.h"
+#include "output.h"
+#include "binary.h"
+#include "summary.h"
+#include "reaction_network.h"
+
+
+struct SimulationOptions{
+//user-specified settings that control how simulations are run and written out
+
+	int numOfSimulations = 1;
+	int threads = 1;
+	std::string outputFilename;
+	int maxTransitions = 1000000;
+	double maxDuration = std::numeric_limits<double>::max();
+	int engine = ENGINE_DIRECT;
+	double fastRate = std::numeric_limits<double>::infinity(); //runs of transitions at this rate or faster are written as their last transition
+	double tauEpsilon = 0.03; //with -e tau, the largest relative change in a species count expected over a leap
+	int format = FORMAT_TEXT;
+	bool writeIndex = false;
+	bool ordered = false; //write simulations in index order, so the output doesn't depend on the number of threads
+	uint64_t outputBuffer = 2048 * 1024; //bytes of a simulation's output held in memory while the writer is busy, before the rest is set aside
+	std::vector< std::string > summarySelectors; //if any are given, write time-binned statistics instead of trajectories
+	double gridStart = 0.0, gridStop = 0.0, gridWidth = 0.0; //a width of zero means 100 bins up to maxDuration
+	std::vector< std::string > recordActions, recordChannels, recordProcesses; //if any are given, only write the transitions they pick out
+	double sampleEvery = 0.0; //if positive, write the state of the system at multiples of this time instead of each transition
+	bool lump = false; //keep identical processes as one system process with a count
+	bool seedSpecified = false;
+	uint64_t seed = 0;
+};
+
+
+struct ChannelOrder{
+//order channels by name, the same order as the name-keyed channel maps, so visiting a subset of channels is deterministic
+
+	template< class Channel >
+	bool operator()( const Channel *a, const Channel *b ) const { return a -> getChannelName() < b -> getChannelName(); }
+};
+
 
 class System{
 
 	private: 
 		std::list< SystemProcess * > _currentProcesses;
 		GlobalVariables _globalVars;
-		double _rateSum = 0.0, _totalTime = 0.0, _maxDuration;
-		int _transitionsTaken = 0, _maxTransitions, _candidatesLeft = 0;
-
-		std::map< SystemProcess * , std::vector< std::shared_ptr<Candidate> > > _nonMsgCandidates;
-		std::map< std::vector<std::string>, std::shared_ptr<BeaconChannel> > _beacons_Name2Channel;
-		std::map< std::vector<std::string>, std::shared_ptr<HandshakeChannel> > _handshakes_Name2Channel;
-
-		std::map< std::string, ProcessDefinition > _name2ProcessDef;
-		std::stringstream _outputStream;
-
-		void splitOnParallel( SystemProcess *, Block *, std::list< SystemProcess * > & );
+		double _totalTime = 0.0, _maxDuration;
+		int _transitionsTaken = 0, _maxTransitions, _engine;
+		unsigned int _nextProcessId = 0;
+		bool _inFastChain = false;
+		std::shared_ptr< Candidate > _chainOutcome; //the last transition of a chain of fast transitions that would have been written
+		RandomStream _rng;
+		TransitionScheduler _scheduler;
+
+		std::map< SystemProcess *, std::vector< std::shared_ptr<Candidate> >, SystemProcessOrder > _nonMsgCandidates;
+		std::unordered_map< ChannelKey, std::shared_ptr<BeaconChannel>, TupleHash > _beaconChannels;
+		std::unordered_map< ChannelKey, std::shared_ptr<HandshakeChannel>, TupleHash > _handshakeChannels;
+
+		//channels whose names never change, by their interned id, filled in the first time each one is used
+		std::vector< BeaconChannel * > _constantBeaconChannels;
+		std::vector< HandshakeChannel * > _constantHandshakeChannels;
+		ChannelKey _channelKey; //scratch space for working out channel names that do change
+
+		//dependency graph from each system process to the channels it has candidates on (channels already index their candidates by process),
+		//so that a transition only revisits the channels it touches
+		std::map< SystemProcess *, std::set< BeaconChannel *, ChannelOrder >, SystemProcessOrder > _sp2BeaconChannels;
+		std::map< SystemProcess *, std::set< HandshakeChannel *, ChannelOrder >, SystemProcessOrder > _sp2HandshakeChannels;
+		std::set< HandshakeChannel *, ChannelOrder > _handshakesToUpdate;
+
+		std::ostream _outputStream;
+		const BinaryDictionary *_binary; //NULL if the output is text
+		uint64_t _lastTimeWritten = 0; //bit pattern of the last time in a binary record
+		SummaryAccumulator *_summary; //NULL unless transitions go to summary statistics rather than the output
+		double _sampleEvery; //0 if every transition is written
+		uint64_t _nextSample = 0; //the next multiple of _sampleEvery to write the state at
+
+		//with --lump, identical processes are one system process with a count, filed under a key for the state they're in.  each keeps
+		//the parameter values it was made with, because summing rates changes them and they're summed again whenever the count changes
+		bool _lump;
+		std::unordered_map< std::string, SystemProcess * > _lumps;
+		std::unordered_map< SystemProcess *, std::pair< std::string, ParameterValues > > _sp2Lump;
+		std::set< SystemProcess *, SystemProcessOrder > _lumpsToResum;
+		std::unordered_map< Block *, bool > _lumpable;
+
+		//with -e crn, the system is a reaction network whose species are the system processes, and the actions a species can do are
+		//found by summing its rates into _speciesActions instead of the scheduler
+		std::unique_ptr< ReactionNetwork > _network;
+		std::vector< std::shared_ptr< Candidate > > _speciesActions;
+		double _tauEpsilon;
+
+		void splitOnParallel( SystemProcess *, unsigned int, std::list< SystemProcess * > & );
+		void stepDirect( std::list< SystemProcess * > & );
+		void stepNextReaction( std::list< SystemProcess * > & );
+		void resolveFastChain( void );
+		void addProcesses( std::list< SystemProcess * > & );
+		void fireNonMsg( std::shared_ptr<Candidate>, std::list< SystemProcess * > & );
+		void fireBeacon( std::shared_ptr<Candidate>, BeaconChannel *, std::list< SystemProcess * > & );
+		void fireHandshake( std::shared_ptr<HandshakeCandidate>, std::list< SystemProcess * > & );
+		void fireTransition( ScheduledTransition &, std::list< SystemProcess * > & );
+		const ChannelKey &channelKey( const std::vector< Bytecode > &, ParameterValues &, VariableFrame & );
+		BeaconChannel *beaconChannel( int, const std::vector< Bytecode > &, ParameterValues &, VariableFrame & );
+		HandshakeChannel *handshakeChannel( int, const std::vector< Bytecode > &, ParameterValues &, VariableFrame & );
+		void updateHandshakes( void );
+		void writeSamples( double );
+		void resolveCalls( SystemProcess * );
+		bool lumpable( const CompiledProcess *, unsigned int );
+		std::string lumpKey( SystemProcess * );
+		void lumpProcesses( std::list< SystemProcess * > & );
+		void withdrawCandidates( SystemProcess * );
+		void toSpecies( std::list< SystemProcess * > &, std::vector< unsigned int > & );
+		void expandSpecies( unsigned int );
+		void stepNetwork( void );
+		void collectSpecies( void );
+		void leapNetwork( void );
 
 	public:
-		System( std::list< SystemProcess > &, std::map< std::string, ProcessDefinition > &, int, double , GlobalVariables & );
+		System( std::list< SystemProcess > &, const SimulationOptions &, GlobalVariables &, uint64_t, uint64_t, std::streambuf *, const BinaryDictionary *, SummaryAccumulator * = NULL );
 		~System(){
 
 			for ( auto i = _currentProcesses.begin(); i != _currentProcesses.end(); i++ ){
@@ -45,18 +144,18 @@ class System{
 				delete *i;
 			}
 		}
-		void writeTransition( double , std::shared_ptr<Candidate>, std::stringstream & );
-		std::string writeChannelName( std::vector< std::vector< Token * > > );
-		std::vector< std::string > substituteChannelName( std::vector< std::vector< Token * > >, ParameterValues &, std::map< std::string, Numerical > & );
-		void sumTransitionRates( SystemProcess *, Tree<Block> &, Block *, std::list< SystemProcess >, ParameterValues & );
+		void writeTransition( double , std::shared_ptr<Candidate>, std::ostream & );
+		static std::string writeChannelName( const std::vector< Bytecode > & );
+		void sumTransitionRates( SystemProcess *, const CompiledProcess *, unsigned int, const std::shared_ptr< const ParallelContinuation > &, ParameterValues & );
 		void updateSystem( std::shared_ptr<Candidate>, std::list< SystemProcess * > & );
-		void splitOnParallel(SystemProcess &, Block *, std::list< SystemProcess> & );
 		void simulate( void );
-		std::streambuf *write( void ){ return _outputStream.rdbuf(); }
-		void removeChosenFromSystem( std::shared_ptr<Candidate>, bool );
+		bool exploreNetwork( void );
+		int transitionsTaken( void ) const { return _transitionsTaken; }
+		double totalTime( void ) const { return _totalTime; }
+		void removeChosenFromSystem( std::shared_ptr<Candidate>, BeaconChannel * );
 		void getParallelProcesses( std::shared_ptr<Candidate>, std::list< SystemProcess * > & );
 		SystemProcess * updateSpForTransition( std::shared_ptr<Candidate> );
-		bool variableIsDefined(std::string, ParameterValues &, std::map< std::string, Numerical > &);
+		bool variableIsDefined(unsigned int, ParameterValues &, VariableFrame &);
 		void printTransition(double, std::shared_ptr<Candidate>);
 };
 
@@ -110,6 +209,6 @@ class progressBar{
 };
 
 
-void simulateSystem( std::map< std::string, ProcessDefinition > &, std::list< SystemProcess > &, GlobalVariables &, int, int, std::string, int, double );
+void simulateSystem( std::map< std::string, ProcessDefinition > &, std::list< SystemProcess > &, GlobalVariables &, const SimulationOptions & );
 
 #endif
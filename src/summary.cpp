@@ -0,0 +1,200 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "summary.h"
+#include "error_handling.h"
+#include "simulator.h"
+
+
+/*WELFORD ACCUMULATORS--------------------------------------------------------------------------------------------------------------------------------------------*/
+void Welford::merge( const Welford &other ){
+
+	if ( other.n == 0 ) return;
+	if ( n == 0 ){
+
+		*this = other;
+		return;
+	}
+
+	uint64_t total = n + other.n;
+	double delta = other.mean - mean;
+	mean += delta * other.n / total;
+	m2 += other.m2 + delta * delta * ( (double) n * other.n / total );
+	n = total;
+}
+
+
+double Welford::variance( void ) const {
+//sample variance, which isn't defined for fewer than two values
+
+	if ( n < 2 ) return std::numeric_limits< double >::quiet_NaN();
+	return m2 / ( n - 1 );
+}
+
+
+/*SELECTORS-------------------------------------------------------------------------------------------------------------------------------------------------------*/
+SummarySelector::SummarySelector( const std::string &s ) : text( s ){
+
+	std::vector< std::string > fields;
+	size_t start = 0;
+	while ( true ){
+
+		size_t end = s.find( ':', start );
+		fields.push_back( s.substr( start, end == std::string::npos ? std::string::npos : end - start ) );
+		if ( end == std::string::npos ) break;
+		start = end + 1;
+	}
+	if ( fields.size() > 3 or fields[0].empty() ) throw BadSummarySelector( s );
+
+	name = fields[0];
+	if ( fields.size() > 1 and fields[1] != "*" ) process = fields[1];
+	if ( fields.size() > 2 and fields[2] != "*" ) parameter = fields[2];
+}
+
+
+static std::string transitionName( Block *b ){
+//the name a transition at this block is written with in the trajectory, or empty if it isn't written
+
+	switch ( b -> kind() ){
+
+		case BLOCK_ACTION:
+			return static_cast< ActionBlock * >( b ) -> actionName;
+		case BLOCK_MESSAGE_SEND:
+			return System::writeChannelName( static_cast< MessageSendBlock * >( b ) -> getChannelName() );
+		case BLOCK_MESSAGE_RECEIVE:
+			return System::writeChannelName( static_cast< MessageReceiveBlock * >( b ) -> getChannelName() );
+		default:
+			return "";
+	}
+}
+
+
+/*SUMMARY PLAN----------------------------------------------------------------------------------------------------------------------------------------------------*/
+SummaryPlan::SummaryPlan( std::map< std::string, ProcessDefinition > &processName2Definition, const std::vector< std::string > &selectors, double start, double stop, double width ) : _start( start ), _stop( stop ), _width( width ){
+
+	if ( not ( width > 0.0 ) or not ( stop > start ) or std::isinf( width ) ) throw BadSummaryGrid();
+	double bins = std::ceil( ( stop - start ) / width );
+	if ( not ( bins <= 1e7 ) ) throw BadSummaryGrid();
+	_bins = std::max( 1.0, bins );
+
+	for ( auto s = selectors.begin(); s < selectors.end(); s++ ) _selectors.push_back( SummarySelector( *s ) );
+
+	std::vector< bool > used( _selectors.size(), false );
+	for ( auto pd = processName2Definition.begin(); pd != processName2Definition.end(); pd++ ){
+
+		const CompiledProcess *cp = (pd -> second).compiled.get();
+		std::vector< std::vector< SummaryMatch > > &nodes = _nodeMatches[cp];
+		nodes.resize( cp -> numberOfNodes() );
+
+		for ( unsigned int i = 0; i < cp -> numberOfNodes(); i++ ){
+
+			std::string name = transitionName( cp -> block( i ) );
+			if ( name.empty() ) continue;
+
+			for ( unsigned int s = 0; s < _selectors.size(); s++ ){
+
+				const SummarySelector &sel = _selectors[s];
+				if ( sel.name != "*" and sel.name != name ) continue;
+				if ( not sel.process.empty() and sel.process != pd -> first ) continue;
+
+				SummaryMatch m = { s, -1 };
+				if ( not sel.parameter.empty() ){
+
+					auto p = std::find( (cp -> parameters).begin(), (cp -> parameters).end(), sel.parameter );
+					if ( p == (cp -> parameters).end() ) continue;
+					m.parameterSlot = (cp -> parameterSlots)[ p - (cp -> parameters).begin() ];
+				}
+				nodes[i].push_back( m );
+				used[s] = true;
+			}
+		}
+	}
+
+	//a selector that matches nothing is almost certainly a typo, and would otherwise just give a table of zeros
+	for ( unsigned int s = 0; s < _selectors.size(); s++ ){
+
+		if ( not used[s] ) throw BadSummarySelector( _selectors[s].text );
+	}
+}
+
+
+void SummaryPlan::write( std::ostream &out, const SummaryAccumulator &acc ) const {
+
+	out << "selector\tbinStart\tbinEnd\tsimulations\tcountMean\tcountVariance\tvalues\tvalueMean\tvalueVariance" << std::endl;
+	for ( unsigned int s = 0; s < _selectors.size(); s++ ){
+
+		for ( unsigned int k = 0; k < _bins; k++ ){
+
+			const Welford &counts = acc.counts( s, k );
+			out << _selectors[s].text << '\t' << _start + k * _width << '\t' << std::min( _start + ( k + 1 ) * _width, _stop );
+			out << '\t' << counts.n << '\t' << counts.mean << '\t' << counts.variance();
+
+			if ( _selectors[s].parameter.empty() ) out << "\t0\tnan\tnan";
+			else{
+
+				const Welford &values = acc.values( s, k );
+				out << '\t' << values.n << '\t' << ( values.n > 0 ? values.mean : std::numeric_limits< double >::quiet_NaN() ) << '\t' << values.variance();
+			}
+			out << std::endl;
+		}
+	}
+}
+
+
+/*SUMMARY ACCUMULATOR---------------------------------------------------------------------------------------------------------------------------------------------*/
+SummaryAccumulator::SummaryAccumulator( const SummaryPlan &plan ) : _plan( plan ){
+
+	unsigned int size = plan.numberOfSelectors() * plan.numberOfBins();
+	_simulationCounts.resize( size, 0 );
+	_counts.resize( size );
+	_values.resize( size );
+}
+
+
+void SummaryAccumulator::record( double time, Block *actionDone, ParameterValues &parameterValues ){
+
+	const std::vector< SummaryMatch > &matches = _plan.matches( actionDone );
+	if ( matches.empty() ) return;
+
+	int k = _plan.bin( time );
+	if ( k < 0 ) return;
+
+	for ( auto m = matches.begin(); m < matches.end(); m++ ){
+
+		unsigned int i = m -> selector * _plan.numberOfBins() + k;
+		_simulationCounts[i]++;
+		if ( m -> parameterSlot >= 0 and parameterValues.isDefined( m -> parameterSlot ) ){
+
+			Numerical val = parameterValues.getValue( m -> parameterSlot );
+			_values[i].add( val.isInt() ? (double) val.getInt() : val.getDouble() );
+		}
+	}
+}
+
+
+void SummaryAccumulator::endSimulation( void ){
+
+	for ( unsigned int i = 0; i < _simulationCounts.size(); i++ ){
+
+		_counts[i].add( _simulationCounts[i] );
+		_simulationCounts[i] = 0;
+	}
+}
+
+
+void SummaryAccumulator::merge( const SummaryAccumulator &other ){
+
+	for ( unsigned int i = 0; i < _counts.size(); i++ ){
+
+		_counts[i].merge( other._counts[i] );
+		_values[i].merge( other._values[i] );
+	}
+}
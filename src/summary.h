@@ -0,0 +1,103 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <ostream>
+#include <cstdint>
+#include "blockParser.h"
+
+//summary mode (--summary) keeps time-binned statistics of the transitions picked out by each selector instead of writing trajectories.
+//a selector is name[:process[:parameter]], where name is an action or channel name as it's written in the trajectory, and * or a
+//missing field matches anything.  for each selector and time bin, the output has the mean and variance over simulations of the number
+//of matching transitions in the bin and, if a parameter is given, the mean and variance of that parameter's value over all of them
+
+
+struct Welford{
+//running mean and sum of squared deviations, which can be merged with another one (Chan et al.) so each thread can keep its own
+
+	uint64_t n = 0;
+	double mean = 0.0, m2 = 0.0;
+
+	void add( double x ){
+
+		n++;
+		double delta = x - mean;
+		mean += delta / n;
+		m2 += delta * ( x - mean );
+	}
+	void merge( const Welford & );
+	double variance( void ) const;
+};
+
+
+struct SummarySelector{
+
+	std::string text, name, process, parameter;
+	SummarySelector( const std::string & );
+};
+
+
+class SummaryAccumulator;
+
+
+struct SummaryMatch{
+
+	unsigned int selector;
+	int parameterSlot; //-1 if the selector doesn't ask for a parameter
+};
+
+
+class SummaryPlan{
+//the time grid and, for each node of each process, the selectors that a transition there matches
+
+	private:
+		std::vector< SummarySelector > _selectors;
+		double _start, _stop, _width;
+		unsigned int _bins;
+		std::unordered_map< const CompiledProcess *, std::vector< std::vector< SummaryMatch > > > _nodeMatches;
+
+	public:
+		SummaryPlan( std::map< std::string, ProcessDefinition > &, const std::vector< std::string > &, double, double, double );
+		unsigned int numberOfSelectors( void ) const { return _selectors.size(); }
+		unsigned int numberOfBins( void ) const { return _bins; }
+		const std::vector< SummaryMatch > &matches( Block *b ) const { return _nodeMatches.find( b -> getDefinition() ) -> second[ b -> getNode() ]; }
+		int bin( double time ) const {
+
+			if ( time < _start or time >= _stop ) return -1;
+			unsigned int k = ( time - _start ) / _width;
+			return k < _bins ? k : _bins - 1;
+		}
+		void write( std::ostream &, const SummaryAccumulator & ) const;
+};
+
+
+class SummaryAccumulator{
+//statistics from the simulations one thread has run.  counts in the running simulation are kept as integers and only go into the
+//accumulators when it ends, so that bins where nothing happened are counted as zeros
+
+	private:
+		const SummaryPlan &_plan;
+		std::vector< uint64_t > _simulationCounts; //selector * bins + bin
+		std::vector< Welford > _counts, _values;
+
+	public:
+		SummaryAccumulator( const SummaryPlan & );
+		void record( double, Block *, ParameterValues & );
+		void endSimulation( void );
+		void merge( const SummaryAccumulator & );
+		const Welford &counts( unsigned int selector, unsigned int bin ) const { return _counts[ selector * _plan.numberOfBins() + bin ]; }
+		const Welford &values( unsigned int selector, unsigned int bin ) const { return _values[ selector * _plan.numberOfBins() + bin ]; }
+};
+
+#endif
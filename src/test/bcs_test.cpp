@@ -22,17 +22,16 @@ static const char *test_help=
 "Example:\n"
 "  ./bcs_test sourceCode.bc\n"
 "Optional arguments are:\n"
-"  --shouldFail              model passed is expected to fail instead of pass (default is pass).";
+"  --shouldFail              model passed is expected to fail instead of pass (default is pass),\n"
+"  --engine                  simulation algorithm to test: direct, nrm, crn, or tau (default: direct),\n"
+"  --lump                    simulate identical processes as one process with a count,\n"
+"  --fast                    resolve each chain of transitions at this rate or faster in one step.";
 
 
 struct Arguments {
 
 	std::string targetFilename;
-	std::string outputFilename;
-	int threads;
-	int numOfSimulations;
-	int maxTrans;
-	double maxDuration;
+	SimulationOptions options;
 	bool shouldFail;
 };
 
@@ -54,11 +53,7 @@ Arguments parseTestArguments( int argc, char** argv ){
 	Arguments args;
 
 	/*defaults - we'll override these if the option was specified by the user */
-	args.outputFilename = "test.simulation.bcs";
-	args.threads = 1;
-	args.numOfSimulations = 1;
-	args.maxTrans = 1000000;
-	args.maxDuration = std::numeric_limits<double>::max();
+	args.options.outputFilename = "test.simulation.bcs";
 	args.shouldFail = false;
 
 	/*parse the command line arguments */
@@ -71,6 +66,25 @@ Arguments parseTestArguments( int argc, char** argv ){
 			args.shouldFail = true;
 			i++;
 		}
+		else if ( flag == "--engine" and i + 1 < argc ){
+
+			std::string strArg( argv[ i + 1 ] );
+			if ( strArg == "nrm" ) args.options.engine = ENGINE_NRM;
+			else if ( strArg == "crn" ) args.options.engine = ENGINE_CRN;
+			else if ( strArg == "tau" ) args.options.engine = ENGINE_TAU;
+			else args.options.engine = ENGINE_DIRECT;
+			i+=2;
+		}
+		else if ( flag == "--fast" and i + 1 < argc ){
+
+			args.options.fastRate = atof( argv[ i + 1 ] );
+			i+=2;
+		}
+		else if ( flag == "--lump" ){
+
+			args.options.lump = true;
+			i++;
+		}
 		else{
 
 			if ( flag.substr(0,1) == "-" ){
@@ -107,7 +121,7 @@ int main( int argc, char** argv ){
 		auto blockParsed = secondPassParse( std::get<0>(parsedSource), std::get<1>(parsedSource), std::get<2>(parsedSource) );
 
 		/*call the simulator */
-		simulateSystem( blockParsed.first, blockParsed.second, std::get<2>(parsedSource), args.numOfSimulations, args.threads, args.outputFilename, args.maxTrans, args.maxDuration );
+		simulateSystem( blockParsed.first, blockParsed.second, std::get<2>(parsedSource), args.options );
 
 		if (not args.shouldFail) std::cout << "PASS" << std::endl;
 		else std::cout << "FAIL" << std::endl;
@@ -0,0 +1,224 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <streambuf>
+#include <istream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "trajectory_index.h"
+#include "binary.h"
+#include "error_handling.h"
+
+
+static void putUint64( std::ostream &out, uint64_t v ){
+
+	for ( unsigned int b = 0; b < 8; b++ ) out.put( (char) ( ( v >> ( 8 * b ) ) & 0xff ) );
+}
+
+
+static uint64_t getUint64( const char *p ){
+
+	uint64_t v = 0;
+	for ( unsigned int b = 0; b < 8; b++ ) v |= (uint64_t) (unsigned char) p[b] << ( 8 * b );
+	return v;
+}
+
+
+static const size_t indexHeaderSize = sizeof( indexMagic ) - 1 + 2 + 24;
+static const size_t indexEntrySize = 40;
+
+
+void writeIndex( const std::string &filename, bool binary, uint64_t dataStart, uint64_t trajectorySize, const std::vector< IndexEntry > &entries ){
+
+	std::ofstream out( filename, std::ios::binary );
+	if ( not out.is_open() ) throw BadOutputPath();
+
+	out.write( indexMagic, sizeof( indexMagic ) - 1 );
+	out.put( (char) indexVersion );
+	out.put( binary ? 1 : 0 );
+	putUint64( out, dataStart );
+	putUint64( out, trajectorySize );
+	putUint64( out, entries.size() );
+	for ( auto e = entries.begin(); e < entries.end(); e++ ){
+
+		uint64_t timeBits;
+		memcpy( &timeBits, &( e -> finalTime ), sizeof( timeBits ) );
+		putUint64( out, e -> simulation );
+		putUint64( out, e -> offset );
+		putUint64( out, e -> length );
+		putUint64( out, e -> transitions );
+		putUint64( out, timeBits );
+	}
+}
+
+
+static const char *mapFile( const std::string &filename, size_t &size ){
+//map a whole file read-only, or return NULL for an empty file
+
+	int fd = open( filename.c_str(), O_RDONLY );
+	if ( fd < 0 ) throw BadSourcePath();
+
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 ){
+
+		close( fd );
+		throw BadSourcePath();
+	}
+	size = st.st_size;
+	if ( size == 0 ){
+
+		close( fd );
+		return NULL;
+	}
+
+	void *p = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( p == MAP_FAILED ) throw BadSourcePath();
+	return static_cast< const char * >( p );
+}
+
+
+class MemoryBuffer : public std::streambuf {
+//stream buffer over a block of memory, so the binary reader can read a mapped file in place
+
+	public:
+		MemoryBuffer( const char *begin, size_t size ){
+
+			char *b = const_cast< char * >( begin );
+			setg( b, b, b + size );
+		}
+
+	protected:
+		pos_type seekoff( off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which ){
+
+			char *target = ( dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr() ) + off;
+			if ( target < eback() or target > egptr() ) return pos_type( off_type( -1 ) );
+			setg( eback(), target, egptr() );
+			return pos_type( target - eback() );
+		}
+		pos_type seekpos( pos_type pos, std::ios_base::openmode which ){
+
+			return seekoff( off_type( pos ), std::ios_base::beg, which );
+		}
+};
+
+
+MappedTrajectory::MappedTrajectory( const std::string &trajectoryFilename, const std::string &indexFilename ){
+
+	_trajectory = mapFile( trajectoryFilename, _trajectorySize );
+	_index = mapFile( indexFilename, _indexSize );
+
+	if ( _indexSize < indexHeaderSize or memcmp( _index, indexMagic, sizeof( indexMagic ) - 1 ) != 0 or (unsigned char) _index[ sizeof( indexMagic ) - 1 ] != indexVersion ) throw BadTrajectoryFile();
+	_binary = ( _index[ sizeof( indexMagic ) ] == 1 );
+	_dataStart = getUint64( _index + sizeof( indexMagic ) + 1 );
+	uint64_t indexedSize = getUint64( _index + sizeof( indexMagic ) + 9 );
+	_entries = getUint64( _index + sizeof( indexMagic ) + 17 );
+
+	//the index has to describe this trajectory file, or offsets into it would read past the end
+	if ( _indexSize != indexHeaderSize + _entries * indexEntrySize or indexedSize != _trajectorySize ) throw BadTrajectoryFile();
+	for ( uint64_t k = 0; k < _entries; k++ ){
+
+		IndexEntry e = entry( k );
+		if ( e.offset + e.length > _trajectorySize ) throw BadTrajectoryFile();
+	}
+}
+
+
+MappedTrajectory::~MappedTrajectory(){
+
+	if ( _trajectory != NULL ) munmap( const_cast< char * >( _trajectory ), _trajectorySize );
+	if ( _index != NULL ) munmap( const_cast< char * >( _index ), _indexSize );
+}
+
+
+IndexEntry MappedTrajectory::entry( uint64_t k ) const {
+//the k-th simulation in the file
+
+	const char *p = _index + indexHeaderSize + k * indexEntrySize;
+	IndexEntry e;
+	e.simulation = getUint64( p );
+	e.offset = getUint64( p + 8 );
+	e.length = getUint64( p + 16 );
+	e.transitions = getUint64( p + 24 );
+	uint64_t timeBits = getUint64( p + 32 );
+	memcpy( &e.finalTime, &timeBits, sizeof( timeBits ) );
+	return e;
+}
+
+
+void MappedTrajectory::writeHeader( std::ostream &out ) const {
+//the part of the file before any simulation, which a binary file needs to be read
+
+	out.write( _trajectory, _dataStart );
+}
+
+
+void MappedTrajectory::writeSimulation( uint64_t k, std::ostream &out ) const {
+
+	IndexEntry e = entry( k );
+	out.write( _trajectory + e.offset, e.length );
+}
+
+
+static const char *lineWithTimeAtLeast( const char *first, const char *last, double time ){
+//first line in [first, last) at or after the given time.  lines in a simulation are in time order, so binary search on them
+
+	while ( first < last ){
+
+		//find the start of the line the midpoint is in
+		const char *mid = first + ( last - first ) / 2;
+		while ( mid > first and *( mid - 1 ) != '\n' ) mid--;
+
+		const char *next = static_cast< const char * >( memchr( mid, '\n', last - mid ) );
+		next = ( next == NULL ) ? last : next + 1;
+
+		if ( strtod( mid, NULL ) < time ) first = next;
+		else last = mid;
+	}
+	return first;
+}
+
+
+void MappedTrajectory::writeWindow( uint64_t k, double from, double to, std::ostream &out ) const {
+//the k-th simulation with only the transitions from time from to time to
+
+	IndexEntry e = entry( k );
+	if ( not _binary ){
+
+		//keep the >======= line
+		const char *begin = _trajectory + e.offset, *end = begin + e.length;
+		const char *firstLine = static_cast< const char * >( memchr( begin, '\n', e.length ) );
+		firstLine = ( firstLine == NULL ) ? end : firstLine + 1;
+		out.write( begin, firstLine - begin );
+
+		const char *windowStart = lineWithTimeAtLeast( firstLine, end, from );
+		const char *windowEnd = lineWithTimeAtLeast( windowStart, end, std::nextafter( to, HUGE_VAL ) );
+		out.write( windowStart, windowEnd - windowStart );
+		return;
+	}
+
+	//binary records have variable lengths, so read through the simulation and write back the ones in the window
+	MemoryBuffer buffer( _trajectory, _trajectorySize );
+	std::istream in( &buffer );
+	BinaryReader reader( in );
+	in.seekg( e.offset );
+
+	BinaryRecord record;
+	uint64_t lastTime = 0;
+	while ( (uint64_t) in.tellg() < e.offset + e.length and reader.next( record ) ){
+
+		if ( record.simulationStart or ( from <= record.time and record.time <= to ) ) writeBinaryRecord( out, record, lastTime );
+		else if ( record.time > to ) break;
+	}
+}
@@ -0,0 +1,61 @@
+//----------------------------------------------------------
+// Copyright 2017-2020 University of Oxford
+// Written by Michael A. Boemo (mb915@cam.ac.uk)
+// This software is licensed under GPL-2.0.  You should have
+// received a copy of the license with this software.  If
+// not, please Email the author.
+//----------------------------------------------------------
+
+#ifndef TRAJECTORY_INDEX_H
+#define TRAJECTORY_INDEX_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+//a sidecar index (bcs --index) has one fixed-size entry for each simulation in a trajectory file, in the order they appear in it,
+//so that simulation k is found by reading entry k.  the layout, with every number little-endian, is:
+// - "BCSIDX", a version byte, and a byte that is 1 if the trajectory is binary (--format bin) and 0 if it's text
+// - uint64: bytes at the start of the trajectory before the first simulation (the binary header; 0 for text)
+// - uint64: length of the trajectory file in bytes, to check that the index goes with it
+// - uint64: number of entries
+// - each entry: uint64 simulation index (the one its random stream is seeded from), uint64 byte offset of its first byte
+//   (the >======= line or binary marker), uint64 length in bytes, uint64 transitions taken, double time of the last transition
+static const char indexMagic[] = "BCSIDX";
+static const unsigned char indexVersion = 1;
+
+
+struct IndexEntry{
+
+	uint64_t simulation = 0, offset = 0, length = 0, transitions = 0;
+	double finalTime = 0.0;
+};
+
+
+void writeIndex( const std::string &, bool, uint64_t, uint64_t, const std::vector< IndexEntry > & );
+
+
+class MappedTrajectory{
+//a trajectory file and its index, memory mapped so that any simulation can be read without touching the rest of the file
+
+	private:
+		const char *_trajectory = NULL, *_index = NULL;
+		size_t _trajectorySize = 0, _indexSize = 0;
+		bool _binary = false;
+		uint64_t _dataStart = 0, _entries = 0;
+
+	public:
+		MappedTrajectory( const std::string &, const std::string & );
+		~MappedTrajectory();
+		MappedTrajectory( const MappedTrajectory & ) = delete;
+		MappedTrajectory &operator=( const MappedTrajectory & ) = delete;
+		bool isBinary( void ) const { return _binary; }
+		uint64_t size( void ) const { return _entries; }
+		IndexEntry entry( uint64_t ) const;
+		void writeHeader( std::ostream & ) const;
+		void writeSimulation( uint64_t, std::ostream & ) const;
+		void writeWindow( uint64_t, double, double, std::ostream & ) const;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#----------------------------------------------------------
+# Copyright 2017-2020 University of Oxford
+# Written by Michael A. Boemo (mb915@cam.ac.uk)
+# This software is licensed under GPL-2.0.  You should have
+# received a copy of the license with this software.  If
+# not, please Email the author.
+#----------------------------------------------------------
+
+#Reader for binary bcs trajectory files (bcs --format bin, .simulation.bcsb).  Import it and loop over simulations:
+#
+#	from bcs_binary import read_simulations
+#	for simulation in read_simulations('out.simulation.bcsb'):
+#		for time, name, process, parameters in simulation:
+#			...
+#
+#where name is the action or channel name and parameters is a dictionary from parameter name to value, as in the text format.
+#The file is read a block at a time, so only one simulation is held in memory however large the file is.
+#Run as a script, it prints the file in the text format.  See src/binary.h for the layout of the file.
+
+import struct
+import sys
+
+BIN_UNSET = 0
+BIN_INT = 1
+BIN_DOUBLE = 2
+
+CHUNK_SIZE = 1 << 20
+
+
+class BinaryTrajectory:
+
+	def __init__(self, filename):
+
+		self.file = open(filename, 'rb')
+		self.data = b''
+		self.pos = 0
+
+		if self.fill(7) < 7 or self.data[0:6] != b'BCSBIN' or self.data[6] != 1:
+			self.file.close()
+			raise ValueError('Not a bcs binary trajectory file: ' + filename)
+		self.pos = 7
+
+		self.actions = self.read_strings()
+		self.channels = self.read_strings()
+		self.parameters = self.read_strings()
+		self.processes = []
+		self.process_parameters = []
+		for i in range(self.read_varint()):
+			self.processes.append(self.read_string())
+			self.process_parameters.append([self.parameters[self.read_varint()] for j in range(self.read_varint())])
+
+	def fill(self, n):
+		#makes sure n bytes from pos are in the buffer if the file has them, reading another block if not, and returns how many there are
+
+		available = len(self.data) - self.pos
+		if available < n:
+			self.data = self.data[self.pos:] + self.file.read(max(CHUNK_SIZE, n - available))
+			self.pos = 0
+			available = len(self.data)
+		return min(available, n)
+
+	def need(self, n):
+
+		if self.fill(n) < n:
+			raise ValueError('Binary trajectory file ends partway through a record')
+
+	def read_varint(self):
+
+		#a varint is at most 10 bytes, but the last one in the file can be shorter
+		self.fill(10)
+		data = self.data
+		value = 0
+		shift = 0
+		while True:
+			if self.pos >= len(data):
+				raise ValueError('Binary trajectory file ends partway through a record')
+			byte = data[self.pos]
+			self.pos += 1
+			value |= (byte & 0x7f) << shift
+			if byte < 0x80:
+				return value
+			shift += 7
+
+	def read_string(self):
+
+		length = self.read_varint()
+		self.need(length)
+		s = self.data[self.pos:self.pos + length].decode()
+		self.pos += length
+		return s
+
+	def read_strings(self):
+
+		return [self.read_string() for i in range(self.read_varint())]
+
+	def records(self):
+		#yields None at the start of each simulation, then (time, name, process, parameters) for each transition
+
+		last_time = 0
+		while self.fill(1) > 0:
+
+			code = self.read_varint()
+			if code == 0:
+				last_time = 0
+				yield None
+				continue
+
+			code -= 1
+			name = (self.channels if code & 1 else self.actions)[code >> 1]
+			process = self.read_varint()
+
+			delta = self.read_varint()
+			last_time = (last_time + ((delta >> 1) ^ -(delta & 1))) & 0xffffffffffffffff
+			time = struct.unpack('<d', struct.pack('<Q', last_time))[0]
+
+			parameters = {}
+			for parameter in self.process_parameters[process]:
+				self.need(1)
+				kind = self.data[self.pos]
+				self.pos += 1
+				if kind == BIN_INT:
+					v = self.read_varint()
+					parameters[parameter] = (v >> 1) ^ -(v & 1)
+				elif kind == BIN_DOUBLE:
+					self.need(8)
+					parameters[parameter] = struct.unpack_from('<d', self.data, self.pos)[0]
+					self.pos += 8
+			yield (time, name, self.processes[process], parameters)
+		self.file.close()
+
+
+def read_simulations(filename):
+	#yields each simulation in the file as a list of (time, name, process, parameters) tuples
+
+	simulation = None
+	for record in BinaryTrajectory(filename).records():
+		if record is None:
+			if simulation is not None:
+				yield simulation
+			simulation = []
+		else:
+			simulation.append(record)
+	if simulation is not None:
+		yield simulation
+
+
+if __name__ == '__main__':
+
+	if len(sys.argv) != 2:
+		sys.exit('usage: python bcs_binary.py out.simulation.bcsb')
+
+	for simulation in read_simulations(sys.argv[1]):
+		print('>=======')
+		for time, name, process, parameters in simulation:
+			values = ''.join('\t%s\t' % p + ('%g' % v if isinstance(v, float) else str(v)) for p, v in parameters.items())
+			print('%g\t%s\t%s' % (time, name, process) + values)
@@ -21,13 +21,35 @@ parser.add_argument('-p', metavar='process',nargs='+',required=True,help="Proces
 parser.add_argument('-i', metavar='parameter',nargs=1,required=True,help="Parameter name to track")
 parser.add_argument('-o', metavar='output',nargs=1,required=True,help="Output plot filename (use .png or .pdf extension)")
 parser.add_argument('-m', metavar='maxSimulation',nargs=1,help="Maximum number of simulations to plot")
-parser.add_argument('filename',help="Output .simulation.bcs file from bcs.")
+parser.add_argument('filename',help="Output .simulation.bcs (or binary .simulation.bcsb) file from bcs.")
 args = parser.parse_args(sys.argv[1:])
 argDict = vars(args)
 
 
+#FUNCTIONS--------------------------------------------------------------------------------------------
+def read_text(filename):
+	#yields None at the start of each simulation, then (time, action, process, parameters) for each line
+
+	for line in open(filename):
+
+		if line[0] == '>':
+			yield None
+			continue
+
+		splitLine = line.rstrip().split()
+		parameters = {}
+		for i, entry in enumerate(splitLine[3:]):
+			if i%2 == 1:
+				parameters[splitLine[3:][i-1]] = float(entry)
+		yield (float(splitLine[0]), splitLine[1], splitLine[2], parameters)
+
+
 #MAIN-------------------------------------------------------------------------------------------------
-f = open(argDict['filename'])
+if argDict['filename'].endswith('.bcsb'):
+	from bcs_binary import BinaryTrajectory
+	records = BinaryTrajectory(argDict['filename']).records()
+else:
+	records = read_text(argDict['filename'])
 plt.figure()
 simCount = 0
 
@@ -36,9 +58,9 @@ process2y = {}
 x = []
 y = []
 
-for line in f:
+for record in records:
 
-	if line[0] == '>':
+	if record is None:
 
 		#do the plotting
 		if simCount > 0:
@@ -53,16 +75,7 @@ for line in f:
 		simCount += 1
 		continue
 
-	#parse the line
-	splitLine = line.rstrip().split()
-	time = float(splitLine[0])
-	action = splitLine[1]
-	process = splitLine[2]
-	if len(splitLine) > 3:	
-		parameters = {}
-		for i, entry in enumerate(splitLine[3:]):
-			if i%2 == 1:
-				parameters[splitLine[3:][i-1]] = float(entry)
+	time, action, process, parameters = record
 
 	if action in argDict['a'] and process in argDict['p'] and argDict['i'][0] in parameters:
 		if process in process2y: